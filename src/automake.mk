@@ -20,7 +20,7 @@ src_libpspp_core_la_LIBADD = \
 	src/data/libdata.la \
 	src/libpspp/liblibpspp.la \
 	$(LIBXML2_LIBS) $(PG_LIBS) \
-	gl/libgl.la
+	gl/libgl.la $(LTLIBMULTITHREAD)
 
 src_libpspp_la_SOURCES = 
 
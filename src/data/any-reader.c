@@ -47,6 +47,7 @@ static const struct any_reader_class *classes[] =
     &sys_file_reader_class,
     &por_file_reader_class,
     &pcp_file_reader_class,
+    &arrow_file_reader_class,
   };
 enum { N_CLASSES = sizeof classes / sizeof *classes };
 
@@ -53,6 +53,7 @@ struct any_reader_class
 extern const struct any_reader_class sys_file_reader_class;
 extern const struct any_reader_class por_file_reader_class;
 extern const struct any_reader_class pcp_file_reader_class;
+extern const struct any_reader_class arrow_file_reader_class;
 
 enum any_type
   {
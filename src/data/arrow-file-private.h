@@ -0,0 +1,200 @@
+/* PSPP - a program for statistical analysis.
+   Copyright (C) 2017 Free Software Foundation, Inc.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+/* Infrastructure common to Apache Arrow IPC file reader and writer.
+
+   An Arrow IPC file (also known as a Feather version 2 file) is a columnar
+   format: the file holds a schema followed by a sequence of "record
+   batches", each of which contains a number of rows stored column by
+   column.  The schema and the metadata for each batch are encoded as
+   flatbuffers, using the table and field numbers below, which are taken
+   from Arrow's Schema.fbs, Message.fbs, and File.fbs.
+
+   PSPP writes numeric variables as 64-bit floating-point columns, string
+   variables as fixed-size binary columns in the dictionary encoding, and,
+   optionally, labelled variables as dictionary-encoded UTF-8 columns.
+   System-missing values are written as nulls.  The message for each record
+   batch also records the range of the values in each numeric column, so
+   that a reader looking for particular values can skip whole batches
+   without reading them. */
+
+#ifndef DATA_ARROW_FILE_PRIVATE_H
+#define DATA_ARROW_FILE_PRIVATE_H 1
+
+/* Magic number at the beginning and end of an Arrow file. */
+#define ARROW_MAGIC "ARROW1"
+#define ARROW_MAGIC_LEN 6
+
+/* Marks the beginning of an encapsulated message. */
+#define ARROW_CONTINUATION 0xffffffff
+
+/* MetadataVersion. */
+#define ARROW_METADATA_V5 4
+
+/* MessageHeader union types. */
+enum
+  {
+    ARROW_HEADER_SCHEMA = 1,
+    ARROW_HEADER_DICTIONARY_BATCH = 2,
+    ARROW_HEADER_RECORD_BATCH = 3
+  };
+
+/* Type union types.  Types not listed here are nested types, which have
+   child fields, or "view" types, which have a variable number of buffers. */
+enum
+  {
+    ARROW_TYPE_NULL = 1,
+    ARROW_TYPE_INT = 2,
+    ARROW_TYPE_FLOATING_POINT = 3,
+    ARROW_TYPE_BINARY = 4,
+    ARROW_TYPE_UTF8 = 5,
+    ARROW_TYPE_BOOL = 6,
+    ARROW_TYPE_DECIMAL = 7,
+    ARROW_TYPE_DATE = 8,
+    ARROW_TYPE_TIME = 9,
+    ARROW_TYPE_TIMESTAMP = 10,
+    ARROW_TYPE_INTERVAL = 11,
+    ARROW_TYPE_FIXED_SIZE_BINARY = 15,
+    ARROW_TYPE_DURATION = 18,
+    ARROW_TYPE_LARGE_BINARY = 19,
+    ARROW_TYPE_LARGE_UTF8 = 20
+  };
+
+/* FloatingPoint precision. */
+#define ARROW_PRECISION_HALF 0
+#define ARROW_PRECISION_SINGLE 1
+#define ARROW_PRECISION_DOUBLE 2
+
+/* Schema endianness. */
+#define ARROW_ENDIANNESS_LITTLE 0
+
+/* Fields in table Message. */
+enum
+  {
+    ARROW_MESSAGE_VERSION,
+    ARROW_MESSAGE_HEADER_TYPE,
+    ARROW_MESSAGE_HEADER,
+    ARROW_MESSAGE_BODY_LENGTH,
+    ARROW_MESSAGE_CUSTOM_METADATA,
+    ARROW_MESSAGE_N_FIELDS
+  };
+
+/* Fields in table Schema. */
+enum
+  {
+    ARROW_SCHEMA_ENDIANNESS,
+    ARROW_SCHEMA_FIELDS,
+    ARROW_SCHEMA_CUSTOM_METADATA,
+    ARROW_SCHEMA_N_FIELDS
+  };
+
+/* Fields in table Field. */
+enum
+  {
+    ARROW_FIELD_NAME,
+    ARROW_FIELD_NULLABLE,
+    ARROW_FIELD_TYPE_TYPE,
+    ARROW_FIELD_TYPE,
+    ARROW_FIELD_DICTIONARY,
+    ARROW_FIELD_CHILDREN,
+    ARROW_FIELD_CUSTOM_METADATA,
+    ARROW_FIELD_N_FIELDS
+  };
+
+/* Fields in table KeyValue. */
+enum
+  {
+    ARROW_KEY_VALUE_KEY,
+    ARROW_KEY_VALUE_VALUE,
+    ARROW_KEY_VALUE_N_FIELDS
+  };
+
+/* Fields in table Int. */
+enum
+  {
+    ARROW_INT_BIT_WIDTH,
+    ARROW_INT_IS_SIGNED,
+    ARROW_INT_N_FIELDS
+  };
+
+/* Fields in table FloatingPoint. */
+enum
+  {
+    ARROW_FLOATING_POINT_PRECISION,
+    ARROW_FLOATING_POINT_N_FIELDS
+  };
+
+/* Fields in table FixedSizeBinary. */
+enum
+  {
+    ARROW_FIXED_SIZE_BINARY_BYTE_WIDTH,
+    ARROW_FIXED_SIZE_BINARY_N_FIELDS
+  };
+
+/* Fields in table DictionaryEncoding. */
+enum
+  {
+    ARROW_DICTIONARY_ENCODING_ID,
+    ARROW_DICTIONARY_ENCODING_INDEX_TYPE,
+    ARROW_DICTIONARY_ENCODING_IS_ORDERED,
+    ARROW_DICTIONARY_ENCODING_N_FIELDS
+  };
+
+/* Fields in table RecordBatch.  The FieldNode and Buffer structs in the
+   "nodes" and "buffers" vectors are each two 64-bit integers. */
+enum
+  {
+    ARROW_RECORD_BATCH_LENGTH,
+    ARROW_RECORD_BATCH_NODES,
+    ARROW_RECORD_BATCH_BUFFERS,
+    ARROW_RECORD_BATCH_COMPRESSION,
+    ARROW_RECORD_BATCH_N_FIELDS
+  };
+
+/* Fields in table DictionaryBatch. */
+enum
+  {
+    ARROW_DICTIONARY_BATCH_ID,
+    ARROW_DICTIONARY_BATCH_DATA,
+    ARROW_DICTIONARY_BATCH_IS_DELTA,
+    ARROW_DICTIONARY_BATCH_N_FIELDS
+  };
+
+/* Fields in table Footer.  Each Block struct in the "dictionaries" and
+   "recordBatches" vectors is 24 bytes: a 64-bit file offset, a 32-bit
+   metadata length, 4 bytes of padding, and a 64-bit body length. */
+enum
+  {
+    ARROW_FOOTER_VERSION,
+    ARROW_FOOTER_SCHEMA,
+    ARROW_FOOTER_DICTIONARIES,
+    ARROW_FOOTER_RECORD_BATCHES,
+    ARROW_FOOTER_CUSTOM_METADATA,
+    ARROW_FOOTER_N_FIELDS
+  };
+#define ARROW_BLOCK_SIZE 24
+
+/* Keys for PSPP-specific custom metadata. */
+#define ARROW_KEY_ENCODING "PSPP:encoding" /* Schema: string encoding. */
+#define ARROW_KEY_FORMAT "PSPP:format"     /* Field: print format. */
+#define ARROW_KEY_LABEL "PSPP:label"       /* Field: variable label. */
+
+/* Message custom metadata for a record batch: one space-separated
+   "MIN:MAX" pair per column, giving the range of the non-null values in
+   the column within the batch, or "-" if the range is not known. */
+#define ARROW_KEY_RANGE "PSPP:range"
+
+#endif /* data/arrow-file-private.h */
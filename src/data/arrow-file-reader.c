@@ -0,0 +1,1565 @@
+/* PSPP - a program for statistical analysis.
+   Copyright (C) 2017 Free Software Foundation, Inc.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+#include <config.h>
+
+#include "data/arrow-file-reader.h"
+#include "data/arrow-file-private.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "data/any-reader.h"
+#include "data/case.h"
+#include "data/casereader-provider.h"
+#include "data/casereader.h"
+#include "data/dictionary.h"
+#include "data/file-handle-def.h"
+#include "data/file-name.h"
+#include "data/format.h"
+#include "data/identifier.h"
+#include "data/value.h"
+#include "data/variable.h"
+#include "libpspp/assertion.h"
+#include "libpspp/cast.h"
+#include "libpspp/flatbuffers.h"
+#include "libpspp/float-format.h"
+#include "libpspp/i18n.h"
+#include "libpspp/integer-format.h"
+#include "libpspp/message.h"
+#include "libpspp/misc.h"
+#include "libpspp/pool.h"
+#include "libpspp/str.h"
+
+#include "gl/c-strtod.h"
+#include "gl/minmax.h"
+#include "gl/unlocked-io.h"
+#include "gl/xalloc.h"
+
+#include "gettext.h"
+#define _(msgid) gettext (msgid)
+#define N_(msgid) (msgid)
+
+/* How an Arrow column is converted to a PSPP variable. */
+enum arrow_kind
+  {
+    ARROW_SKIP,                 /* Unsupported type, ignored. */
+    ARROW_INT,                  /* Integer, as numeric variable. */
+    ARROW_FLOAT,                /* Floating-point, as numeric variable. */
+    ARROW_BOOL,                 /* Boolean, as numeric variable 0 or 1. */
+    ARROW_FIXED,                /* Fixed-size binary, as string variable. */
+    ARROW_VARIABLE,             /* Variable-length binary or UTF-8 string. */
+    ARROW_DICT                  /* Dictionary-encoded binary or UTF-8. */
+  };
+
+/* A column in an Arrow file. */
+struct arrow_column
+  {
+    const char *name;           /* Field name, in UTF-8. */
+    enum arrow_kind kind;
+    size_t value_size;          /* Bytes per integer, float, offset, index. */
+    bool is_signed;             /* ARROW_INT, ARROW_DICT: signed integers? */
+    bool is_utf8;               /* ARROW_VARIABLE, ARROW_DICT: UTF-8 data? */
+    int width;                  /* Variable width, 0 for numeric. */
+    const char *format;         /* Print format from metadata, or NULL. */
+    const char *label;          /* Variable label from metadata, or NULL. */
+    int case_index;             /* Index into case, -1 if ARROW_SKIP. */
+
+    /* Position in record batches. */
+    size_t node;                /* Index of the column's FieldNode. */
+    size_t buffer;              /* Index of the column's first Buffer. */
+    size_t n_buffers;           /* Number of Buffers for the column. */
+
+    /* Dictionary, for ARROW_DICT. */
+    int64_t dict_id;            /* Dictionary ID. */
+    size_t dict_offset_size;    /* Size of offsets in dictionary batches. */
+    struct substring *strings;  /* Dictionary values. */
+    size_t n_strings, allocated_strings;
+
+    /* Selection. */
+    bool needed;                /* Read this column's data? */
+    bool has_range;             /* Only read cases with value in range? */
+    double low, high;           /* Range, if 'has_range'. */
+
+    /* Column's data in the current record batch. */
+    uint8_t *buf;               /* Column's buffers, as read from file. */
+    size_t allocated;           /* Number of bytes allocated for 'buf'. */
+    const uint8_t *validity;    /* Bitmap of non-null values, or NULL. */
+    const uint8_t *values;      /* Values, offsets, or dictionary indexes. */
+    const uint8_t *data;        /* ARROW_VARIABLE: string data. */
+    size_t data_size;           /* ARROW_VARIABLE: bytes in 'data'. */
+  };
+
+/* The location of a message within an Arrow file. */
+struct arrow_block
+  {
+    off_t offset;               /* Offset of message from start of file. */
+    size_t metadata_len;        /* Length of metadata, including prefix. */
+    off_t body_len;             /* Length of message body. */
+  };
+
+/* Arrow file reader. */
+struct arrow_reader
+  {
+    struct any_reader any_reader;
+    struct pool *pool;          /* All the reader's allocations. */
+
+    /* File state. */
+    struct file_handle *fh;     /* File handle. */
+    struct fh_lock *lock;       /* Mutual exclusion for file handle. */
+    FILE *file;                 /* File stream. */
+    off_t file_size;            /* Size of file in bytes. */
+    bool error;                 /* Error reading file? */
+
+    /* Metadata. */
+    const char *file_encoding;  /* Encoding from file's metadata, or NULL. */
+    const char *encoding;       /* Dictionary encoding, once decoded. */
+    struct caseproto *proto;    /* Format of output cases. */
+    struct arrow_column *columns;
+    size_t n_columns;
+    size_t n_nodes;             /* Number of FieldNodes in a record batch. */
+    size_t n_buffers;           /* Number of Buffers in a record batch. */
+    struct arrow_block *batches;
+    size_t n_batches;
+    casenumber n_cases;         /* Total rows in all record batches. */
+    bool has_ranges;            /* Any column with 'has_range' true? */
+
+    /* Most recently read message metadata. */
+    uint8_t *metadata;
+    size_t allocated_metadata;
+
+    /* Current record batch. */
+    size_t batch_idx;           /* Index of next record batch to read. */
+    size_t n_rows;              /* Number of rows in current batch. */
+    size_t row;                 /* Next row to read in current batch. */
+  };
+
+static struct arrow_reader *
+arrow_reader_cast (const struct any_reader *r_)
+{
+  assert (r_->klass == &arrow_file_reader_class);
+  return UP_CAST (r_, struct arrow_reader, any_reader);
+}
+
+static const struct casereader_class arrow_file_casereader_class;
+
+static bool arrow_close (struct any_reader *);
+static bool read_footer (struct arrow_reader *);
+static bool read_dictionary (struct arrow_reader *,
+                             const struct arrow_block *);
+static bool scan_batch (struct arrow_reader *, const struct arrow_block *);
+
+static void arrow_msg (struct arrow_reader *, off_t, int class,
+                       const char *format, va_list)
+  PRINTF_FORMAT (4, 0);
+static void arrow_warn (struct arrow_reader *, off_t, const char *, ...)
+  PRINTF_FORMAT (3, 4);
+static void arrow_error (struct arrow_reader *, off_t, const char *, ...)
+  PRINTF_FORMAT (3, 4);
+
+static bool read_bytes (struct arrow_reader *, off_t, void *, size_t);
+
+/* Returns true if FILE is an Arrow file, false if not, or a negative errno
+   value if there is an error reading FILE. */
+static int
+arrow_detect (FILE *file)
+{
+  static const char magic[ARROW_MAGIC_LEN] = ARROW_MAGIC;
+  char buf[ARROW_MAGIC_LEN];
+
+  if (fseek (file, 0, SEEK_SET))
+    return -errno;
+
+  if (fread (buf, sizeof buf, 1, file) != 1)
+    return ferror (file) ? -errno : 0;
+
+  return !memcmp (buf, magic, sizeof buf);
+}
+
+/* Opens the Arrow file designated by file handle FH for reading.  Reads the
+   file's schema and dictionaries.  Returns the new reader if successful,
+   otherwise a null pointer. */
+static struct any_reader *
+arrow_open (struct file_handle *fh)
+{
+  struct arrow_reader *r;
+
+  /* Create and initialize reader. */
+  r = xzalloc (sizeof *r);
+  r->any_reader.klass = &arrow_file_reader_class;
+  r->pool = pool_create ();
+  pool_register (r->pool, free, r);
+  r->fh = fh_ref (fh);
+
+  /* TRANSLATORS: this fragment will be interpolated into
+     messages in fh_lock() that identify types of files. */
+  r->lock = fh_lock (fh, FH_REF_FILE, N_("Arrow file"), FH_ACC_READ, false);
+  if (r->lock == NULL)
+    goto error;
+
+  /* Open file. */
+  r->file = fn_open (fh, "rb");
+  if (r->file == NULL)
+    {
+      msg (ME, _("Error opening `%s' for reading as an Arrow file: %s."),
+           fh_get_file_name (r->fh), strerror (errno));
+      goto error;
+    }
+
+  /* Fetch file size. */
+  if (fseeko (r->file, 0, SEEK_END) || (r->file_size = ftello (r->file)) < 0)
+    {
+      arrow_error (r, -1, _("Seek failed (%s)."), strerror (errno));
+      goto error;
+    }
+
+  if (!read_footer (r))
+    goto error;
+
+  return &r->any_reader;
+
+error:
+  arrow_close (&r->any_reader);
+  return NULL;
+}
+
+/* Closes R, which should have been returned by arrow_open() but not already
+   closed with arrow_decode() or this function.
+   Returns true if successful, false if an I/O error has occurred on R. */
+static bool
+arrow_close (struct any_reader *r_)
+{
+  struct arrow_reader *r = arrow_reader_cast (r_);
+  bool error;
+  size_t i;
+
+  if (r->file)
+    {
+      if (fn_close (r->fh, r->file) == EOF)
+        {
+          msg (ME, _("Error closing Arrow file `%s': %s."),
+               fh_get_file_name (r->fh), strerror (errno));
+          r->error = true;
+        }
+      r->file = NULL;
+    }
+
+  for (i = 0; i < r->n_columns; i++)
+    free (r->columns[i].buf);
+  free (r->metadata);
+
+  fh_unlock (r->lock);
+  fh_unref (r->fh);
+
+  error = r->error;
+  pool_destroy (r->pool);
+
+  return !error;
+}
+
+/* Messages. */
+
+/* Emits a message of the given CLASS about R, for file offset OFFSET, or for
+   the file as a whole if OFFSET is negative. */
+static void
+arrow_msg (struct arrow_reader *r, off_t offset,
+           int class, const char *format, va_list args)
+{
+  struct msg m;
+  struct string text;
+
+  ds_init_empty (&text);
+  if (offset >= 0)
+    ds_put_format (&text, _("`%s' near offset 0x%llx: "),
+                   fh_get_file_name (r->fh), (long long int) offset);
+  else
+    ds_put_format (&text, _("`%s': "), fh_get_file_name (r->fh));
+  ds_put_vformat (&text, format, args);
+
+  m.category = msg_class_to_category (class);
+  m.severity = msg_class_to_severity (class);
+  m.file_name = NULL;
+  m.first_line = 0;
+  m.last_line = 0;
+  m.first_column = 0;
+  m.last_column = 0;
+  m.text = ds_cstr (&text);
+
+  msg_emit (&m);
+}
+
+/* Displays a warning for offset OFFSET in the file. */
+static void
+arrow_warn (struct arrow_reader *r, off_t offset, const char *format, ...)
+{
+  va_list args;
+
+  va_start (args, format);
+  arrow_msg (r, offset, MW, format, args);
+  va_end (args);
+}
+
+/* Displays an error for offset OFFSET in the file and marks R as being in an
+   error state. */
+static void
+arrow_error (struct arrow_reader *r, off_t offset, const char *format, ...)
+{
+  va_list args;
+
+  va_start (args, format);
+  arrow_msg (r, offset, ME, format, args);
+  va_end (args);
+
+  r->error = true;
+}
+
+/* Low-level file access. */
+
+/* Reads SIZE bytes at offset OFFSET in R's file into BUF.  Returns true if
+   successful, otherwise reports an error and returns false. */
+static bool
+read_bytes (struct arrow_reader *r, off_t offset, void *buf, size_t size)
+{
+  if (offset < 0 || offset > r->file_size
+      || size > r->file_size - offset)
+    {
+      arrow_error (r, offset, _("Data extends beyond end of file."));
+      return false;
+    }
+  else if (fseeko (r->file, offset, SEEK_SET))
+    {
+      arrow_error (r, offset, _("Seek failed (%s)."), strerror (errno));
+      return false;
+    }
+  else if (fread (buf, 1, size, r->file) != size)
+    {
+      if (ferror (r->file))
+        arrow_error (r, offset, _("System error: %s."), strerror (errno));
+      else
+        arrow_error (r, offset, _("Unexpected end of file."));
+      return false;
+    }
+  return true;
+}
+
+/* Reads the metadata of the message at BLOCK in R's file, and initializes
+   *HEADER as its header, which must have type HEADER_TYPE.  If MESSAGE is
+   nonnull, also initializes it as the message table.  The data for both
+   tables is only valid until the next message is read.  Returns true if
+   successful, otherwise reports an error and returns false. */
+static bool
+read_message (struct arrow_reader *r, const struct arrow_block *block,
+              int header_type, struct fb_table *header,
+              struct fb_table *message_)
+{
+  struct fb_table message;
+  size_t prefix;
+
+  if (block->metadata_len < 8)
+    {
+      arrow_error (r, block->offset, _("Message metadata is too short."));
+      return false;
+    }
+  if (block->metadata_len > r->allocated_metadata)
+    {
+      free (r->metadata);
+      r->metadata = xmalloc (block->metadata_len);
+      r->allocated_metadata = block->metadata_len;
+    }
+  if (!read_bytes (r, block->offset, r->metadata, block->metadata_len))
+    return false;
+
+  /* Files written by old versions of Arrow lack the continuation marker. */
+  prefix = (integer_get (INTEGER_LSB_FIRST, r->metadata, 4)
+            == ARROW_CONTINUATION ? 8 : 4);
+  if (!fb_get_root (r->metadata + prefix, block->metadata_len - prefix,
+                    &message)
+      || fb_get_u8 (&message, ARROW_MESSAGE_HEADER_TYPE, 0) != header_type
+      || !fb_get_table (&message, ARROW_MESSAGE_HEADER, header))
+    {
+      arrow_error (r, block->offset, _("Invalid message metadata."));
+      return false;
+    }
+
+  if (message_ != NULL)
+    *message_ = message;
+  return true;
+}
+
+/* Parses RecordBatch table BATCH from the message at BLOCK, which must have
+   at least N_NODES FieldNodes and N_BUFFERS Buffers.  Stores the number of
+   rows into *N_ROWS and the FieldNode and Buffer vectors into *NODES and
+   *BUFFERS.  Returns true if successful, otherwise reports an error and
+   returns false. */
+static bool
+parse_record_batch (struct arrow_reader *r, const struct arrow_block *block,
+                    const struct fb_table *batch, size_t n_nodes,
+                    size_t n_buffers, size_t *n_rows,
+                    struct fb_vector *nodes, struct fb_vector *buffers)
+{
+  int64_t length = fb_get_i64 (batch, ARROW_RECORD_BATCH_LENGTH, 0);
+
+  if (fb_has_field (batch, ARROW_RECORD_BATCH_COMPRESSION))
+    {
+      arrow_error (r, block->offset,
+                   _("Compressed record batches are not supported."));
+      return false;
+    }
+  if (length < 0 || length > SIZE_MAX / 8
+      || !fb_get_vector (batch, ARROW_RECORD_BATCH_NODES, 16, nodes)
+      || !fb_get_vector (batch, ARROW_RECORD_BATCH_BUFFERS, 16, buffers)
+      || nodes->n < n_nodes || buffers->n < n_buffers)
+    {
+      arrow_error (r, block->offset, _("Invalid record batch metadata."));
+      return false;
+    }
+
+  *n_rows = length;
+  return true;
+}
+
+/* Footer and schema. */
+
+static bool
+read_block_vector (struct arrow_reader *r, const struct fb_table *footer,
+                   int field, struct arrow_block **blocksp, size_t *np)
+{
+  struct fb_vector vector;
+  struct arrow_block *blocks;
+  size_t i;
+
+  if (!fb_get_vector (footer, field, ARROW_BLOCK_SIZE, &vector))
+    {
+      /* An absent vector is the same as an empty one. */
+      *blocksp = NULL;
+      *np = 0;
+      return !fb_has_field (footer, field);
+    }
+
+  blocks = pool_nmalloc (r->pool, vector.n, sizeof *blocks);
+  for (i = 0; i < vector.n; i++)
+    {
+      const uint8_t *p = fb_vector_at (&vector, i);
+      int64_t offset = integer_get (INTEGER_LSB_FIRST, p, 8);
+      int32_t metadata_len = integer_get (INTEGER_LSB_FIRST, p + 8, 4);
+      int64_t body_len = integer_get (INTEGER_LSB_FIRST, p + 16, 8);
+
+      if (offset < 0 || offset > r->file_size
+          || metadata_len < 0 || metadata_len > r->file_size - offset
+          || body_len < 0
+          || body_len > r->file_size - offset - metadata_len)
+        return false;
+
+      blocks[i].offset = offset;
+      blocks[i].metadata_len = metadata_len;
+      blocks[i].body_len = body_len;
+    }
+
+  *blocksp = blocks;
+  *np = vector.n;
+  return true;
+}
+
+/* Looks for KEY in the custom metadata vector FIELD in TABLE.  If it is
+   found, stores its value into *VALUE and *LENGTH and returns true,
+   otherwise returns false. */
+static bool
+find_custom_metadata (const struct fb_table *table, int field,
+                      const char *key, const char **value, size_t *length)
+{
+  struct fb_vector vector;
+  size_t i;
+
+  if (!fb_get_vector (table, field, 4, &vector))
+    return false;
+
+  for (i = 0; i < vector.n; i++)
+    {
+      struct fb_table kv;
+      const char *s;
+      size_t len;
+
+      if (fb_vector_get_table (&vector, i, &kv)
+          && fb_get_string (&kv, ARROW_KEY_VALUE_KEY, &s, &len)
+          && len == strlen (key) && !memcmp (s, key, len)
+          && fb_get_string (&kv, ARROW_KEY_VALUE_VALUE, value, length))
+        return true;
+    }
+  return false;
+}
+
+/* Looks for KEY in the custom metadata vector FIELD in TABLE.  If it is
+   found, returns its value as a null-terminated string allocated from R's
+   pool, otherwise returns a null pointer. */
+static const char *
+get_custom_metadata (struct arrow_reader *r, const struct fb_table *table,
+                     int field, const char *key)
+{
+  const char *s;
+  size_t len;
+
+  return (find_custom_metadata (table, field, key, &s, &len)
+          ? pool_strdup0 (r->pool, s, len)
+          : NULL);
+}
+
+/* Returns the number of buffers used by a column with type TYPE_TYPE, or -1
+   if this reader cannot handle the type. */
+static int
+type_n_buffers (int type_type)
+{
+  switch (type_type)
+    {
+    case ARROW_TYPE_NULL:
+      return 0;
+
+    case ARROW_TYPE_INT:
+    case ARROW_TYPE_FLOATING_POINT:
+    case ARROW_TYPE_BOOL:
+    case ARROW_TYPE_DECIMAL:
+    case ARROW_TYPE_DATE:
+    case ARROW_TYPE_TIME:
+    case ARROW_TYPE_TIMESTAMP:
+    case ARROW_TYPE_INTERVAL:
+    case ARROW_TYPE_FIXED_SIZE_BINARY:
+    case ARROW_TYPE_DURATION:
+      return 2;
+
+    case ARROW_TYPE_BINARY:
+    case ARROW_TYPE_UTF8:
+    case ARROW_TYPE_LARGE_BINARY:
+    case ARROW_TYPE_LARGE_UTF8:
+      return 3;
+
+    default:
+      return -1;
+    }
+}
+
+/* Returns true if TYPE_TYPE is a variable-length binary or string type,
+   storing the size of its offsets into *OFFSET_SIZE and whether it is a
+   UTF-8 string type into *IS_UTF8. */
+static bool
+type_is_variable (int type_type, size_t *offset_size, bool *is_utf8)
+{
+  switch (type_type)
+    {
+    case ARROW_TYPE_BINARY:
+    case ARROW_TYPE_UTF8:
+      *offset_size = 4;
+      *is_utf8 = type_type == ARROW_TYPE_UTF8;
+      return true;
+
+    case ARROW_TYPE_LARGE_BINARY:
+    case ARROW_TYPE_LARGE_UTF8:
+      *offset_size = 8;
+      *is_utf8 = type_type == ARROW_TYPE_LARGE_UTF8;
+      return true;
+
+    default:
+      return false;
+    }
+}
+
+/* Parses FIELD, the IDXth field in the schema of R, into COL.  Returns true
+   if successful, otherwise reports an error and returns false. */
+static bool
+parse_field (struct arrow_reader *r, const struct fb_table *field,
+             size_t idx, struct arrow_column *col)
+{
+  struct fb_table type, dictionary;
+  struct fb_vector children;
+  int type_type;
+  int n_buffers;
+  const char *s;
+  size_t len;
+
+  memset (col, 0, sizeof *col);
+  col->name = (fb_get_string (field, ARROW_FIELD_NAME, &s, &len)
+               ? pool_strdup0 (r->pool, s, len)
+               : "");
+  col->format = get_custom_metadata (r, field, ARROW_FIELD_CUSTOM_METADATA,
+                                     ARROW_KEY_FORMAT);
+  col->label = get_custom_metadata (r, field, ARROW_FIELD_CUSTOM_METADATA,
+                                    ARROW_KEY_LABEL);
+  col->case_index = -1;
+
+  type_type = fb_get_u8 (field, ARROW_FIELD_TYPE_TYPE, 0);
+  n_buffers = type_n_buffers (type_type);
+  if (n_buffers < 0
+      || (fb_get_vector (field, ARROW_FIELD_CHILDREN, 4, &children)
+          && children.n > 0))
+    {
+      arrow_error (r, -1, _("Column %zu (%s) has a nested or unsupported "
+                            "type (%d)."), idx + 1, col->name, type_type);
+      return false;
+    }
+  if (!fb_get_table (field, ARROW_FIELD_TYPE, &type))
+    memset (&type, 0, sizeof type);
+
+  col->node = r->n_nodes++;
+  col->buffer = r->n_buffers;
+
+  if (fb_get_table (field, ARROW_FIELD_DICTIONARY, &dictionary))
+    {
+      struct fb_table index_type;
+      int bit_width;
+
+      /* The column's data consists of a validity bitmap and indexes into
+         a dictionary. */
+      col->n_buffers = 2;
+      col->dict_id = fb_get_i64 (&dictionary, ARROW_DICTIONARY_ENCODING_ID, 0);
+      if (fb_get_table (&dictionary, ARROW_DICTIONARY_ENCODING_INDEX_TYPE,
+                        &index_type))
+        {
+          bit_width = fb_get_i32 (&index_type, ARROW_INT_BIT_WIDTH, 0);
+          col->is_signed = fb_get_bool (&index_type, ARROW_INT_IS_SIGNED,
+                                        false);
+        }
+      else
+        {
+          bit_width = 32;
+          col->is_signed = true;
+        }
+      col->value_size = bit_width / 8;
+
+      if (type_is_variable (type_type, &col->dict_offset_size,
+                            &col->is_utf8)
+          && (bit_width == 8 || bit_width == 16 || bit_width == 32
+              || bit_width == 64))
+        col->kind = ARROW_DICT;
+    }
+  else
+    {
+      col->n_buffers = n_buffers;
+      switch (type_type)
+        {
+        case ARROW_TYPE_INT:
+          col->value_size = fb_get_i32 (&type, ARROW_INT_BIT_WIDTH, 0) / 8;
+          col->is_signed = fb_get_bool (&type, ARROW_INT_IS_SIGNED, false);
+          if (col->value_size == 1 || col->value_size == 2
+              || col->value_size == 4 || col->value_size == 8)
+            col->kind = ARROW_INT;
+          break;
+
+        case ARROW_TYPE_FLOATING_POINT:
+          switch (fb_get_i16 (&type, ARROW_FLOATING_POINT_PRECISION, 0))
+            {
+            case ARROW_PRECISION_SINGLE:
+              col->kind = ARROW_FLOAT;
+              col->value_size = 4;
+              break;
+
+            case ARROW_PRECISION_DOUBLE:
+              col->kind = ARROW_FLOAT;
+              col->value_size = 8;
+              break;
+            }
+          break;
+
+        case ARROW_TYPE_BOOL:
+          col->kind = ARROW_BOOL;
+          break;
+
+        case ARROW_TYPE_FIXED_SIZE_BINARY:
+          col->width = fb_get_i32 (&type, ARROW_FIXED_SIZE_BINARY_BYTE_WIDTH,
+                                   0);
+          if (col->width > 0 && col->width <= MAX_STRING)
+            col->kind = ARROW_FIXED;
+          break;
+
+        default:
+          if (type_is_variable (type_type, &col->value_size, &col->is_utf8))
+            col->kind = ARROW_VARIABLE;
+          break;
+        }
+    }
+  r->n_buffers += col->n_buffers;
+
+  if (col->kind == ARROW_SKIP)
+    arrow_warn (r, -1, _("Ignoring column %zu (%s), which has a type that "
+                         "PSPP does not support (%d)."),
+                idx + 1, col->name, type_type);
+  return true;
+}
+
+/* Reads the footer at the end of R's file, then the schema, dictionaries,
+   and record batch metadata that it points to.  Returns true if successful,
+   otherwise reports an error and returns false. */
+static bool
+read_footer (struct arrow_reader *r)
+{
+  static const char magic[ARROW_MAGIC_LEN] = ARROW_MAGIC;
+  struct fb_table footer, schema;
+  struct arrow_block *dictionaries;
+  size_t n_dictionaries;
+  struct fb_vector fields;
+  uint8_t trailer[4 + ARROW_MAGIC_LEN];
+  uint8_t *data;
+  off_t footer_ofs;
+  uint32_t footer_len;
+  size_t i;
+
+  if (r->file_size < 2 * ARROW_MAGIC_LEN + 4
+      || !read_bytes (r, r->file_size - sizeof trailer,
+                      trailer, sizeof trailer))
+    {
+      arrow_error (r, -1, _("File is too short to be an Arrow file."));
+      return false;
+    }
+  if (memcmp (trailer + 4, magic, ARROW_MAGIC_LEN))
+    {
+      arrow_error (r, -1, _("File lacks Arrow file trailer.  (Arrow "
+                            "streams, as opposed to files, are not "
+                            "supported.)"));
+      return false;
+    }
+
+  footer_len = integer_get (INTEGER_LSB_FIRST, trailer, 4);
+  footer_ofs = r->file_size - (off_t) sizeof trailer - footer_len;
+  if (footer_len > r->file_size - sizeof trailer || footer_ofs < 8)
+    {
+      arrow_error (r, -1, _("Invalid footer length %"PRIu32"."), footer_len);
+      return false;
+    }
+  data = pool_malloc (r->pool, footer_len);
+  if (!read_bytes (r, footer_ofs, data, footer_len))
+    return false;
+
+  if (!fb_get_root (data, footer_len, &footer)
+      || !fb_get_table (&footer, ARROW_FOOTER_SCHEMA, &schema)
+      || !read_block_vector (r, &footer, ARROW_FOOTER_DICTIONARIES,
+                             &dictionaries, &n_dictionaries)
+      || !read_block_vector (r, &footer, ARROW_FOOTER_RECORD_BATCHES,
+                             &r->batches, &r->n_batches))
+    {
+      arrow_error (r, footer_ofs, _("Invalid file footer."));
+      return false;
+    }
+
+  /* Parse schema. */
+  if (fb_get_i16 (&schema, ARROW_SCHEMA_ENDIANNESS, ARROW_ENDIANNESS_LITTLE)
+      != ARROW_ENDIANNESS_LITTLE)
+    {
+      arrow_error (r, -1, _("Big-endian Arrow files are not supported."));
+      return false;
+    }
+  r->file_encoding = get_custom_metadata (r, &schema,
+                                          ARROW_SCHEMA_CUSTOM_METADATA,
+                                          ARROW_KEY_ENCODING);
+  if (!fb_get_vector (&schema, ARROW_SCHEMA_FIELDS, 4, &fields))
+    fields.n = 0;
+  r->n_columns = fields.n;
+  r->columns = pool_calloc (r->pool, fields.n, sizeof *r->columns);
+  for (i = 0; i < fields.n; i++)
+    {
+      struct fb_table field;
+
+      if (!fb_vector_get_table (&fields, i, &field))
+        {
+          arrow_error (r, footer_ofs, _("Invalid schema."));
+          return false;
+        }
+      if (!parse_field (r, &field, i, &r->columns[i]))
+        return false;
+    }
+
+  for (i = 0; i < n_dictionaries; i++)
+    if (!read_dictionary (r, &dictionaries[i]))
+      return false;
+
+  r->n_cases = 0;
+  for (i = 0; i < r->n_batches; i++)
+    if (!scan_batch (r, &r->batches[i]))
+      return false;
+
+  return true;
+}
+
+/* Reads the buffers of column COL, which has N_ROWS rows, from the record
+   batch with the given BUFFERS in the message at BLOCK, and checks that they
+   are large enough.  Returns true if successful, otherwise reports an error
+   and returns false. */
+static bool
+read_column (struct arrow_reader *r, const struct arrow_block *block,
+             const struct fb_vector *nodes, const struct fb_vector *buffers,
+             struct arrow_column *col, size_t n_rows)
+{
+  off_t body = block->offset + block->metadata_len;
+  uint64_t ofs[3], size[3];
+  uint64_t start, end;
+  int64_t null_count;
+  size_t min_size[3];
+  size_t i;
+
+  assert (col->n_buffers <= 3);
+  start = UINT64_MAX;
+  end = 0;
+  for (i = 0; i < col->n_buffers; i++)
+    {
+      const uint8_t *p = fb_vector_at (buffers, col->buffer + i);
+
+      ofs[i] = integer_get (INTEGER_LSB_FIRST, p, 8);
+      size[i] = integer_get (INTEGER_LSB_FIRST, p + 8, 8);
+      if (ofs[i] > block->body_len || size[i] > block->body_len - ofs[i])
+        {
+          arrow_error (r, block->offset,
+                       _("Column %zu (%s) extends beyond end of record "
+                         "batch."),
+                       col - r->columns + 1, col->name);
+          return false;
+        }
+      if (size[i] > 0)
+        {
+          start = MIN (start, ofs[i]);
+          end = MAX (end, ofs[i] + size[i]);
+        }
+    }
+
+  /* The column's buffers are normally adjacent, so read them all at once. */
+  if (start > end)
+    start = end = 0;
+  if (end - start > col->allocated)
+    {
+      free (col->buf);
+      col->allocated = end - start;
+      col->buf = xmalloc (col->allocated);
+    }
+  if (end > start && !read_bytes (r, body + start, col->buf, end - start))
+    return false;
+
+  /* Check buffer sizes. */
+  min_size[0] = DIV_RND_UP (n_rows, 8);
+  switch (col->kind)
+    {
+    case ARROW_INT:
+    case ARROW_FLOAT:
+    case ARROW_DICT:
+      min_size[1] = n_rows * col->value_size;
+      break;
+
+    case ARROW_BOOL:
+      min_size[1] = DIV_RND_UP (n_rows, 8);
+      break;
+
+    case ARROW_FIXED:
+      min_size[1] = n_rows * col->width;
+      break;
+
+    case ARROW_VARIABLE:
+      min_size[1] = (n_rows + 1) * col->value_size;
+      min_size[2] = 0;
+      break;
+
+    case ARROW_SKIP:
+    default:
+      NOT_REACHED ();
+    }
+
+  null_count = integer_get (INTEGER_LSB_FIRST,
+                            fb_vector_at (nodes, col->node) + 8, 8);
+  for (i = null_count ? 0 : 1; i < col->n_buffers; i++)
+    if (size[i] < min_size[i])
+      {
+        arrow_error (r, block->offset,
+                     _("Column %zu (%s) in record batch is too short."),
+                     col - r->columns + 1, col->name);
+        return false;
+      }
+
+  col->validity = null_count ? col->buf + (ofs[0] - start) : NULL;
+  col->values = col->buf + (ofs[1] - start);
+  if (col->kind == ARROW_VARIABLE)
+    {
+      col->data = col->buf + (ofs[2] - start);
+      col->data_size = size[2];
+    }
+  return true;
+}
+
+/* Returns the IDXth integer of SIZE bytes in DATA, sign-extending it if
+   IS_SIGNED is true. */
+static int64_t
+get_int (const uint8_t *data, size_t idx, size_t size, bool is_signed)
+{
+  uint64_t x = integer_get (INTEGER_LSB_FIRST, data + idx * size, size);
+  if (is_signed && size < 8 && x & (UINT64_C (1) << (size * 8 - 1)))
+    x -= UINT64_C (1) << (size * 8);
+  return x;
+}
+
+/* Returns true if the value in row ROW of COL is null. */
+static bool
+is_null (const struct arrow_column *col, size_t row)
+{
+  return col->validity && !(col->validity[row / 8] & (1u << (row % 8)));
+}
+
+/* Finds the string in row ROW of ARROW_VARIABLE column COL and stores it
+   into *S.  Returns true if successful, false if the string's offsets are
+   invalid. */
+static bool
+get_variable_string (const struct arrow_column *col, size_t row,
+                     struct substring *s)
+{
+  int64_t start = get_int (col->values, row, col->value_size, true);
+  int64_t end = get_int (col->values, row + 1, col->value_size, true);
+
+  if (start < 0 || end < start || end > col->data_size)
+    return false;
+  *s = ss_buffer (CHAR_CAST (char *, col->data + start), end - start);
+  return true;
+}
+
+/* Reads the dictionary batch at BLOCK in R's file and adds its strings to
+   the dictionary of the column that uses it.  Returns true if successful,
+   otherwise reports an error and returns false. */
+static bool
+read_dictionary (struct arrow_reader *r, const struct arrow_block *block)
+{
+  struct fb_vector nodes, buffers;
+  struct fb_table header, batch;
+  struct arrow_column *col;
+  struct arrow_column tmp;
+  bool is_delta;
+  size_t n_rows;
+  int64_t id;
+  size_t i;
+
+  if (!read_message (r, block, ARROW_HEADER_DICTIONARY_BATCH, &header, NULL))
+    return false;
+  if (!fb_get_table (&header, ARROW_DICTIONARY_BATCH_DATA, &batch))
+    {
+      arrow_error (r, block->offset, _("Invalid dictionary batch."));
+      return false;
+    }
+  id = fb_get_i64 (&header, ARROW_DICTIONARY_BATCH_ID, 0);
+  is_delta = fb_get_bool (&header, ARROW_DICTIONARY_BATCH_IS_DELTA, false);
+
+  for (col = r->columns; col < &r->columns[r->n_columns]; col++)
+    if (col->kind == ARROW_DICT && col->dict_id == id)
+      break;
+  if (col >= &r->columns[r->n_columns])
+    return true;
+
+  /* Read the dictionary's values, which are stored like the values in an
+     ARROW_VARIABLE column. */
+  if (!parse_record_batch (r, block, &batch, 1, 3, &n_rows, &nodes, &buffers))
+    return false;
+  memset (&tmp, 0, sizeof tmp);
+  tmp.name = col->name;
+  tmp.kind = ARROW_VARIABLE;
+  tmp.value_size = col->dict_offset_size;
+  tmp.n_buffers = 3;
+  if (!read_column (r, block, &nodes, &buffers, &tmp, n_rows))
+    {
+      free (tmp.buf);
+      return false;
+    }
+
+  if (!is_delta)
+    col->n_strings = 0;
+  for (i = 0; i < n_rows; i++)
+    {
+      struct substring s;
+
+      if (is_null (&tmp, i))
+        s = ss_empty ();
+      else if (!get_variable_string (&tmp, i, &s))
+        {
+          arrow_error (r, block->offset, _("Invalid string offsets in "
+                                           "dictionary for column %zu (%s)."),
+                       col - r->columns + 1, col->name);
+          free (tmp.buf);
+          return false;
+        }
+
+      if (col->n_strings >= col->allocated_strings)
+        col->strings = pool_2nrealloc (r->pool, col->strings,
+                                       &col->allocated_strings,
+                                       sizeof *col->strings);
+      ss_alloc_substring_pool (&col->strings[col->n_strings++], s, r->pool);
+      col->width = MAX (col->width, MIN (s.length, MAX_STRING));
+    }
+  free (tmp.buf);
+
+  return true;
+}
+
+/* Reads the metadata for the record batch at BLOCK in R's file, adding its
+   number of rows to the number of cases in R.  For variable-length string
+   columns, also reads the string offsets, to find out the width of the
+   longest string.  Returns true if successful, otherwise reports an error
+   and returns false. */
+static bool
+scan_batch (struct arrow_reader *r, const struct arrow_block *block)
+{
+  struct fb_vector nodes, buffers;
+  struct fb_table header;
+  struct arrow_column *col;
+  size_t n_rows;
+
+  if (!read_message (r, block, ARROW_HEADER_RECORD_BATCH, &header, NULL)
+      || !parse_record_batch (r, block, &header, r->n_nodes, r->n_buffers,
+                              &n_rows, &nodes, &buffers))
+    return false;
+  r->n_cases += n_rows;
+
+  for (col = r->columns; col < &r->columns[r->n_columns]; col++)
+    if (col->kind == ARROW_VARIABLE && n_rows > 0)
+      {
+        const uint8_t *p = fb_vector_at (&buffers, col->buffer + 1);
+        uint64_t ofs = integer_get (INTEGER_LSB_FIRST, p, 8);
+        uint64_t size = integer_get (INTEGER_LSB_FIRST, p + 8, 8);
+        uint8_t *offsets;
+        size_t i;
+
+        if (ofs > block->body_len || size > block->body_len - ofs
+            || size < (n_rows + 1) * col->value_size)
+          {
+            arrow_error (r, block->offset,
+                         _("Column %zu (%s) in record batch is too short."),
+                         col - r->columns + 1, col->name);
+            return false;
+          }
+
+        offsets = xmalloc (size);
+        if (!read_bytes (r, block->offset + block->metadata_len + ofs,
+                         offsets, size))
+          {
+            free (offsets);
+            return false;
+          }
+        for (i = 0; i < n_rows && col->width < MAX_STRING; i++)
+          {
+            int64_t start = get_int (offsets, i, col->value_size, true);
+            int64_t end = get_int (offsets, i + 1, col->value_size, true);
+            if (end > start && end - start > col->width)
+              col->width = MIN (end - start, MAX_STRING);
+          }
+        free (offsets);
+      }
+
+  return true;
+}
+
+/* Parses S, a print format written by PSPP into an Arrow file's metadata,
+   into *FORMAT.  Returns true if successful, false if S is not a valid
+   output format for a variable of the given WIDTH. */
+static bool
+parse_format (const char *s, int width, struct fmt_spec *format)
+{
+  char type[FMT_TYPE_LEN_MAX + 1];
+  int w, d, n;
+
+  d = 0;
+  if (sscanf (s, "%8[A-Za-z]%d%n", type, &w, &n) != 2
+      || (s[n] == '.' && sscanf (s + n, ".%d%n", &d, &n) != 1)
+      || (s[n] != '\0' && s[n] != '.')
+      || !fmt_from_name (type, &format->type))
+    return false;
+
+  format->w = w;
+  format->d = d;
+  return (fmt_is_string (format->type) == (width > 0)
+          && w >= fmt_min_output_width (format->type)
+          && w <= fmt_max_output_width (format->type)
+          && d >= 0
+          && d <= fmt_max_output_decimals (format->type, w)
+          && (width == 0 || fmt_var_width (format) == width));
+}
+
+/* Returns the print format to use for column COL, which has the given
+   WIDTH. */
+static struct fmt_spec
+column_format (const struct arrow_column *col, int width)
+{
+  struct fmt_spec format;
+
+  if (col->format != NULL && parse_format (col->format, width, &format))
+    return format;
+
+  switch (col->kind)
+    {
+    case ARROW_INT:
+      /* Enough digits for the widest value of the integer type. */
+      return fmt_for_output (FMT_F, (col->value_size == 1 ? 4
+                                     : col->value_size == 2 ? 6
+                                     : col->value_size == 4 ? 11
+                                     : 20), 0);
+
+    case ARROW_BOOL:
+      return fmt_for_output (FMT_F, 1, 0);
+
+    default:
+      return fmt_default_for_width (width);
+    }
+}
+
+/* Reads the dictionary from the Arrow file opened by R, which must have
+   been returned by arrow_open().  If ENCODING is nonnull, uses it as the
+   dictionary encoding, otherwise the encoding recorded in the file, or
+   UTF-8 if there is none.  On success, stores the dictionary into *DICTP
+   and information about the file into *INFOP (if nonnull), and returns a
+   casereader for the file's data.  On failure, returns a null pointer.
+   Either way, R is consumed. */
+static struct casereader *
+arrow_decode (struct any_reader *r_, const char *encoding,
+              struct dictionary **dictp, struct any_read_info *infop)
+{
+  struct arrow_reader *r = arrow_reader_cast (r_);
+  struct arrow_column *col;
+  struct dictionary *dict;
+  bool recode;
+
+  if (encoding == NULL)
+    encoding = r->file_encoding != NULL ? r->file_encoding : "UTF-8";
+  dict = dict_create (encoding);
+  r->encoding = dict_get_encoding (dict);
+  recode = !is_encoding_utf8 (r->encoding);
+
+  for (col = r->columns; col < &r->columns[r->n_columns]; col++)
+    {
+      struct fmt_spec format;
+      struct variable *var;
+      int width;
+      size_t i;
+
+      if (col->kind == ARROW_SKIP)
+        continue;
+
+      /* Convert dictionary to the dictionary encoding. */
+      if (col->kind == ARROW_DICT && col->is_utf8 && recode)
+        {
+          col->width = 0;
+          for (i = 0; i < col->n_strings; i++)
+            {
+              col->strings[i] = recode_substring_pool (r->encoding, "UTF-8",
+                                                       col->strings[i],
+                                                       r->pool);
+              col->width = MAX (col->width,
+                                MIN (col->strings[i].length, MAX_STRING));
+            }
+        }
+
+      width = (col->kind == ARROW_INT || col->kind == ARROW_FLOAT
+               || col->kind == ARROW_BOOL ? 0
+               : MAX (col->width, 1));
+
+      var = (dict_id_is_valid (dict, col->name, false) && col->name[0] != '#'
+             ? dict_create_var (dict, col->name, width)
+             : NULL);
+      if (var == NULL)
+        {
+          char *new_name = dict_make_unique_var_name (dict, NULL, NULL);
+          arrow_warn (r, -1, _("Renaming column %zu (%s) to `%s'."),
+                      col - r->columns + 1, col->name, new_name);
+          var = dict_create_var_assert (dict, new_name, width);
+          free (new_name);
+        }
+
+      format = column_format (col, width);
+      var_set_both_formats (var, &format);
+      if (col->label != NULL)
+        var_set_label (var, col->label);
+
+      col->case_index = var_get_case_index (var);
+      col->needed = true;
+    }
+  r->proto = caseproto_ref_pool (dict_get_proto (dict), r->pool);
+
+  *dictp = dict;
+  if (infop)
+    {
+      memset (infop, 0, sizeof *infop);
+      infop->integer_format = INTEGER_LSB_FIRST;
+      infop->float_format = FLOAT_IEEE_DOUBLE_LE;
+      infop->compression = ANY_COMP_NONE;
+      infop->case_cnt = r->has_ranges ? -1 : r->n_cases;
+    }
+
+  return casereader_create_sequential
+    (NULL, r->proto, r->has_ranges ? CASENUMBER_MAX : r->n_cases,
+     &arrow_file_casereader_class, r);
+}
+
+/* Selection. */
+
+/* Arranges for R to read only cases in which the column named NAME has a
+   value between LOW and HIGH, inclusive.  A null value is never in range.
+   If a range has already been selected for the column, the new range is
+   intersected with it.
+
+   Must be called after arrow_open() and before arrow_decode().  Returns
+   true if successful, false if there is no numeric column named NAME in
+   R. */
+bool
+arrow_reader_select_range (struct any_reader *r_, const char *name,
+                           double low, double high)
+{
+  struct arrow_reader *r = arrow_reader_cast (r_);
+  struct arrow_column *col;
+
+  for (col = r->columns; col < &r->columns[r->n_columns]; col++)
+    if (!utf8_strcasecmp (col->name, name))
+      {
+        if (col->kind != ARROW_INT && col->kind != ARROW_FLOAT
+            && col->kind != ARROW_BOOL)
+          {
+            msg (SE, _("Column %s in `%s' is not numeric."),
+                 name, fh_get_file_name (r->fh));
+            return false;
+          }
+
+        if (col->has_range)
+          {
+            col->low = MAX (col->low, low);
+            col->high = MIN (col->high, high);
+          }
+        else
+          {
+            col->has_range = true;
+            col->low = low;
+            col->high = high;
+          }
+        r->has_ranges = true;
+        return true;
+      }
+
+  msg (SE, _("`%s' does not contain a column named %s."),
+       fh_get_file_name (r->fh), name);
+  return false;
+}
+
+/* Arranges for READER to read data only for the N variables with the given
+   CASE_INDEXES.  Other variables are read as system-missing or blank.
+
+   Must be called before reading any cases from READER.  Returns true if
+   successful, false if READER is not a casereader for an Arrow file. */
+bool
+arrow_casereader_project (struct casereader *reader,
+                          const size_t *case_indexes, size_t n)
+{
+  struct arrow_reader *r;
+  struct arrow_column *col;
+  size_t i;
+
+  r = casereader_dynamic_cast (reader, &arrow_file_casereader_class);
+  if (r == NULL)
+    return false;
+  assert (r->batch_idx == 0);
+
+  for (col = r->columns; col < &r->columns[r->n_columns]; col++)
+    {
+      col->needed = false;
+      if (col->case_index >= 0)
+        for (i = 0; i < n; i++)
+          if (case_indexes[i] == (size_t) col->case_index)
+            {
+              col->needed = true;
+              break;
+            }
+    }
+  return true;
+}
+
+/* Looks for the range of values of column IDX in RANGES, the value of a
+   record batch's ARROW_KEY_RANGE metadata.  If it is present, stores the
+   minimum and maximum into *MIN and *MAX and returns true; otherwise,
+   returns false. */
+static bool
+find_range (const char *ranges, size_t idx, double *min, double *max)
+{
+  char buf[128];
+  char *colon, *tail;
+  size_t len;
+
+  for (; idx > 0; idx--)
+    {
+      ranges = strchr (ranges, ' ');
+      if (ranges == NULL)
+        return false;
+      ranges++;
+    }
+
+  len = strcspn (ranges, " ");
+  if (len >= sizeof buf)
+    return false;
+  memcpy (buf, ranges, len);
+  buf[len] = '\0';
+
+  colon = strchr (buf, ':');
+  if (colon == NULL)
+    return false;
+  *colon = '\0';
+  *min = c_strtod (buf, &tail);
+  if (*tail != '\0')
+    return false;
+  *max = c_strtod (colon + 1, &tail);
+  return *tail == '\0';
+}
+
+/* Returns false if the ranges recorded in MESSAGE, a record batch message
+   from R, show that none of the rows in the batch can satisfy the selected
+   ranges, true otherwise. */
+static bool
+batch_may_match (struct arrow_reader *r, const struct fb_table *message)
+{
+  const struct arrow_column *col;
+  const char *ranges;
+  size_t len;
+
+  /* Flatbuffer strings are null-terminated, but check anyway. */
+  if (!find_custom_metadata (message, ARROW_MESSAGE_CUSTOM_METADATA,
+                             ARROW_KEY_RANGE, &ranges, &len)
+      || memchr (ranges, '\0', len + 1) != ranges + len)
+    return true;
+
+  for (col = r->columns; col < &r->columns[r->n_columns]; col++)
+    if (col->has_range)
+      {
+        double min, max;
+
+        if (find_range (ranges, col - r->columns, &min, &max)
+            && (max < col->low || min > col->high))
+          return false;
+      }
+  return true;
+}
+
+/* Reads the next record batch from R that might contain selected cases.
+   Returns true if successful, false at end of file or on error. */
+static bool
+read_batch (struct arrow_reader *r)
+{
+  while (r->batch_idx < r->n_batches)
+    {
+      const struct arrow_block *block = &r->batches[r->batch_idx++];
+      struct fb_vector nodes, buffers;
+      struct fb_table message, header;
+      struct arrow_column *col;
+      size_t n_rows;
+
+      if (!read_message (r, block, ARROW_HEADER_RECORD_BATCH,
+                         &header, &message)
+          || !parse_record_batch (r, block, &header, r->n_nodes,
+                                  r->n_buffers, &n_rows, &nodes, &buffers))
+        return false;
+      if (n_rows == 0 || (r->has_ranges && !batch_may_match (r, &message)))
+        continue;
+
+      for (col = r->columns; col < &r->columns[r->n_columns]; col++)
+        if ((col->needed || col->has_range)
+            && !read_column (r, block, &nodes, &buffers, col, n_rows))
+          return false;
+
+      r->n_rows = n_rows;
+      r->row = 0;
+      return true;
+    }
+  return false;
+}
+
+/* Returns the value in row ROW of numeric column COL. */
+static double
+get_number (const struct arrow_column *col, size_t row)
+{
+  double x;
+
+  if (is_null (col, row))
+    return SYSMIS;
+
+  switch (col->kind)
+    {
+    case ARROW_INT:
+      return (col->is_signed
+              ? get_int (col->values, row, col->value_size, true)
+              : (double) integer_get (INTEGER_LSB_FIRST,
+                                      col->values + row * col->value_size,
+                                      col->value_size));
+
+    case ARROW_FLOAT:
+      x = float_get_double (col->value_size == 4
+                            ? FLOAT_IEEE_SINGLE_LE : FLOAT_IEEE_DOUBLE_LE,
+                            col->values + row * col->value_size);
+      return isnan (x) ? SYSMIS : x;
+
+    case ARROW_BOOL:
+      return (col->values[row / 8] & (1u << (row % 8))) != 0;
+
+    default:
+      NOT_REACHED ();
+    }
+}
+
+/* Stores the value in row ROW of column COL into V.  Returns true if
+   successful, otherwise reports an error and returns false. */
+static bool
+get_value (struct arrow_reader *r, const struct arrow_column *col,
+           size_t row, union value *v)
+{
+  uint8_t *s;
+  int width;
+
+  if (col->kind == ARROW_INT || col->kind == ARROW_FLOAT
+      || col->kind == ARROW_BOOL)
+    {
+      v->f = get_number (col, row);
+      return true;
+    }
+
+  width = caseproto_get_width (r->proto, col->case_index);
+  s = value_str_rw (v, width);
+  if (is_null (col, row))
+    memset (s, ' ', width);
+  else if (col->kind == ARROW_FIXED)
+    memcpy (s, col->values + row * width, width);
+  else if (col->kind == ARROW_VARIABLE)
+    {
+      struct substring ss;
+
+      if (!get_variable_string (col, row, &ss))
+        {
+          arrow_error (r, -1, _("Invalid string offsets in column %zu (%s)."),
+                       col - r->columns + 1, col->name);
+          return false;
+        }
+      if (col->is_utf8 && !is_encoding_utf8 (r->encoding))
+        {
+          char *recoded = recode_string (r->encoding, "UTF-8",
+                                         ss.string, ss.length);
+          u8_buf_copy_rpad (s, width, CHAR_CAST (uint8_t *, recoded),
+                            strlen (recoded), ' ');
+          free (recoded);
+        }
+      else
+        u8_buf_copy_rpad (s, width, CHAR_CAST (uint8_t *, ss.string),
+                          ss.length, ' ');
+    }
+  else if (col->kind == ARROW_DICT)
+    {
+      int64_t idx = get_int (col->values, row, col->value_size,
+                             col->is_signed);
+      const struct substring *ss;
+
+      if (idx < 0 || idx >= col->n_strings)
+        {
+          arrow_error (r, -1, _("Invalid dictionary index %"PRId64" in "
+                                "column %zu (%s)."),
+                       idx, col - r->columns + 1, col->name);
+          return false;
+        }
+      ss = &col->strings[idx];
+      u8_buf_copy_rpad (s, width, CHAR_CAST (uint8_t *, ss->string),
+                        ss->length, ' ');
+    }
+  else
+    NOT_REACHED ();
+
+  return true;
+}
+
+/* Returns true if row ROW of the current record batch in R is in all of the
+   selected ranges. */
+static bool
+row_is_selected (const struct arrow_reader *r, size_t row)
+{
+  const struct arrow_column *col;
+
+  for (col = r->columns; col < &r->columns[r->n_columns]; col++)
+    if (col->has_range)
+      {
+        double x = get_number (col, row);
+        if (x == SYSMIS || x < col->low || x > col->high)
+          return false;
+      }
+  return true;
+}
+
+/* Reads and returns one case from READER's file.  Returns a null pointer at
+   end of file or if an error occurs. */
+static struct ccase *
+arrow_file_casereader_read (struct casereader *reader, void *r_)
+{
+  struct arrow_reader *r = r_;
+  const struct arrow_column *col;
+  struct ccase *c;
+  size_t row;
+
+  if (r->error)
+    return NULL;
+
+  do
+    {
+      if (r->row >= r->n_rows && !read_batch (r))
+        {
+          if (r->error)
+            casereader_force_error (reader);
+          return NULL;
+        }
+      row = r->row++;
+    }
+  while (r->has_ranges && !row_is_selected (r, row));
+
+  c = case_create (r->proto);
+  for (col = r->columns; col < &r->columns[r->n_columns]; col++)
+    if (col->case_index >= 0)
+      {
+        union value *v = case_data_rw_idx (c, col->case_index);
+
+        if (!col->needed)
+          value_set_missing (v, caseproto_get_width (r->proto,
+                                                     col->case_index));
+        else if (!get_value (r, col, row, v))
+          {
+            casereader_force_error (reader);
+            case_unref (c);
+            return NULL;
+          }
+      }
+  return c;
+}
+
+/* Destroys READER. */
+static void
+arrow_file_casereader_destroy (struct casereader *reader, void *r_)
+{
+  struct arrow_reader *r = r_;
+  if (!arrow_close (&r->any_reader))
+    casereader_force_error (reader);
+}
+
+static const struct casereader_class arrow_file_casereader_class =
+  {
+    arrow_file_casereader_read,
+    arrow_file_casereader_destroy,
+    NULL,
+    NULL,
+  };
+
+const struct any_reader_class arrow_file_reader_class =
+  {
+    N_("Apache Arrow File"),
+    arrow_detect,
+    arrow_open,
+    arrow_close,
+    arrow_decode,
+    NULL,
+  };
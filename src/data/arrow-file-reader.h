@@ -0,0 +1,48 @@
+/* PSPP - a program for statistical analysis.
+   Copyright (C) 2017 Free Software Foundation, Inc.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+#ifndef ARROW_FILE_READER_H
+#define ARROW_FILE_READER_H 1
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Reading Apache Arrow IPC (Feather version 2) files.
+
+   Arrow files are read through the any_reader interface, like system files
+   (see any-reader.h).  Because Arrow files are stored column by column, the
+   functions below can also limit the data actually read from such a file:
+
+     - arrow_reader_select_range(), called between any_reader_open() and
+       any_reader_decode(), reads only the cases in which a given numeric
+       column has a value in a given range.  Whole record batches whose
+       recorded range of values excludes the range are skipped without being
+       read.
+
+     - arrow_casereader_project(), called on the casereader returned by
+       any_reader_decode() before reading any cases, reads only the given
+       variables.  Other variables read as system-missing or blank, so the
+       caller will usually drop them from the dictionary. */
+
+struct any_reader;
+struct casereader;
+
+bool arrow_reader_select_range (struct any_reader *, const char *name,
+                                double low, double high);
+bool arrow_casereader_project (struct casereader *,
+                               const size_t *case_indexes, size_t n);
+
+#endif /* arrow-file-reader.h */
@@ -0,0 +1,938 @@
+/* PSPP - a program for statistical analysis.
+   Copyright (C) 2017 Free Software Foundation, Inc.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+#include <config.h>
+
+#include "data/arrow-file-writer.h"
+#include "data/arrow-file-private.h"
+
+#include <byteswap.h>
+#include <errno.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "data/case.h"
+#include "data/casewriter-provider.h"
+#include "data/casewriter.h"
+#include "data/data-out.h"
+#include "data/dictionary.h"
+#include "data/file-handle-def.h"
+#include "data/format.h"
+#include "data/make-file.h"
+#include "data/missing-values.h"
+#include "data/settings.h"
+#include "data/value-labels.h"
+#include "data/variable.h"
+#include "libpspp/assertion.h"
+#include "libpspp/flatbuffers.h"
+#include "libpspp/hash-functions.h"
+#include "libpspp/hmap.h"
+#include "libpspp/integer-format.h"
+#include "libpspp/message.h"
+#include "libpspp/misc.h"
+#include "libpspp/str.h"
+
+#include "gl/minmax.h"
+#include "gl/unlocked-io.h"
+#include "gl/xalloc.h"
+
+#include "gettext.h"
+#define _(msgid) gettext (msgid)
+#define N_(msgid) (msgid)
+
+/* Default maximum number of cases in a record batch.  The actual number may
+   be smaller, to keep a batch within the workspace (see SET WORKSPACE). */
+#define DEFAULT_BATCH_CASES 65536
+
+/* A string in the dictionary of a dictionary-encoded column. */
+struct arrow_dict_entry
+  {
+    struct hmap_node hmap_node; /* In struct arrow_var's 'dict_map'. */
+    int index;                  /* Index into struct arrow_var's 'strings'. */
+  };
+
+/* A variable (column) in an Arrow file. */
+struct arrow_var
+  {
+    int width;                     /* Variable width (0 to 32767). */
+    int case_index;                /* Index into case. */
+    struct fmt_spec format;        /* Print format. */
+    struct missing_values missing; /* User-missing values, if recoding. */
+    struct val_labs *val_labs;     /* Value labels, if dictionary-encoded. */
+    char *name;                    /* Variable name. */
+    char *label;                   /* Variable label, if any. */
+
+    /* Contents of the record batch under construction.  'data' holds doubles
+       for a numeric variable, 'width' bytes per case for a string variable,
+       or 32-bit dictionary indexes for a dictionary-encoded variable. */
+    uint8_t *validity;          /* One bit per case, 1 if not null. */
+    size_t n_nulls;             /* Number of 0-bits in 'validity'. */
+    void *data;                 /* Values. */
+    double min, max;            /* Range of non-null numeric values. */
+
+    /* Dictionary, for a dictionary-encoded variable. */
+    struct hmap dict_map;       /* Contains "struct arrow_dict_entry"s. */
+    char **strings;             /* Dictionary strings, in index order. */
+    size_t n_strings, allocated_strings;
+  };
+
+/* The location of a message within an Arrow file. */
+struct arrow_block
+  {
+    uint64_t offset;            /* Offset of message from start of file. */
+    uint32_t metadata_len;      /* Length of metadata, including prefix. */
+    uint64_t body_len;          /* Length of message body. */
+  };
+
+/* A buffer in the body of a message. */
+struct arrow_buffer
+  {
+    const void *data;
+    size_t size;
+  };
+
+/* Arrow file writer. */
+struct arrow_writer
+  {
+    struct file_handle *fh;     /* File handle. */
+    struct fh_lock *lock;       /* Mutual exclusion for file. */
+    FILE *file;			/* File stream. */
+    struct replace_file *rf;    /* Ticket for replacing output file. */
+    uint64_t pos;               /* Number of bytes written to 'file'. */
+
+    char *encoding;             /* Encoding used by variables. */
+
+    /* Variables. */
+    struct arrow_var *vars;     /* Variables. */
+    size_t n_vars;              /* Number of variables. */
+
+    /* Record batch under construction. */
+    size_t batch_cases;         /* Maximum number of cases in a batch. */
+    size_t n_cases;             /* Number of cases in current batch. */
+
+    /* Record batches already written. */
+    struct arrow_block *batches;
+    size_t n_batches, allocated_batches;
+
+    struct fb_builder fb;       /* For building metadata. */
+  };
+
+static const struct casewriter_class arrow_file_casewriter_class;
+
+static bool arrow_var_is_dict_encoded (const struct arrow_var *);
+static size_t arrow_var_value_size (const struct arrow_var *);
+static void write_schema_message (struct arrow_writer *);
+static void write_batch (struct arrow_writer *);
+
+static bool write_error (const struct arrow_writer *);
+static bool close_writer (struct arrow_writer *);
+
+/* Initializes OPTS with default options for writing an Arrow file. */
+void
+arrow_writer_options_init (struct arrow_writer_options *opts)
+{
+  opts->recode_user_missing = false;
+  opts->use_value_labels = false;
+  opts->batch_cases = 0;
+}
+
+/* Opens the Arrow file designated by file handle FH for writing cases from
+   dictionary DICT according to the given OPTS.
+
+   No reference to D is retained, so it may be modified or
+   destroyed at will after this function returns. */
+struct casewriter *
+arrow_writer_open (struct file_handle *fh, const struct dictionary *dict,
+                   const struct arrow_writer_options *opts)
+{
+  struct arrow_writer *w;
+  size_t case_bytes;
+  size_t i;
+
+  /* Create and initialize writer. */
+  w = xmalloc (sizeof *w);
+  w->fh = fh_ref (fh);
+  w->lock = NULL;
+  w->file = NULL;
+  w->rf = NULL;
+  w->pos = 0;
+
+  w->encoding = xstrdup (dict_get_encoding (dict));
+
+  w->n_vars = dict_get_var_cnt (dict);
+  w->vars = xnmalloc (w->n_vars, sizeof *w->vars);
+  case_bytes = 1;
+  for (i = 0; i < w->n_vars; i++)
+    {
+      const struct variable *var = dict_get_var (dict, i);
+      struct arrow_var *av = &w->vars[i];
+
+      av->width = var_get_width (var);
+      av->case_index = var_get_case_index (var);
+      av->format = *var_get_print_format (var);
+      if (opts->recode_user_missing)
+        mv_copy (&av->missing, var_get_missing_values (var));
+      else
+        mv_init (&av->missing, av->width);
+      av->val_labs = (opts->use_value_labels && var_has_value_labels (var)
+                      ? val_labs_clone (var_get_value_labels (var))
+                      : NULL);
+      av->name = xstrdup (var_get_name (var));
+      av->label = (var_has_label (var)
+                   ? xstrdup (var_get_label (var))
+                   : NULL);
+
+      av->validity = NULL;
+      av->n_nulls = 0;
+      av->data = NULL;
+      av->min = HUGE_VAL;
+      av->max = -HUGE_VAL;
+
+      hmap_init (&av->dict_map);
+      av->strings = NULL;
+      av->n_strings = av->allocated_strings = 0;
+
+      case_bytes += arrow_var_value_size (av);
+    }
+
+  w->batch_cases = (opts->batch_cases > 0 ? opts->batch_cases
+                    : MAX (1, MIN (DEFAULT_BATCH_CASES,
+                                   settings_get_workspace () / case_bytes)));
+  w->n_cases = 0;
+  for (i = 0; i < w->n_vars; i++)
+    {
+      struct arrow_var *av = &w->vars[i];
+
+      av->validity = xmalloc (DIV_RND_UP (w->batch_cases, 8));
+      av->data = xnmalloc (w->batch_cases, arrow_var_value_size (av));
+    }
+
+  w->batches = NULL;
+  w->n_batches = w->allocated_batches = 0;
+
+  fb_builder_init (&w->fb);
+
+  /* Open file handle as an exclusive writer. */
+  /* TRANSLATORS: this fragment will be interpolated into messages in fh_lock()
+     that identify types of files. */
+  w->lock = fh_lock (fh, FH_REF_FILE, N_("Arrow file"), FH_ACC_WRITE, true);
+  if (w->lock == NULL)
+    goto error;
+
+  /* Create the file on disk. */
+  w->rf = replace_file_start (fh, "wb", 0666, &w->file);
+  if (w->rf == NULL)
+    {
+      msg (ME, _("Error opening `%s' for writing as an Arrow file: %s."),
+           fh_get_file_name (fh), strerror (errno));
+      goto error;
+    }
+
+  write_schema_message (w);
+  if (write_error (w))
+    goto error;
+
+  return casewriter_create (dict_get_proto (dict),
+                            &arrow_file_casewriter_class, w);
+
+error:
+  close_writer (w);
+  return NULL;
+}
+
+/* Returns true if AV is written as a dictionary-encoded column, false if it
+   is written as plain values. */
+static bool
+arrow_var_is_dict_encoded (const struct arrow_var *av)
+{
+  return av->val_labs != NULL;
+}
+
+/* Returns the number of bytes that AV occupies in a record batch for each
+   case, not counting its validity bit. */
+static size_t
+arrow_var_value_size (const struct arrow_var *av)
+{
+  return (arrow_var_is_dict_encoded (av) ? sizeof (int32_t)
+          : av->width == 0 ? sizeof (double)
+          : av->width);
+}
+
+static void
+write_bytes (struct arrow_writer *w, const void *data, size_t size)
+{
+  fwrite (data, 1, size, w->file);
+  w->pos += size;
+}
+
+static void
+write_u32 (struct arrow_writer *w, uint32_t x)
+{
+  uint8_t buf[4];
+
+  integer_put (x, INTEGER_LSB_FIRST, buf, sizeof buf);
+  write_bytes (w, buf, sizeof buf);
+}
+
+/* Writes zero bytes to W until its file offset is a multiple of 8, as Arrow
+   requires for the start of every message and buffer. */
+static void
+write_padding (struct arrow_writer *w)
+{
+  static const uint8_t zeros[8];
+
+  write_bytes (w, zeros, (8 - w->pos % 8) % 8);
+}
+
+/* Adds a table of custom metadata with the given KEY and VALUE to W's
+   flatbuffer and returns its offset. */
+static uint32_t
+create_key_value (struct arrow_writer *w, const char *key, const char *value)
+{
+  uint32_t key_ofs = fb_create_string (&w->fb, key);
+  uint32_t value_ofs = fb_create_string (&w->fb, value);
+
+  fb_start_table (&w->fb, ARROW_KEY_VALUE_N_FIELDS);
+  fb_add_offset (&w->fb, ARROW_KEY_VALUE_KEY, key_ofs);
+  fb_add_offset (&w->fb, ARROW_KEY_VALUE_VALUE, value_ofs);
+  return fb_end_table (&w->fb);
+}
+
+/* Adds a Field table describing variable AV, which is the IDXth variable in
+   W, to W's flatbuffer and returns its offset. */
+static uint32_t
+create_field (struct arrow_writer *w, const struct arrow_var *av, size_t idx)
+{
+  struct fb_builder *fb = &w->fb;
+  uint32_t name, type, children, metadata, dictionary;
+  char format[FMT_STRING_LEN_MAX + 1];
+  uint32_t kv[2];
+  size_t n_kv;
+  int type_type;
+
+  name = fb_create_string (fb, av->name);
+
+  if (arrow_var_is_dict_encoded (av))
+    {
+      uint32_t index_type;
+
+      fb_start_table (fb, ARROW_INT_N_FIELDS);
+      fb_add_i32 (fb, ARROW_INT_BIT_WIDTH, 32);
+      fb_add_bool (fb, ARROW_INT_IS_SIGNED, true);
+      index_type = fb_end_table (fb);
+
+      fb_start_table (fb, ARROW_DICTIONARY_ENCODING_N_FIELDS);
+      fb_add_i64 (fb, ARROW_DICTIONARY_ENCODING_ID, idx);
+      fb_add_offset (fb, ARROW_DICTIONARY_ENCODING_INDEX_TYPE, index_type);
+      dictionary = fb_end_table (fb);
+
+      type_type = ARROW_TYPE_UTF8;
+      fb_start_table (fb, 0);
+    }
+  else if (av->width == 0)
+    {
+      dictionary = 0;
+      type_type = ARROW_TYPE_FLOATING_POINT;
+      fb_start_table (fb, ARROW_FLOATING_POINT_N_FIELDS);
+      fb_add_i16 (fb, ARROW_FLOATING_POINT_PRECISION, ARROW_PRECISION_DOUBLE);
+    }
+  else
+    {
+      dictionary = 0;
+      type_type = ARROW_TYPE_FIXED_SIZE_BINARY;
+      fb_start_table (fb, ARROW_FIXED_SIZE_BINARY_N_FIELDS);
+      fb_add_i32 (fb, ARROW_FIXED_SIZE_BINARY_BYTE_WIDTH, av->width);
+    }
+  type = fb_end_table (fb);
+
+  /* Arrow readers insist on a "children" vector even if it is empty. */
+  children = fb_create_offset_vector (fb, NULL, 0);
+
+  n_kv = 0;
+  kv[n_kv++] = create_key_value (w, ARROW_KEY_FORMAT,
+                                 fmt_to_string (&av->format, format));
+  if (av->label != NULL)
+    kv[n_kv++] = create_key_value (w, ARROW_KEY_LABEL, av->label);
+  metadata = fb_create_offset_vector (fb, kv, n_kv);
+
+  fb_start_table (fb, ARROW_FIELD_N_FIELDS);
+  fb_add_offset (fb, ARROW_FIELD_NAME, name);
+  fb_add_bool (fb, ARROW_FIELD_NULLABLE, true);
+  fb_add_u8 (fb, ARROW_FIELD_TYPE_TYPE, type_type);
+  fb_add_offset (fb, ARROW_FIELD_TYPE, type);
+  fb_add_offset (fb, ARROW_FIELD_DICTIONARY, dictionary);
+  fb_add_offset (fb, ARROW_FIELD_CHILDREN, children);
+  fb_add_offset (fb, ARROW_FIELD_CUSTOM_METADATA, metadata);
+  return fb_end_table (fb);
+}
+
+/* Adds a Schema table describing W's variables to W's flatbuffer and returns
+   its offset. */
+static uint32_t
+create_schema (struct arrow_writer *w)
+{
+  uint32_t *fields, fields_vector, metadata, kv;
+  size_t i;
+
+  fields = xnmalloc (w->n_vars, sizeof *fields);
+  for (i = 0; i < w->n_vars; i++)
+    fields[i] = create_field (w, &w->vars[i], i);
+  fields_vector = fb_create_offset_vector (&w->fb, fields, w->n_vars);
+  free (fields);
+
+  kv = create_key_value (w, ARROW_KEY_ENCODING, w->encoding);
+  metadata = fb_create_offset_vector (&w->fb, &kv, 1);
+
+  fb_start_table (&w->fb, ARROW_SCHEMA_N_FIELDS);
+  fb_add_offset (&w->fb, ARROW_SCHEMA_FIELDS, fields_vector);
+  fb_add_offset (&w->fb, ARROW_SCHEMA_CUSTOM_METADATA, metadata);
+  return fb_end_table (&w->fb);
+}
+
+/* Adds to W's flatbuffer a vector of the N Block structs in BLOCKS, and
+   returns its offset. */
+static uint32_t
+create_block_vector (struct arrow_writer *w,
+                     const struct arrow_block *blocks, size_t n)
+{
+  uint8_t *data = xnmalloc (n, ARROW_BLOCK_SIZE);
+  uint32_t vector;
+  size_t i;
+
+  for (i = 0; i < n; i++)
+    {
+      uint8_t *p = &data[i * ARROW_BLOCK_SIZE];
+
+      integer_put (blocks[i].offset, INTEGER_LSB_FIRST, p, 8);
+      integer_put (blocks[i].metadata_len, INTEGER_LSB_FIRST, p + 8, 4);
+      integer_put (0, INTEGER_LSB_FIRST, p + 12, 4);
+      integer_put (blocks[i].body_len, INTEGER_LSB_FIRST, p + 16, 8);
+    }
+  vector = fb_create_vector (&w->fb, data, ARROW_BLOCK_SIZE, n, 8);
+  free (data);
+
+  return vector;
+}
+
+/* Adds a RecordBatch table with N_ROWS rows to W's flatbuffer and returns
+   its offset.  The batch has the N_NODES columns described by LENGTHS and
+   NULL_COUNTS, stored in the N_BUFFERS buffers in BUFFERS. */
+static uint32_t
+create_record_batch (struct arrow_writer *w, size_t n_rows,
+                     const size_t *null_counts, size_t n_nodes,
+                     const struct arrow_buffer *buffers, size_t n_buffers)
+{
+  uint8_t *data = xnmalloc (MAX (n_nodes, n_buffers), 16);
+  uint32_t nodes_vector, buffers_vector;
+  uint64_t offset;
+  size_t i;
+
+  for (i = 0; i < n_nodes; i++)
+    {
+      integer_put (n_rows, INTEGER_LSB_FIRST, &data[i * 16], 8);
+      integer_put (null_counts[i], INTEGER_LSB_FIRST, &data[i * 16 + 8], 8);
+    }
+  nodes_vector = fb_create_vector (&w->fb, data, 16, n_nodes, 8);
+
+  offset = 0;
+  for (i = 0; i < n_buffers; i++)
+    {
+      integer_put (offset, INTEGER_LSB_FIRST, &data[i * 16], 8);
+      integer_put (buffers[i].size, INTEGER_LSB_FIRST, &data[i * 16 + 8], 8);
+      offset += ROUND_UP (buffers[i].size, 8);
+    }
+  buffers_vector = fb_create_vector (&w->fb, data, 16, n_buffers, 8);
+
+  free (data);
+
+  fb_start_table (&w->fb, ARROW_RECORD_BATCH_N_FIELDS);
+  fb_add_i64 (&w->fb, ARROW_RECORD_BATCH_LENGTH, n_rows);
+  fb_add_offset (&w->fb, ARROW_RECORD_BATCH_NODES, nodes_vector);
+  fb_add_offset (&w->fb, ARROW_RECORD_BATCH_BUFFERS, buffers_vector);
+  return fb_end_table (&w->fb);
+}
+
+/* Writes an encapsulated message to W.  HEADER_TYPE and HEADER identify the
+   message header, and METADATA the message's custom metadata vector (or 0 for
+   none), which must already have been added to W's flatbuffer.  The message
+   body consists of the N_BUFFERS buffers in BUFFERS.
+
+   If BLOCK is nonnull, stores the message's location into it. */
+static void
+write_message (struct arrow_writer *w, int header_type, uint32_t header,
+               uint32_t custom_metadata,
+               const struct arrow_buffer *buffers, size_t n_buffers,
+               struct arrow_block *block)
+{
+  uint64_t body_len;
+  const void *metadata;
+  size_t metadata_len;
+  uint32_t message;
+  size_t i;
+
+  body_len = 0;
+  for (i = 0; i < n_buffers; i++)
+    body_len += ROUND_UP (buffers[i].size, 8);
+
+  fb_start_table (&w->fb, ARROW_MESSAGE_N_FIELDS);
+  fb_add_i16 (&w->fb, ARROW_MESSAGE_VERSION, ARROW_METADATA_V5);
+  fb_add_u8 (&w->fb, ARROW_MESSAGE_HEADER_TYPE, header_type);
+  fb_add_offset (&w->fb, ARROW_MESSAGE_HEADER, header);
+  fb_add_i64 (&w->fb, ARROW_MESSAGE_BODY_LENGTH, body_len);
+  fb_add_offset (&w->fb, ARROW_MESSAGE_CUSTOM_METADATA, custom_metadata);
+  message = fb_end_table (&w->fb);
+  metadata = fb_finish (&w->fb, message, &metadata_len);
+
+  if (block != NULL)
+    {
+      block->offset = w->pos;
+      block->metadata_len = 8 + ROUND_UP (metadata_len, 8);
+      block->body_len = body_len;
+    }
+
+  write_u32 (w, ARROW_CONTINUATION);
+  write_u32 (w, ROUND_UP (metadata_len, 8));
+  write_bytes (w, metadata, metadata_len);
+  write_padding (w);
+  fb_builder_clear (&w->fb);
+
+  for (i = 0; i < n_buffers; i++)
+    {
+      write_bytes (w, buffers[i].data, buffers[i].size);
+      write_padding (w);
+    }
+}
+
+/* Writes the magic number and the schema that begin an Arrow file to W. */
+static void
+write_schema_message (struct arrow_writer *w)
+{
+  static const uint8_t magic[8] = ARROW_MAGIC;
+
+  write_bytes (w, magic, sizeof magic);
+  write_message (w, ARROW_HEADER_SCHEMA, create_schema (w), 0, NULL, 0, NULL);
+}
+
+#ifdef WORDS_BIGENDIAN
+/* Converts the N native-endian integers of SIZE bytes each in DATA to the
+   little-endian byte order that Arrow files use. */
+static void
+convert_to_lsb (void *data, size_t n, size_t size)
+{
+  uint8_t *p;
+
+  for (p = data; n-- > 0; p += size)
+    integer_convert (INTEGER_NATIVE, p, INTEGER_LSB_FIRST, p, size);
+}
+#endif
+
+/* Adds to W's flatbuffer a custom metadata vector that gives the range of
+   values of each variable in the record batch under construction, and
+   returns its offset. */
+static uint32_t
+create_range_metadata (struct arrow_writer *w)
+{
+  struct string s;
+  uint32_t kv;
+  size_t i;
+
+  ds_init_empty (&s);
+  for (i = 0; i < w->n_vars; i++)
+    {
+      const struct arrow_var *av = &w->vars[i];
+
+      if (i > 0)
+        ds_put_byte (&s, ' ');
+      if (av->min <= av->max)
+        {
+          char buf[64];
+
+          c_dtoastr (buf, sizeof buf, 0, 0, av->min);
+          ds_put_format (&s, "%s:", buf);
+          c_dtoastr (buf, sizeof buf, 0, 0, av->max);
+          ds_put_cstr (&s, buf);
+        }
+      else
+        ds_put_byte (&s, '-');
+    }
+  kv = create_key_value (w, ARROW_KEY_RANGE, ds_cstr (&s));
+  ds_destroy (&s);
+
+  return fb_create_offset_vector (&w->fb, &kv, 1);
+}
+
+/* Writes the cases accumulated in W as a record batch, and then starts a new,
+   empty batch. */
+static void
+write_batch (struct arrow_writer *w)
+{
+  struct arrow_buffer *buffers;
+  uint32_t batch, metadata;
+  size_t *null_counts;
+  size_t i;
+
+  buffers = xnmalloc (w->n_vars, 2 * sizeof *buffers);
+  null_counts = xnmalloc (w->n_vars, sizeof *null_counts);
+  for (i = 0; i < w->n_vars; i++)
+    {
+      struct arrow_var *av = &w->vars[i];
+      size_t value_size = arrow_var_value_size (av);
+
+#ifdef WORDS_BIGENDIAN
+      if (arrow_var_is_dict_encoded (av) || av->width == 0)
+        convert_to_lsb (av->data, w->n_cases, value_size);
+#endif
+
+      /* The validity bitmap may be omitted if there are no nulls. */
+      buffers[i * 2].data = av->validity;
+      buffers[i * 2].size = av->n_nulls ? DIV_RND_UP (w->n_cases, 8) : 0;
+      buffers[i * 2 + 1].data = av->data;
+      buffers[i * 2 + 1].size = w->n_cases * value_size;
+
+      null_counts[i] = av->n_nulls;
+    }
+
+  if (w->n_batches >= w->allocated_batches)
+    w->batches = x2nrealloc (w->batches, &w->allocated_batches,
+                             sizeof *w->batches);
+  batch = create_record_batch (w, w->n_cases, null_counts, w->n_vars,
+                               buffers, w->n_vars * 2);
+  metadata = create_range_metadata (w);
+  write_message (w, ARROW_HEADER_RECORD_BATCH, batch, metadata,
+                 buffers, w->n_vars * 2, &w->batches[w->n_batches++]);
+
+  free (null_counts);
+  free (buffers);
+
+  for (i = 0; i < w->n_vars; i++)
+    {
+      struct arrow_var *av = &w->vars[i];
+
+      av->n_nulls = 0;
+      av->min = HUGE_VAL;
+      av->max = -HUGE_VAL;
+    }
+  w->n_cases = 0;
+}
+
+/* Writes the dictionary for dictionary-encoded variable AV, which is the
+   IDXth variable in W, to W, and stores its location in BLOCK. */
+static void
+write_dictionary (struct arrow_writer *w, const struct arrow_var *av,
+                  size_t idx, struct arrow_block *block)
+{
+  struct arrow_buffer buffers[3];
+  size_t null_count = 0;
+  uint32_t batch, header;
+  int32_t *offsets;
+  struct string s;
+  size_t i;
+
+  offsets = xnmalloc (av->n_strings + 1, sizeof *offsets);
+  ds_init_empty (&s);
+  for (i = 0; i < av->n_strings; i++)
+    {
+      offsets[i] = ds_length (&s);
+      ds_put_cstr (&s, av->strings[i]);
+    }
+  offsets[i] = ds_length (&s);
+#ifdef WORDS_BIGENDIAN
+  convert_to_lsb (offsets, av->n_strings + 1, sizeof *offsets);
+#endif
+
+  buffers[0].data = NULL;
+  buffers[0].size = 0;
+  buffers[1].data = offsets;
+  buffers[1].size = (av->n_strings + 1) * sizeof *offsets;
+  buffers[2].data = ds_data (&s);
+  buffers[2].size = ds_length (&s);
+
+  batch = create_record_batch (w, av->n_strings, &null_count, 1, buffers, 3);
+  fb_start_table (&w->fb, ARROW_DICTIONARY_BATCH_N_FIELDS);
+  fb_add_i64 (&w->fb, ARROW_DICTIONARY_BATCH_ID, idx);
+  fb_add_offset (&w->fb, ARROW_DICTIONARY_BATCH_DATA, batch);
+  header = fb_end_table (&w->fb);
+  write_message (w, ARROW_HEADER_DICTIONARY_BATCH, header, 0, buffers, 3,
+                 block);
+
+  ds_destroy (&s);
+  free (offsets);
+}
+
+/* Writes the dictionaries and the footer that end an Arrow file to W.
+
+   The dictionaries are written after all the record batches, because they
+   are not complete until then.  This is allowed in the Arrow file format,
+   whose readers locate dictionaries through the footer. */
+static void
+write_footer (struct arrow_writer *w)
+{
+  static const uint8_t magic[ARROW_MAGIC_LEN] = ARROW_MAGIC;
+  struct arrow_block *dictionaries;
+  uint32_t schema, dictionaries_vector, batches_vector, footer;
+  size_t n_dictionaries;
+  const void *data;
+  size_t size;
+  size_t i;
+
+  dictionaries = xnmalloc (w->n_vars, sizeof *dictionaries);
+  n_dictionaries = 0;
+  for (i = 0; i < w->n_vars; i++)
+    if (arrow_var_is_dict_encoded (&w->vars[i]))
+      write_dictionary (w, &w->vars[i], i, &dictionaries[n_dictionaries++]);
+
+  /* End-of-stream marker. */
+  write_u32 (w, ARROW_CONTINUATION);
+  write_u32 (w, 0);
+
+  schema = create_schema (w);
+  dictionaries_vector = create_block_vector (w, dictionaries, n_dictionaries);
+  batches_vector = create_block_vector (w, w->batches, w->n_batches);
+  fb_start_table (&w->fb, ARROW_FOOTER_N_FIELDS);
+  fb_add_i16 (&w->fb, ARROW_FOOTER_VERSION, ARROW_METADATA_V5);
+  fb_add_offset (&w->fb, ARROW_FOOTER_SCHEMA, schema);
+  fb_add_offset (&w->fb, ARROW_FOOTER_DICTIONARIES, dictionaries_vector);
+  fb_add_offset (&w->fb, ARROW_FOOTER_RECORD_BATCHES, batches_vector);
+  footer = fb_end_table (&w->fb);
+  data = fb_finish (&w->fb, footer, &size);
+
+  write_bytes (w, data, size);
+  write_u32 (w, size);
+  write_bytes (w, magic, sizeof magic);
+
+  free (dictionaries);
+}
+
+/* Returns the index of the string S in dictionary-encoded variable AV,
+   adding it to the dictionary if it is not already there. */
+static int32_t
+arrow_var_intern (struct arrow_var *av, const char *s)
+{
+  unsigned int hash = hash_string (s, 0);
+  struct arrow_dict_entry *entry;
+
+  HMAP_FOR_EACH_WITH_HASH (entry, struct arrow_dict_entry, hmap_node, hash,
+                           &av->dict_map)
+    if (!strcmp (av->strings[entry->index], s))
+      return entry->index;
+
+  if (av->n_strings >= av->allocated_strings)
+    av->strings = x2nrealloc (av->strings, &av->allocated_strings,
+                              sizeof *av->strings);
+  av->strings[av->n_strings] = xstrdup (s);
+
+  entry = xmalloc (sizeof *entry);
+  entry->index = av->n_strings++;
+  hmap_insert (&av->dict_map, &entry->hmap_node, hash);
+
+  return entry->index;
+}
+
+/* Stores the dictionary index for VALUE of dictionary-encoded variable AV
+   into *INDEX.  Returns false if VALUE should be written as a null, true
+   otherwise. */
+static bool
+arrow_var_encode (struct arrow_writer *w, struct arrow_var *av,
+                  const union value *value, int32_t *index)
+{
+  const char *label = val_labs_find (av->val_labs, value);
+  if (label != NULL)
+    *index = arrow_var_intern (av, label);
+  else if (av->width == 0 && value->f == SYSMIS)
+    return false;
+  else
+    {
+      char *s = data_out (value, w->encoding, &av->format);
+      struct substring ss = ss_cstr (s);
+
+      if (av->format.type != FMT_A)
+        ss_trim (&ss, ss_cstr (" "));
+      else
+        ss_rtrim (&ss, ss_cstr (" "));
+      ss.string[ss.length] = '\0';
+      *index = arrow_var_intern (av, ss.string);
+      free (s);
+    }
+  return true;
+}
+
+/* Adds VALUE as the value of AV in the IDXth case in the current batch. */
+static void
+arrow_var_put (struct arrow_writer *w, struct arrow_var *av, size_t idx,
+               const union value *value)
+{
+  uint8_t *validity = &av->validity[idx / 8];
+  uint8_t bit = 1u << (idx % 8);
+  bool is_null;
+
+  if (idx % 8 == 0)
+    *validity = 0;
+
+  if (mv_is_value_missing (&av->missing, value, MV_USER))
+    is_null = true;
+  else if (arrow_var_is_dict_encoded (av))
+    is_null = !arrow_var_encode (w, av, value, (int32_t *) av->data + idx);
+  else if (av->width == 0)
+    {
+      is_null = value->f == SYSMIS;
+      ((double *) av->data)[idx] = is_null ? 0 : value->f;
+      if (!is_null)
+        {
+          if (value->f < av->min)
+            av->min = value->f;
+          if (value->f > av->max)
+            av->max = value->f;
+        }
+    }
+  else
+    {
+      memcpy ((uint8_t *) av->data + idx * av->width,
+              value_str (value, av->width), av->width);
+      is_null = false;
+    }
+
+  if (!is_null)
+    *validity |= bit;
+  else
+    {
+      if (arrow_var_is_dict_encoded (av))
+        ((int32_t *) av->data)[idx] = 0;
+      else if (av->width > 0)
+        memset ((uint8_t *) av->data + idx * av->width, 0, av->width);
+      av->n_nulls++;
+    }
+}
+
+/* Writes case C to Arrow file W. */
+static void
+arrow_file_casewriter_write (struct casewriter *writer, void *w_,
+                             struct ccase *c)
+{
+  struct arrow_writer *w = w_;
+  size_t i;
+
+  if (ferror (w->file))
+    {
+      casewriter_force_error (writer);
+      case_unref (c);
+      return;
+    }
+
+  for (i = 0; i < w->n_vars; i++)
+    {
+      struct arrow_var *av = &w->vars[i];
+      arrow_var_put (w, av, w->n_cases, case_data_idx (c, av->case_index));
+    }
+  case_unref (c);
+
+  if (++w->n_cases >= w->batch_cases)
+    write_batch (w);
+}
+
+/* Destroys Arrow file writer W. */
+static void
+arrow_file_casewriter_destroy (struct casewriter *writer, void *w_)
+{
+  struct arrow_writer *w = w_;
+
+  if (w->n_cases > 0)
+    write_batch (w);
+  write_footer (w);
+
+  if (!close_writer (w))
+    casewriter_force_error (writer);
+}
+
+/* Returns true if an I/O error has occurred on WRITER, false otherwise. */
+static bool
+write_error (const struct arrow_writer *writer)
+{
+  return ferror (writer->file);
+}
+
+/* Closes an Arrow file after we're done with it.
+   Returns true if successful, false if an I/O error occurred. */
+static bool
+close_writer (struct arrow_writer *w)
+{
+  size_t i;
+  bool ok;
+
+  if (w == NULL)
+    return true;
+
+  ok = true;
+  if (w->file != NULL)
+    {
+      if (write_error (w))
+        ok = false;
+      if (fclose (w->file) == EOF)
+        ok = false;
+
+      if (!ok)
+        msg (ME, _("An I/O error occurred writing Arrow file `%s'."),
+             fh_get_file_name (w->fh));
+
+      if (ok ? !replace_file_commit (w->rf) : !replace_file_abort (w->rf))
+        ok = false;
+    }
+
+  fh_unlock (w->lock);
+  fh_unref (w->fh);
+
+  free (w->encoding);
+
+  for (i = 0; i < w->n_vars; i++)
+    {
+      struct arrow_var *av = &w->vars[i];
+      struct arrow_dict_entry *entry, *next;
+      size_t j;
+
+      mv_destroy (&av->missing);
+      val_labs_destroy (av->val_labs);
+      free (av->name);
+      free (av->label);
+      free (av->validity);
+      free (av->data);
+
+      HMAP_FOR_EACH_SAFE (entry, next, struct arrow_dict_entry, hmap_node,
+                          &av->dict_map)
+        {
+          hmap_delete (&av->dict_map, &entry->hmap_node);
+          free (entry);
+        }
+      hmap_destroy (&av->dict_map);
+      for (j = 0; j < av->n_strings; j++)
+        free (av->strings[j]);
+      free (av->strings);
+    }
+  free (w->vars);
+
+  free (w->batches);
+  fb_builder_uninit (&w->fb);
+  free (w);
+
+  return ok;
+}
+
+/* Arrow file writer casewriter class. */
+static const struct casewriter_class arrow_file_casewriter_class =
+  {
+    arrow_file_casewriter_write,
+    arrow_file_casewriter_destroy,
+    NULL,
+  };
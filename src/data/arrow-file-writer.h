@@ -0,0 +1,41 @@
+/* PSPP - a program for statistical analysis.
+   Copyright (C) 2017 Free Software Foundation, Inc.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+#ifndef ARROW_FILE_WRITER_H
+#define ARROW_FILE_WRITER_H 1
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Writing Apache Arrow IPC (Feather version 2) files. */
+
+/* Options for creating Arrow files. */
+struct arrow_writer_options
+  {
+    bool recode_user_missing;   /* Write user-missing values as nulls? */
+    bool use_value_labels;      /* Dictionary-encode labelled variables? */
+    size_t batch_cases;         /* Cases per record batch, 0 for default. */
+  };
+
+void arrow_writer_options_init (struct arrow_writer_options *);
+
+struct file_handle;
+struct dictionary;
+struct casewriter *arrow_writer_open (struct file_handle *,
+                                      const struct dictionary *,
+                                      const struct arrow_writer_options *);
+
+#endif /* arrow-file-writer.h */
@@ -9,6 +9,11 @@ src_data_libdata_la_SOURCES = \
 	src/data/any-reader.h \
 	src/data/any-writer.c \
 	src/data/any-writer.h \
+	src/data/arrow-file-reader.c \
+	src/data/arrow-file-reader.h \
+	src/data/arrow-file-private.h \
+	src/data/arrow-file-writer.c \
+	src/data/arrow-file-writer.h \
 	src/data/attributes.c \
 	src/data/attributes.h \
 	src/data/calendar.c \
@@ -285,3 +285,10 @@ caseinit_update_left_vars (struct caseinit *ci, const struct ccase *c)
   init_list_update (&ci->left_values, c);
 }
 
+/* Returns true if CI copies the values of any "left" variables from one
+   case to the next, false otherwise. */
+bool
+caseinit_has_left_vars (const struct caseinit *ci)
+{
+  return ci->left_values.cnt > 0;
+}
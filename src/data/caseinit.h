@@ -31,6 +31,8 @@
 #ifndef DATA_CASEINIT_H
 #define DATA_CASEINIT_H 1
 
+#include <stdbool.h>
+
 struct dictionary;
 struct ccase;
 
@@ -47,5 +49,6 @@ void caseinit_mark_for_init (struct caseinit *, const struct dictionary *);
 /* Initialize data and copy data from case to case. */
 void caseinit_init_vars (const struct caseinit *, struct ccase *);
 void caseinit_update_left_vars (struct caseinit *, const struct ccase *);
+bool caseinit_has_left_vars (const struct caseinit *);
 
 #endif /* data/caseinit.h */
@@ -20,6 +20,7 @@
 
 #include <ctype.h>
 #include <errno.h>
+#include <float.h>
 #include <limits.h>
 #include <math.h>
 #include <stdarg.h>
@@ -43,6 +44,7 @@
 #include "value.h"
 
 #include "gl/c-ctype.h"
+#include "gl/c-strcase.h"
 #include "gl/c-strtod.h"
 #include "gl/minmax.h"
 #include "gl/xalloc.h"
@@ -69,7 +71,26 @@ static void default_result (struct data_in *);
 static bool trim_spaces_and_check_missing (struct data_in *);
 
 static int hexit_value (int c);
+static bool parse_plain_number (struct substring, enum fmt_type, double *);
+static bool is_ascii_superset (const char *encoding);
 
+/* Parses I->input, which must already be in the encoding that I->format
+   expects, into I->output. */
+static char *
+data_in_parse (struct data_in *i)
+{
+  static data_in_parser_func *const handlers[FMT_NUMBER_OF_FORMATS] =
+    {
+#define FMT(NAME, METHOD, IMIN, OMIN, IO, CATEGORY) parse_##METHOD,
+#include "format.def"
+    };
+
+  char *error = handlers[i->format] (i);
+  if (error != NULL)
+    default_result (i);
+  return error;
+}
+
 /* Parses the characters in INPUT, which are encoded in the given
    INPUT_ENCODING, according to FORMAT.
 
@@ -86,12 +107,6 @@ data_in (struct substring input, const char *input_encoding,
          enum fmt_type format,
          union value *output, int width, const char *output_encoding)
 {
-  static data_in_parser_func *const handlers[FMT_NUMBER_OF_FORMATS] =
-    {
-#define FMT(NAME, METHOD, IMIN, OMIN, IO, CATEGORY) parse_##METHOD,
-#include "format.def"
-    };
-
   struct data_in i;
 
   enum fmt_category cat;
@@ -112,6 +127,10 @@ data_in (struct substring input, const char *input_encoding,
       return NULL;
     }
 
+  if (is_ascii_superset (input_encoding)
+      && parse_plain_number (input, format, &output->f))
+    return NULL;
+
   cat = fmt_get_category (format);
   if (cat & (FMT_CAT_BASIC | FMT_CAT_HEXADECIMAL
              | FMT_CAT_DATE | FMT_CAT_TIME | FMT_CAT_DATE_COMPONENT))
@@ -154,15 +173,46 @@ data_in (struct substring input, const char *input_encoding,
       s = NULL;
     }
 
-  error = handlers[i.format] (&i);
-  if (error != NULL)
-    default_result (&i);
+  error = data_in_parse (&i);
 
   free (s);
 
   return error;
 }
 
+/* Like data_in(), but for input that needs no recoding: either FORMAT is a
+   binary or legacy format, or INPUT consists entirely of ASCII characters in
+   an ASCII-compatible encoding and, if FORMAT is a string format, the output
+   encoding is also ASCII-compatible.
+
+   data_in() recodes its input through a shared cache of iconv converters.
+   This function does not, so it may be called from more than one thread at a
+   time. */
+char *
+data_in_ascii (struct substring input, enum fmt_type format,
+               union value *output, int width)
+{
+  struct data_in i;
+
+  assert ((width != 0) == fmt_is_string (format));
+
+  i.input = input;
+  i.format = format;
+  i.output = output;
+  i.width = width;
+
+  if (ss_is_empty (input))
+    {
+      default_result (&i);
+      return NULL;
+    }
+
+  if (parse_plain_number (input, format, &output->f))
+    return NULL;
+
+  return data_in_parse (&i);
+}
+
 bool
 data_in_msg (struct substring input, const char *input_encoding,
              enum fmt_type format,
@@ -274,6 +324,102 @@ data_in_imply_decimals (struct substring input, const char *input_encoding,
     output->f /= pow (10., d);
 }
 
+/* Returns true if ENCODING, which may be null to indicate the default
+   encoding, is known to encode ASCII characters the same way as ASCII, so
+   that ASCII input need not be recoded before parsing.  This only checks
+   the encoding's name, because asking iconv would take longer than the
+   recoding that it is meant to avoid, so it will not recognize every such
+   encoding. */
+static bool
+is_ascii_superset (const char *encoding)
+{
+  if (encoding == NULL)
+    encoding = get_default_encoding ();
+  return (is_encoding_utf8 (encoding)
+          || !c_strcasecmp (encoding, "ASCII")
+          || !c_strcasecmp (encoding, "US-ASCII")
+          || !c_strncasecmp (encoding, "ISO-8859-", 9)
+          || !c_strncasecmp (encoding, "windows-125", 11));
+}
+
+/* Powers of 10 that are exactly representable as doubles. */
+static const double exact_powers_of_10[] =
+  {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+
+/* Fast path for the most common kind of numeric input: if INPUT, which
+   must be in an ASCII-compatible encoding, is a plain decimal number for
+   F, COMMA, or DOT format FORMAT, that is, optional spaces, an optional
+   sign, digits with an optional decimal point, and optional spaces, with
+   at most 15 or so significant digits, stores its value in *NUMBER and
+   returns true.  Otherwise, returns false without modifying *NUMBER, and
+   the caller must use the general-purpose parser.
+
+   A decimal number with an integer significand S of at most 2**53 and F
+   digits after the decimal point, with F <= 22, is exactly S / 10**F.  S
+   and 10**F are both exactly representable as doubles, so one correctly
+   rounded IEEE division yields the same result as c_strtod().  This is
+   "Clinger's fast path". */
+static bool
+parse_plain_number (struct substring input, enum fmt_type format,
+                    double *number)
+{
+#if FLT_EVAL_METHOD == 0
+  const char *p = ss_data (input);
+  const char *end = ss_end (input);
+  uint64_t significand = 0;
+  bool any_digits = false;
+  bool negative = false;
+  bool seen_point = false;
+  size_t frac_digits = 0;
+  double x;
+
+  if (format != FMT_F && format != FMT_COMMA && format != FMT_DOT)
+    return false;
+
+  while (p < end && *p == ' ')
+    p++;
+  while (p < end && end[-1] == ' ')
+    end--;
+
+  if (p < end && (*p == '-' || *p == '+'))
+    negative = *p++ == '-';
+
+  for (; p < end; p++)
+    {
+      if (*p >= '0' && *p <= '9')
+        {
+          if (significand >= UINT64_C (1) << 53)
+            return false;
+          significand = significand * 10 + (*p - '0');
+          any_digits = true;
+          frac_digits += seen_point;
+        }
+      else if (!seen_point && *p == settings_get_style (format)->decimal)
+        seen_point = true;
+      else
+        return false;
+    }
+
+  if (!any_digits
+      || significand > UINT64_C (1) << 53
+      || frac_digits >= sizeof exact_powers_of_10 / sizeof *exact_powers_of_10)
+    return false;
+
+  x = significand;
+  if (frac_digits > 0)
+    x /= exact_powers_of_10[frac_digits];
+  *number = negative ? -x : x;
+  return true;
+#else
+  /* Arithmetic in extended precision can round twice, so the above might
+     not be correctly rounded. */
+  return false;
+#endif
+}
+
 /* Format parsers. */
 
 /* Parses F, COMMA, DOT, DOLLAR, PCT, and E input formats. */
@@ -28,6 +28,9 @@ char *data_in (struct substring input, const char *input_encoding,
                enum fmt_type,
                union value *output, int width, const char *output_encoding);
 
+char *data_in_ascii (struct substring input, enum fmt_type,
+                     union value *output, int width);
+
 bool data_in_msg (struct substring input, const char *input_encoding,
                   enum fmt_type,
                   union value *output, int width, const char *output_encoding);
@@ -63,6 +63,8 @@ static int rounder_width (const struct rounder *, int decimals,
                           int *integer_digits, bool *negative);
 static void rounder_format (const struct rounder *, int decimals,
                             char *output);
+static bool scale_decimal (double number, int k, uint64_t *n);
+static int format_uint64 (uint64_t, int min_digits, char *output);
 
 typedef void data_out_converter_func (const union value *,
                                       const struct fmt_spec *,
@@ -745,6 +747,67 @@ output_decimal (const struct rounder *r, const struct fmt_spec *format,
   return false;
 }
 
+/* Tries to format NUMBER, which must be nonnegative, into OUTPUT in
+   scientific notation with FRACTION_WIDTH characters for the decimal point
+   (DECIMAL) and the digits that follow it, or no decimal point at all if
+   FRACTION_WIDTH is 0, followed by an exponent with a sign and exactly three
+   digits.  The result is identical to what output_scientific() would produce
+   with c_snprintf, but much faster to obtain.  Returns true if successful,
+   false if NUMBER is too large or too small for scale_decimal() to handle
+   exactly. */
+static bool
+format_scientific (double number, int fraction_width, char decimal,
+                   char *output)
+{
+  int n_digits = MAX (fraction_width, 1);
+  uint64_t limit, n;
+  char digits[20];
+  char *p;
+  int exponent, k, i;
+
+  limit = 1;
+  for (i = 0; i < n_digits; i++)
+    limit *= 10;
+
+  /* Find K such that NUMBER * 10**K, rounded, has exactly N_DIGITS digits.
+     The initial estimate is based on the binary exponent of NUMBER and is
+     off by at most one. */
+  if (number != 0)
+    {
+      frexp (number, &exponent);
+      k = n_digits - 1 - (int) floor ((exponent - 1) * 0.30102999566398120);
+    }
+  else
+    k = n_digits - 1;
+  for (;;)
+    {
+      if (!scale_decimal (number, k, &n))
+        return false;
+      else if (n >= limit)
+        k--;
+      else if (n < limit / 10 && number != 0)
+        k++;
+      else
+        break;
+    }
+  exponent = n_digits - 1 - k;
+
+  format_uint64 (n, n_digits, digits);
+  p = output;
+  *p++ = digits[0];
+  if (fraction_width > 0)
+    {
+      *p++ = decimal;
+      p = mempcpy (p, &digits[1], n_digits - 1);
+    }
+  *p++ = 'E';
+  *p++ = exponent < 0 ? '-' : '+';
+  p += format_uint64 (abs (exponent), 3, p);
+  *p = '\0';
+
+  return true;
+}
+
 /* Formats NUMBER into OUTPUT in scientific notation according to
    the style of the format specified in FORMAT. */
 static bool
@@ -787,28 +850,31 @@ output_scientific (double number, const struct fmt_spec *format,
     p = stpcpy (p, style->neg_prefix.s);
   if (add_affixes)
     p = stpcpy (p, style->prefix.s);
-  if (fraction_width > 0)
-    c_snprintf (p, 64, "%#.*E", fraction_width - 1, fabs (number));
-  else
-    c_snprintf (p, 64, "%.0E", fabs (number));
-
-  /* The C locale always uses a period `.' as a decimal point.
-     Translate to comma if necessary. */
-  if (style->decimal != '.')
+  if (!format_scientific (fabs (number), fraction_width, style->decimal, p))
     {
-      char *cp = strchr (p, '.');
-      if (cp != NULL)
-        *cp = style->decimal;
-    }
+      if (fraction_width > 0)
+        c_snprintf (p, 64, "%#.*E", fraction_width - 1, fabs (number));
+      else
+        c_snprintf (p, 64, "%.0E", fabs (number));
 
-  /* Make exponent have exactly three digits, plus sign. */
-  {
-    char *cp = strchr (p, 'E') + 1;
-    long int exponent = strtol (cp, NULL, 10);
-    if (abs (exponent) > 999)
-      return false;
-    sprintf (cp, "%+04ld", exponent);
-  }
+      /* The C locale always uses a period `.' as a decimal point.
+         Translate to comma if necessary. */
+      if (style->decimal != '.')
+        {
+          char *cp = strchr (p, '.');
+          if (cp != NULL)
+            *cp = style->decimal;
+        }
+
+      /* Make exponent have exactly three digits, plus sign. */
+      {
+        char *cp = strchr (p, 'E') + 1;
+        long int exponent = strtol (cp, NULL, 10);
+        if (abs (exponent) > 999)
+          return false;
+        sprintf (cp, "%+04ld", exponent);
+      }
+    }
 
   /* Add suffixes. */
   p = strchr (p, '\0');
@@ -837,6 +903,156 @@ should_round_up (const struct rounder *r, int decimals)
   return digit >= '5';
 }
 
+/* Sets *N to the magnitude of NUMBER times 10**K, rounded to the nearest
+   integer, with ties rounded to even, which is what c_snprintf does when it
+   formats NUMBER to K decimal places.  Returns true if successful, false if
+   K is not between 0 and 18 or the result does not fit in 64 bits.
+
+   The result is exact: NUMBER is split into an integer significand and a
+   binary exponent, the significand is multiplied by 5**K in 128-bit
+   arithmetic (using pairs of 64-bit integers), and then the product is
+   shifted left or right by the binary exponent plus K. */
+static bool
+scale_decimal (double number, int k, uint64_t *n)
+{
+  static const uint64_t powers_of_5[] =
+    {
+      UINT64_C (1), UINT64_C (5), UINT64_C (25), UINT64_C (125),
+      UINT64_C (625), UINT64_C (3125), UINT64_C (15625), UINT64_C (78125),
+      UINT64_C (390625), UINT64_C (1953125), UINT64_C (9765625),
+      UINT64_C (48828125), UINT64_C (244140625), UINT64_C (1220703125),
+      UINT64_C (6103515625), UINT64_C (30517578125),
+      UINT64_C (152587890625), UINT64_C (762939453125),
+      UINT64_C (3814697265625),
+    };
+  uint64_t significand, a, b, c0, c1, lo0, mid, lo, hi, q;
+  bool round_bit, sticky;
+  int exponent, shift;
+
+  if (FLT_RADIX != 2 || DBL_MANT_DIG > 53
+      || k < 0 || k >= sizeof powers_of_5 / sizeof *powers_of_5)
+    return false;
+
+  number = fabs (number);
+  if (number == 0)
+    {
+      *n = 0;
+      return true;
+    }
+
+  /* NUMBER == SIGNIFICAND * 2**EXPONENT, exactly. */
+  significand = ldexp (frexp (number, &exponent), DBL_MANT_DIG);
+  exponent -= DBL_MANT_DIG;
+
+  /* HI:LO = SIGNIFICAND * 5**K.  SIGNIFICAND is less than 2**53 and 5**K is
+     less than 2**42, so none of the partial products overflow. */
+  a = significand >> 32;
+  b = significand & 0xffffffff;
+  c1 = powers_of_5[k] >> 32;
+  c0 = powers_of_5[k] & 0xffffffff;
+  lo0 = b * c0;
+  mid = a * c0 + b * c1;
+  lo = lo0 + (mid << 32);
+  hi = a * c1 + (mid >> 32) + (lo < lo0);
+
+  /* Multiply HI:LO by 2**-SHIFT. */
+  shift = -(exponent + k);
+  if (shift <= 0)
+    {
+      if (hi != 0 || shift < -63 || (shift < 0 && lo >> (64 + shift) != 0))
+        return false;
+      *n = lo << -shift;
+      return true;
+    }
+  else if (shift >= 96)
+    {
+      /* HI:LO < 2**95, so the result rounds to zero. */
+      *n = 0;
+      return true;
+    }
+  else if (shift < 64)
+    {
+      if (hi >> shift != 0)
+        return false;
+      q = (lo >> shift) | (hi << (64 - shift));
+      round_bit = (lo >> (shift - 1)) & 1;
+      sticky = (lo & ((UINT64_C (1) << (shift - 1)) - 1)) != 0;
+    }
+  else if (shift == 64)
+    {
+      q = hi;
+      round_bit = lo >> 63;
+      sticky = (lo << 1) != 0;
+    }
+  else
+    {
+      q = hi >> (shift - 64);
+      round_bit = (hi >> (shift - 65)) & 1;
+      sticky = (lo != 0
+                || (hi & ((UINT64_C (1) << (shift - 65)) - 1)) != 0);
+    }
+
+  if (round_bit && (sticky || q & 1))
+    {
+      if (q == UINT64_MAX)
+        return false;
+      q++;
+    }
+  *n = q;
+  return true;
+}
+
+/* Writes N to OUTPUT in decimal, padded with leading zeros to at least
+   MIN_DIGITS digits (at most 20), and returns the number of digits written.
+   No terminating null is appended. */
+static int
+format_uint64 (uint64_t n, int min_digits, char *output)
+{
+  char buf[20];
+  int n_digits = 0;
+
+  assert (min_digits <= sizeof buf);
+  do
+    {
+      buf[sizeof buf - ++n_digits] = '0' + n % 10;
+      n /= 10;
+    }
+  while (n != 0 || n_digits < min_digits);
+  memcpy (output, &buf[sizeof buf - n_digits], n_digits);
+  return n_digits;
+}
+
+/* Tries to store into R->string the magnitude of NUMBER formatted the same
+   way that rounder_init() would format it with c_snprintf, but without
+   calling it.  Returns true if successful, false if NUMBER is too large or
+   too precise for that or if rounder_init() would need to take a second
+   round to break a tie. */
+static bool
+rounder_format_exact (struct rounder *r, double number, int max_decimals)
+{
+  int k = max_decimals + 2;
+  uint64_t n;
+  int len;
+
+  if (max_decimals == 0)
+    {
+      double rounded = round (fabs (number));
+      if (rounded >= 18446744073709551616.0) /* 2**64. */
+        return false;
+      len = format_uint64 (rounded, 1, r->string);
+      strcpy (&r->string[len], ".00");
+      return true;
+    }
+
+  if (!scale_decimal (number, k, &n) || n % 100 == 50)
+    return false;
+  len = format_uint64 (n, k + 1, r->string);
+  memmove (&r->string[len - k + 1], &r->string[len - k], k);
+  r->string[len - k] = '.';
+  r->string[len + 1] = '\0';
+  return true;
+}
+
 /* Initializes R for formatting the magnitude of NUMBER to no
    more than MAX_DECIMAL decimal places. */
 static void
@@ -844,7 +1060,12 @@ rounder_init (struct rounder *r, double number, int max_decimals)
 {
   assert (fabs (number) < 1e41);
   assert (max_decimals >= 0 && max_decimals <= 16);
-  if (max_decimals == 0)
+  if (rounder_format_exact (r, number, max_decimals))
+    {
+      /* Fastest path.  The digits were obtained exactly from the binary
+         representation of NUMBER, without the help of c_snprintf. */
+    }
+  else if (max_decimals == 0)
     {
       /* Fast path.  No rounding needed.
 
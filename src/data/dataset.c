@@ -70,6 +70,10 @@ struct dataset {
   struct trns_chain *temporary_trns_chain;
   struct dictionary *dict;
 
+  /* True if dataset_begin_dict_batch() has started a batch of changes to
+     dict that has not yet ended. */
+  bool dict_batch;
+
   /* If true, cases are discarded instead of being written to
      sink. */
   bool discard_output;
@@ -101,6 +105,12 @@ struct dataset {
   proc_state;
   casenumber cases_written;     /* Cases output so far. */
   bool ok;                      /* Error status. */
+
+  /* If the transformations can all execute on batches of cases, the
+     transformed cases not yet passed to the procedure, as batch[batch_ofs]
+     through batch[batch_cnt - 1].  Otherwise, a null pointer. */
+  struct ccase **batch;
+  size_t batch_ofs, batch_cnt;
   struct casereader_shim *shim; /* Shim on proc_open() casereader. */
 
   const struct dataset_callbacks *callbacks;
@@ -118,6 +128,10 @@ static void add_case_limit_trns (struct dataset *ds);
 static void add_filter_trns (struct dataset *ds);
 
 static void update_last_proc_invocation (struct dataset *ds);
+static bool proc_can_batch (const struct dataset *ds);
+
+/* Maximum number of cases to transform as a batch. */
+#define PROC_BATCH_SIZE 128
 
 static void
 dict_callback (struct dictionary *d UNUSED, void *ds_)
@@ -290,6 +304,7 @@ dataset_set_dict (struct dataset *ds, struct dictionary *dict)
   assert (ds->proc_state == PROC_COMMITTED);
   assert (ds->dict != dict);
 
+  dataset_end_dict_batch (ds);
   dataset_clear (ds);
 
   dict_destroy (ds->dict);
@@ -297,6 +312,32 @@ dataset_set_dict (struct dataset *ds, struct dictionary *dict)
   dict_set_change_callback (ds->dict, dict_callback, ds);
 }
 
+/* Starts a batch of changes to DS's dictionary, as with dict_begin_batch(),
+   unless one is already in progress.  The batch lasts until the next call to
+   dataset_end_dict_batch() or until DS's dictionary is replaced. */
+void
+dataset_begin_dict_batch (struct dataset *ds)
+{
+  if (!ds->dict_batch)
+    {
+      ds->dict_batch = true;
+      dict_begin_batch (ds->dict);
+    }
+}
+
+/* Ends the batch of changes to DS's dictionary started by
+   dataset_begin_dict_batch(), if any, reporting the variables added during
+   the batch to the dictionary's callbacks. */
+void
+dataset_end_dict_batch (struct dataset *ds)
+{
+  if (ds->dict_batch)
+    {
+      ds->dict_batch = false;
+      dict_end_batch (ds->dict);
+    }
+}
+
 /* Returns the casereader that will be read when a procedure is executed on
    DS.  This can be NULL if none has been set up yet. */
 const struct casereader *
@@ -465,6 +506,12 @@ proc_open_filtering (struct dataset *ds, bool filter)
   ds->cases_written = 0;
   ds->ok = true;
 
+  /* Transform batches of cases at a time, if possible. */
+  ds->batch = (proc_can_batch (ds)
+               ? xnmalloc (PROC_BATCH_SIZE, sizeof *ds->batch)
+               : NULL);
+  ds->batch_ofs = ds->batch_cnt = 0;
+
   /* FIXME: use taint in dataset in place of `ok'? */
   /* FIXME: for trivial cases we can just return a clone of
      ds->source? */
@@ -499,6 +546,83 @@ proc_is_open (const struct dataset *ds)
   return ds->proc_state != PROC_COMMITTED;
 }
 
+/* Returns true if DS's transformations may execute on batches of cases, that
+   is, if every transformation has a batch function and no "left" variables
+   carry values from one case to the next.  (A transformation that needs to
+   see cases one at a time, e.g. one that uses LAG or $CASENUM, does not
+   provide a batch function.)  There is no benefit if there are no
+   transformations. */
+static bool
+proc_can_batch (const struct dataset *ds)
+{
+  const struct trns_chain *temporary = ds->temporary_trns_chain;
+
+  if (trns_chain_is_empty (ds->permanent_trns_chain)
+      && (temporary == NULL || trns_chain_is_empty (temporary)))
+    return false;
+
+  return (trns_chain_is_batchable (ds->permanent_trns_chain)
+          && (temporary == NULL || trns_chain_is_batchable (temporary))
+          && !caseinit_has_left_vars (ds->caseinit));
+}
+
+/* Reads a batch of up to PROC_BATCH_SIZE cases from DS's source and passes
+   them through the transformations, in the same way that
+   proc_casereader_read() does for one case at a time, and then returns them
+   one by one. */
+static struct ccase *
+proc_casereader_read_batch (struct dataset *ds)
+{
+  while (ds->batch_ofs >= ds->batch_cnt)
+    {
+      size_t n, i;
+
+      /* Read a batch of cases from source. */
+      for (n = 0; n < PROC_BATCH_SIZE; n++)
+        {
+          struct ccase *c = casereader_read (ds->source);
+          if (c == NULL)
+            break;
+          c = case_unshare_and_resize (c, dict_get_proto (ds->dict));
+          caseinit_init_vars (ds->caseinit, c);
+          ds->batch[n] = c;
+        }
+      if (n == 0)
+        return NULL;
+
+      /* Execute permanent transformations. */
+      n = trns_chain_execute_batch (ds->permanent_trns_chain, ds->batch, n);
+
+      for (i = 0; i < n; i++)
+        {
+          struct ccase *c = ds->batch[i];
+
+          /* Write case to collection of lagged cases. */
+          if (ds->n_lag > 0)
+            {
+              while (deque_count (&ds->lag) >= ds->n_lag)
+                case_unref (ds->lag_cases[deque_pop_back (&ds->lag)]);
+              ds->lag_cases[deque_push_front (&ds->lag)] = case_ref (c);
+            }
+
+          /* Write case to replacement dataset. */
+          ds->cases_written++;
+          if (ds->sink != NULL)
+            casewriter_write (ds->sink,
+                              case_map_execute (ds->compactor, case_ref (c)));
+        }
+
+      /* Execute temporary transformations. */
+      if (ds->temporary_trns_chain != NULL)
+        n = trns_chain_execute_batch (ds->temporary_trns_chain, ds->batch, n);
+
+      ds->batch_ofs = 0;
+      ds->batch_cnt = n;
+    }
+
+  return ds->batch[ds->batch_ofs++];
+}
+
 /* "read" function for procedure casereader. */
 static struct ccase *
 proc_casereader_read (struct casereader *reader UNUSED, void *ds_)
@@ -508,6 +632,9 @@ proc_casereader_read (struct casereader *reader UNUSED, void *ds_)
   struct ccase *c;
 
   assert (ds->proc_state == PROC_OPEN);
+  if (ds->batch != NULL)
+    return proc_casereader_read_batch (ds);
+
   for (; ; case_unref (c))
     {
       casenumber case_nr;
@@ -577,6 +704,8 @@ proc_casereader_destroy (struct casereader *reader, void *ds_)
      active dataset gets all the cases it should. */
   while ((c = casereader_read (reader)) != NULL)
     case_unref (c);
+  free (ds->batch);
+  ds->batch = NULL;
 
   ds->proc_state = PROC_CLOSED;
   ds->ok = casereader_destroy (ds->source) && ds->ok;
@@ -695,6 +824,23 @@ add_transformation (struct dataset *ds, trns_proc_func *proc, trns_free_func *fr
   dataset_transformations_changed__ (ds, true);
 }
 
+/* Adds a transformation that processes a case with PROC and
+   frees itself with FREE to the current set of transformations.
+   BATCH, if nonnull, processes a batch of cases in the same way
+   as PROC processes each one, which allows procedures to
+   transform batches of cases at a time.
+   The functions are passed AUX as auxiliary data. */
+void
+add_batch_transformation (struct dataset *ds, trns_proc_func *proc,
+                          trns_batch_func *batch, trns_free_func *free,
+                          void *aux)
+{
+  trns_chain_append (ds->cur_trns_chain, NULL, proc, free, aux);
+  if (batch != NULL)
+    trns_chain_set_batch (ds->cur_trns_chain, batch);
+  dataset_transformations_changed__ (ds, true);
+}
+
 /* Adds a transformation that processes a case with PROC and
    frees itself with FREE to the current set of transformations.
    When parsing of the block of transformations is complete,
@@ -719,6 +865,17 @@ next_transformation (const struct dataset *ds)
   return trns_chain_next (ds->cur_trns_chain);
 }
 
+/* Returns the auxiliary data for the most recently added transformation, if
+   it executes with PROC and if the next transformation to be added could
+   not be the target of a jump, so that the caller may add its work to that
+   transformation instead of adding a new one.  Otherwise, returns a null
+   pointer. */
+void *
+last_transformation (const struct dataset *ds, trns_proc_func *proc)
+{
+  return trns_chain_get_last (ds->cur_trns_chain, proc);
+}
+
 /* Returns true if the next call to add_transformation() will add
    a temporary transformation, false if it will add a permanent
    transformation. */
@@ -782,6 +939,7 @@ proc_cancel_temporary_transformations (struct dataset *ds)
 {
   if (proc_in_temporary_transformations (ds))
     {
+      dataset_end_dict_batch (ds);
       dict_destroy (ds->dict);
       ds->dict = ds->permanent_dict;
       ds->permanent_dict = NULL;
@@ -878,6 +1036,7 @@ dataset_end_of_command (struct dataset *ds)
 }
 
 static trns_proc_func case_limit_trns_proc;
+static trns_batch_func case_limit_trns_batch;
 static trns_free_func case_limit_trns_free;
 
 /* Adds a transformation that limits the number of cases that may
@@ -890,8 +1049,9 @@ add_case_limit_trns (struct dataset *ds)
     {
       casenumber *cases_remaining = xmalloc (sizeof *cases_remaining);
       *cases_remaining = case_limit;
-      add_transformation (ds, case_limit_trns_proc, case_limit_trns_free,
-                          cases_remaining);
+      add_batch_transformation (ds, case_limit_trns_proc,
+                                case_limit_trns_batch, case_limit_trns_free,
+                                cases_remaining);
       dict_set_case_limit (ds->dict, 0);
     }
 }
@@ -912,6 +1072,21 @@ case_limit_trns_proc (void *cases_remaining_,
     return TRNS_DROP_CASE;
 }
 
+/* Limits the maximum number of cases processed to
+   *CASES_REMAINING, for a batch of N cases. */
+static size_t
+case_limit_trns_batch (void *cases_remaining_, struct ccase **cases, size_t n)
+{
+  size_t *cases_remaining = cases_remaining_;
+  size_t n_keep = MIN (n, *cases_remaining);
+  size_t i;
+
+  for (i = n_keep; i < n; i++)
+    case_unref (cases[i]);
+  *cases_remaining -= n_keep;
+  return n_keep;
+}
+
 /* Frees the data associated with a case limit transformation. */
 static bool
 case_limit_trns_free (void *cases_remaining_)
@@ -922,6 +1097,7 @@ case_limit_trns_free (void *cases_remaining_)
 }
 
 static trns_proc_func filter_trns_proc;
+static trns_batch_func filter_trns_batch;
 
 /* Adds a temporary transformation to filter data according to
    the variable specified on FILTER, if any. */
@@ -932,7 +1108,8 @@ add_filter_trns (struct dataset *ds)
   if (filter_var != NULL)
     {
       proc_start_temporary_transformations (ds);
-      add_transformation (ds, filter_trns_proc, NULL, filter_var);
+      add_batch_transformation (ds, filter_trns_proc, filter_trns_batch,
+                                NULL, filter_var);
     }
 }
 
@@ -948,6 +1125,25 @@ filter_trns_proc (void *filter_var_,
           ? TRNS_CONTINUE : TRNS_DROP_CASE);
 }
 
+/* FILTER transformation for a batch of N cases. */
+static size_t
+filter_trns_batch (void *filter_var_, struct ccase **cases, size_t n)
+{
+  struct variable *filter_var = filter_var_;
+  size_t i, n_keep;
+
+  n_keep = 0;
+  for (i = 0; i < n; i++)
+    {
+      double f = case_num (cases[i], filter_var);
+      if (f != 0.0 && !var_is_num_missing (filter_var, f, MV_ANY))
+        cases[n_keep++] = cases[i];
+      else
+        case_unref (cases[i]);
+    }
+  return n_keep;
+}
+
 
 void
 dataset_need_lag (struct dataset *ds, int n_before)
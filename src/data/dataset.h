@@ -41,6 +41,8 @@ void dataset_set_session (struct dataset *, struct session *);
 
 struct dictionary *dataset_dict (const struct dataset *);
 void dataset_set_dict (struct dataset *, struct dictionary *);
+void dataset_begin_dict_batch (struct dataset *);
+void dataset_end_dict_batch (struct dataset *);
 
 const struct casereader *dataset_source (const struct dataset *);
 bool dataset_has_source (const struct dataset *ds);
@@ -80,11 +82,14 @@ void dataset_set_display (struct dataset *, enum dataset_display);
 
 void add_transformation (struct dataset *ds,
 			 trns_proc_func *, trns_free_func *, void *);
+void add_batch_transformation (struct dataset *ds, trns_proc_func *,
+                               trns_batch_func *, trns_free_func *, void *);
 void add_transformation_with_finalizer (struct dataset *ds,
 					trns_finalize_func *,
                                         trns_proc_func *,
                                         trns_free_func *, void *);
 size_t next_transformation (const struct dataset *ds);
+void *last_transformation (const struct dataset *ds, trns_proc_func *);
 
 bool proc_cancel_all_transformations (struct dataset *ds);
 struct trns_chain *proc_capture_transformations (struct dataset *ds);
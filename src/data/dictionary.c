@@ -82,10 +82,15 @@ struct dictionary
 
     void (*changed) (struct dictionary *, void *); /* Generic change callback */
     void *changed_data;
+
+    int batch_depth;            /* Nesting of dict_begin_batch() calls. */
+    size_t n_batch_vars;        /* Number of variables at the end of 'var'
+                                   not yet reported to callbacks. */
   };
 
 static void dict_unset_split_var (struct dictionary *, struct variable *);
 static void dict_unset_mrset_var (struct dictionary *, struct variable *);
+static void flush_batch (struct dictionary *);
 
 /* Returns the encoding for data in dictionary D.  The return value is a
    nonnull string that contains an IANA character set name. */
@@ -163,6 +168,55 @@ dict_copy_callbacks (struct dictionary *dest,
   dest->cb_data = src->cb_data;
 }
 
+/* Starts a batch of changes to dictionary D.  Until the matching call to
+   dict_end_batch(), D reports the variables that are added to it to its
+   callbacks only in bulk.  Changes to these new variables are not reported
+   separately.
+
+   Batching makes adding many variables faster when D has callbacks, because
+   each callback runs once per variable and can then see all of the new
+   variables, and because variables changed just after they are created need
+   not be copied for the var_changed callback.
+
+   Other kinds of changes to D, such as deleting, renaming, or reordering
+   variables, may still be made during a batch.  Each of them first reports
+   any variables added so far.
+
+   Batches may be nested.  Only the outermost batch has any effect. */
+void
+dict_begin_batch (struct dictionary *d)
+{
+  d->batch_depth++;
+}
+
+/* Ends a batch of changes to dictionary D started with dict_begin_batch(),
+   reporting the variables added during the batch to D's callbacks. */
+void
+dict_end_batch (struct dictionary *d)
+{
+  assert (d->batch_depth > 0);
+  if (--d->batch_depth == 0)
+    flush_batch (d);
+}
+
+/* Reports the variables added to D during a batch, that have not yet been
+   reported, to D's callbacks. */
+static void
+flush_batch (struct dictionary *d)
+{
+  size_t first = d->var_cnt - d->n_batch_vars;
+  size_t i;
+
+  if (d->n_batch_vars == 0)
+    return;
+  d->n_batch_vars = 0;
+
+  if ( d->changed ) d->changed (d, d->changed_data);
+  if ( d->callbacks &&  d->callbacks->var_added )
+    for (i = first; i < d->var_cnt; i++)
+      d->callbacks->var_added (d, i, d->cb_data);
+}
+
 /* Creates and returns a new dictionary with the specified ENCODING. */
 struct dictionary *
 dict_create (const char *encoding)
@@ -393,9 +447,14 @@ add_var_with_case_index (struct dictionary *d, struct variable *v,
   vardict->case_index = case_index;
   var_set_vardict (v, vardict);
 
-  if ( d->changed ) d->changed (d, d->changed_data);
-  if ( d->callbacks &&  d->callbacks->var_added )
-    d->callbacks->var_added (d, var_get_dict_index (v), d->cb_data);
+  if (d->batch_depth > 0)
+    d->n_batch_vars++;
+  else
+    {
+      if ( d->changed ) d->changed (d, d->changed_data);
+      if ( d->callbacks &&  d->callbacks->var_added )
+        d->callbacks->var_added (d, var_get_dict_index (v), d->cb_data);
+    }
 
   invalidate_proto (d);
   d->next_value_idx = case_index + 1;
@@ -612,6 +671,7 @@ dict_delete_var (struct dictionary *d, struct variable *v)
   const int case_index = var_get_case_index (v);
 
   assert (dict_contains_var (d, v));
+  flush_batch (d);
 
   dict_unset_split_var (d, v);
   dict_unset_mrset_var (d, v);
@@ -644,18 +704,83 @@ dict_delete_var (struct dictionary *d, struct variable *v)
   var_destroy (v);
 }
 
+/* Deletes the COUNT variables listed in VARS from D, when D has no callbacks
+   to report each deletion to.  Takes time linear in the number of variables
+   in D that follow the first deleted variable, instead of reindexing those
+   variables once per deleted variable. */
+static void
+dict_delete_vars__ (struct dictionary *d,
+                    struct variable *const *vars, size_t count)
+{
+  size_t first_idx;
+  size_t i, j;
+
+  /* Remove the variables from split variables, weights, filters, etc. */
+  first_idx = d->var_cnt;
+  for (i = 0; i < count; i++)
+    {
+      struct variable *v = vars[i];
+      size_t dict_index;
+
+      assert (dict_contains_var (d, v));
+      dict_index = var_get_dict_index (v);
+      if (dict_index < first_idx)
+        first_idx = dict_index;
+
+      dict_unset_split_var (d, v);
+      dict_unset_mrset_var (d, v);
+      if (d->weight == v)
+        dict_set_weight (d, NULL);
+      if (d->filter == v)
+        dict_set_filter (d, NULL);
+    }
+  dict_clear_vectors (d);
+
+  /* Mark the variables' vardicts as deleted, then squeeze them out of the
+     var array. */
+  unindex_vars (d, first_idx, d->var_cnt);
+  for (i = 0; i < count; i++)
+    {
+      struct vardict_info *vardict = var_get_vardict (vars[i]);
+      assert (vardict->dict == d);
+      vardict->dict = NULL;
+    }
+  for (i = j = first_idx; i < d->var_cnt; i++)
+    if (d->var[i].dict != NULL)
+      d->var[j++] = d->var[i];
+  d->var_cnt = j;
+  reindex_vars (d, first_idx, d->var_cnt);
+
+  /* Free memory. */
+  for (i = 0; i < count; i++)
+    {
+      var_clear_vardict (vars[i]);
+      var_destroy (vars[i]);
+    }
+
+  if ( d->changed ) d->changed (d, d->changed_data);
+
+  invalidate_proto (d);
+}
+
 /* Deletes the COUNT variables listed in VARS from D.  This is
    unsafe; see the comment on dict_delete_var() for details. */
 void
 dict_delete_vars (struct dictionary *d,
                   struct variable *const *vars, size_t count)
 {
-  /* FIXME: this can be done in O(count) time, but this algorithm
-     is O(count**2). */
   assert (count == 0 || vars != NULL);
 
-  while (count-- > 0)
-    dict_delete_var (d, *vars++);
+  flush_batch (d);
+  if (d->callbacks == NULL)
+    dict_delete_vars__ (d, vars, count);
+  else
+    {
+      /* Report each deletion with the dictionary index that the variable
+         has at the time it is deleted. */
+      while (count-- > 0)
+        dict_delete_var (d, *vars++);
+    }
 }
 
 /* Deletes the COUNT variables in D starting at index IDX.  This
@@ -664,12 +789,22 @@ dict_delete_vars (struct dictionary *d,
 void
 dict_delete_consecutive_vars (struct dictionary *d, size_t idx, size_t count)
 {
-  /* FIXME: this can be done in O(count) time, but this algorithm
-     is O(count**2). */
   assert (idx + count <= d->var_cnt);
 
-  while (count-- > 0)
-    dict_delete_var (d, d->var[idx].var);
+  flush_batch (d);
+  if (d->callbacks == NULL)
+    {
+      struct variable **vars = xnmalloc (count, sizeof *vars);
+      size_t i;
+
+      for (i = 0; i < count; i++)
+        vars[i] = d->var[idx + i].var;
+      dict_delete_vars__ (d, vars, count);
+      free (vars);
+    }
+  else
+    while (count-- > 0)
+      dict_delete_var (d, d->var[idx].var);
 }
 
 /* Deletes scratch variables from dictionary D. */
@@ -697,6 +832,7 @@ dict_reorder_var (struct dictionary *d, struct variable *v, size_t new_index)
 
   assert (new_index < d->var_cnt);
 
+  flush_batch (d);
   unindex_vars (d, MIN (old_index, new_index), MAX (old_index, new_index) + 1);
   move_element (d->var, d->var_cnt, sizeof *d->var, old_index, new_index);
   reindex_vars (d, MIN (old_index, new_index), MAX (old_index, new_index) + 1);
@@ -716,6 +852,8 @@ dict_reorder_vars (struct dictionary *d,
   assert (count == 0 || order != NULL);
   assert (count <= d->var_cnt);
 
+  flush_batch (d);
+
   new_var = xnmalloc (d->var_cap, sizeof *new_var);
 
   /* Add variables in ORDER to new_var. */
@@ -763,7 +901,10 @@ void
 dict_rename_var (struct dictionary *d, struct variable *v,
                  const char *new_name)
 {
-  struct variable *old = var_clone (v);
+  struct variable *old;
+
+  flush_batch (d);
+  old = (d->callbacks && d->callbacks->var_changed ? var_clone (v) : NULL);
   assert (!utf8_strcasecmp (var_get_name (v), new_name)
           || dict_lookup_var (d, new_name) == NULL);
 
@@ -775,10 +916,11 @@ dict_rename_var (struct dictionary *d, struct variable *v,
     var_clear_short_names (v);
 
   if ( d->changed ) d->changed (d, d->changed_data);
-  if ( d->callbacks &&  d->callbacks->var_changed )
-    d->callbacks->var_changed (d, var_get_dict_index (v), VAR_TRAIT_NAME, old, d->cb_data);
-
-  var_destroy (old);
+  if (old)
+    {
+      d->callbacks->var_changed (d, var_get_dict_index (v), VAR_TRAIT_NAME, old, d->cb_data);
+      var_destroy (old);
+    }
 }
 
 /* Renames COUNT variables specified in VARS to the names given
@@ -799,6 +941,8 @@ dict_rename_vars (struct dictionary *d,
   assert (count == 0 || vars != NULL);
   assert (count == 0 || new_names != NULL);
 
+  flush_batch (d);
+
   /* Save the names of the variables to be renamed. */
   pool = pool_create ();
   old_names = pool_nalloc (pool, count, sizeof *old_names);
@@ -1020,6 +1164,7 @@ dict_set_weight (struct dictionary *d, struct variable *v)
   assert (v == NULL || dict_contains_var (d, v));
   assert (v == NULL || var_is_numeric (v));
 
+  flush_batch (d);
   d->weight = v;
 
   if (d->changed) d->changed (d, d->changed_data);
@@ -1047,6 +1192,7 @@ dict_set_filter (struct dictionary *d, struct variable *v)
   assert (v == NULL || dict_contains_var (d, v));
   assert (v == NULL || var_is_numeric (v));
 
+  flush_batch (d);
   d->filter = v;
 
   if (d->changed) d->changed (d, d->changed_data);
@@ -1228,6 +1374,7 @@ dict_set_split_vars (struct dictionary *d,
 {
   assert (cnt == 0 || split != NULL);
 
+  flush_batch (d);
   d->split_cnt = cnt;
   if ( cnt > 0 )
    {
@@ -1593,9 +1740,40 @@ dict_has_attributes (const struct dictionary *d)
   return attrset_count (&d->attributes) > 0;
 }
 
+/* Returns true if V is in a dictionary that has not yet reported it to its
+   callbacks, because it was added in a batch that is still in progress. */
+static bool
+var_is_batched (const struct dictionary *d, const struct variable *v)
+{
+  return d->n_batch_vars > 0
+          && var_get_dict_index (v) >= d->var_cnt - d->n_batch_vars;
+}
+
+/* Called from variable.c before it changes some property of V.  Returns a
+   copy of V, for passing to dict_var_changed() once the change is complete,
+   if V's dictionary has a callback that needs the old version of V, and
+   otherwise a null pointer.  (Copying a variable copies its value labels and
+   attributes, so this saves a good deal of time when the dictionary has no
+   such callback, as is usual when a system file is read, for example.) */
+struct variable *
+dict_var_prepare_change (const struct variable *v)
+{
+  if (var_has_vardict (v))
+    {
+      const struct dictionary *d = var_get_vardict (v)->dict;
+
+      if (d != NULL && d->callbacks && d->callbacks->var_changed
+          && !var_is_batched (d, v))
+        return var_clone (v);
+    }
+  return NULL;
+}
+
 /* Called from variable.c to notify the dictionary that some property (indicated
-   by WHAT) of the variable has changed.  OLDVAR is a copy of V as it existed
-   prior to the change.  OLDVAR is destroyed by this function.
+   by WHAT) of the variable has changed.  OLDVAR is the value returned by
+   dict_var_prepare_change() before the change, that is, either a copy of V as
+   it existed prior to the change or a null pointer.  OLDVAR is destroyed by
+   this function.
 */
 void
 dict_var_changed (const struct variable *v, unsigned int what, struct variable *oldvar)
@@ -1605,12 +1783,13 @@ dict_var_changed (const struct variable *v, unsigned int what, struct variable *
       const struct vardict_info *vardict = var_get_vardict (v);
       struct dictionary *d = vardict->dict;
 
-      if ( NULL == d)
-	return;
-
-      if (d->changed ) d->changed (d, d->changed_data);
-      if ( d->callbacks && d->callbacks->var_changed )
-	d->callbacks->var_changed (d, var_get_dict_index (v), what, oldvar, d->cb_data);
+      if (d != NULL && !var_is_batched (d, v))
+        {
+          if (d->changed ) d->changed (d, d->changed_data);
+          if (oldvar != NULL && d->callbacks && d->callbacks->var_changed)
+            d->callbacks->var_changed (d, var_get_dict_index (v), what,
+                                       oldvar, d->cb_data);
+        }
     }
   var_destroy (oldvar);
 }
@@ -287,9 +287,11 @@ gnm_file_casereader_destroy (struct casereader *reader UNUSED, void *r_)
 static void
 process_node (struct gnumeric_reader *r, struct state_data *sd)
 {
-  xmlChar *name = xmlTextReaderName (sd->xtr);
+  /* The constant name is interned in the reader's dictionary, so that
+     processing a node does not require any memory allocation. */
+  const xmlChar *name = xmlTextReaderConstName (sd->xtr);
   if (name == NULL)
-    name = xmlStrdup (_xml ("--"));
+    name = _xml ("--");
 
   sd->node_type = xmlTextReaderNodeType (sd->xtr);
 
@@ -472,8 +474,6 @@ process_node (struct gnumeric_reader *r, struct state_data *sd)
     default:
       break;
     };
-
-  xmlFree (name);
 }
 
 
@@ -703,15 +703,14 @@ gnumeric_make_reader (struct spreadsheet *spreadsheet,
   while ( (r->rsd.state != STATE_CELL || r->rsd.row < r->start_row )
 	  && 1 == (ret = xmlTextReaderRead (r->rsd.xtr)))
     {
-      xmlChar *value ;
       process_node (r, &r->rsd);
-      value = xmlTextReaderValue (r->rsd.xtr);
 
       if ( r->rsd.state == STATE_MAXROW  && r->rsd.node_type == XML_READER_TYPE_TEXT)
 	{
+	  xmlChar *value = xmlTextReaderValue (r->rsd.xtr);
 	  n_cases = 1 + _xmlchar_to_int (value) ;
+	  free (value);
 	}
-      free (value);
     }
 
   /* If a range has been given, then  use that to calculate the number
@@ -960,14 +959,12 @@ gnm_file_casereader_read (struct casereader *reader UNUSED, void *r_)
 
       if ( r->rsd.node_type == XML_READER_TYPE_TEXT )
 	{
-	  xmlChar *value = xmlTextReaderValue (r->rsd.xtr);
+	  const xmlChar *value = xmlTextReaderConstValue (r->rsd.xtr);
 	  const int idx = r->rsd.col - r->start_col;
 	  const struct variable *var = dict_get_var (r->dict, idx);
 
 	  convert_xml_string_to_value (c, var, value, r->vtype,
 				       r->rsd.col, r->rsd.row);
-
-	  xmlFree (value);
 	}
     }
 
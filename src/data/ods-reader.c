@@ -313,10 +313,11 @@ ods_file_casereader_destroy (struct casereader *reader UNUSED, void *r_)
 static void
 process_node (struct ods_reader *or, struct state_data *r)
 {
-  xmlChar *name = xmlTextReaderName (r->xtr);
+  /* The constant name is interned in the reader's dictionary, so that
+     processing a node does not require any memory allocation. */
+  const xmlChar *name = xmlTextReaderConstName (r->xtr);
   if (name == NULL)
-    name = xmlStrdup (_xml ("--"));
-
+    name = _xml ("--");
 
   r->node_type = xmlTextReaderNodeType (r->xtr);
 
@@ -454,8 +455,6 @@ process_node (struct ods_reader *or, struct state_data *r)
       NOT_REACHED ();
       break;
     };
-
-  xmlFree (name);
 }
 
 /*
@@ -1008,11 +1007,11 @@ ods_file_casereader_read (struct casereader *reader UNUSED, void *r_)
 	   r->rsd.node_type == XML_READER_TYPE_TEXT)
 	{
 	  int col;
-	  struct xml_value *xmv = xzalloc (sizeof *xmv);
-	  xmv->text = xmlTextReaderValue (r->rsd.xtr);
-	  xmv->value = val_string;
+	  struct xml_value xmv;
+	  xmv.text = xmlTextReaderValue (r->rsd.xtr);
+	  xmv.value = val_string;
 	  val_string = NULL;
-	  xmv->type = type;
+	  xmv.type = type;
 	  type = NULL;
 
 	  for (col = 0; col < r->rsd.col_span; ++col)
@@ -1027,13 +1026,12 @@ ods_file_casereader_read (struct casereader *reader UNUSED, void *r_)
 		break;
 
               var = dict_get_var (r->dict, idx);
-	      convert_xml_to_value (c, var, xmv, idx + r->start_col, r->rsd.row - 1);
+	      convert_xml_to_value (c, var, &xmv, idx + r->start_col, r->rsd.row - 1);
 	    }
 
-	  xmlFree (xmv->text);
-	  xmlFree (xmv->value);
-	  xmlFree (xmv->type);
-	  free (xmv);
+	  xmlFree (xmv.text);
+	  xmlFree (xmv.value);
+	  xmlFree (xmv.type);
 	}
       if ( r->rsd.state <= STATE_TABLE)
 	break;
@@ -420,6 +420,7 @@ pcp_decode (struct any_reader *r_, const char *encoding,
 {
   struct pcp_reader *r = pcp_reader_cast (r_);
   struct dictionary *dict;
+  bool ok;
 
   if (encoding == NULL)
     {
@@ -436,7 +437,10 @@ pcp_decode (struct any_reader *r_, const char *encoding,
   r->encoding = dict_get_encoding (dict);
 
   parse_header (r, &r->header, &r->info, dict);
-  if (!parse_variable_records (r, dict, r->vars, r->n_vars))
+  dict_begin_batch (dict);
+  ok = parse_variable_records (r, dict, r->vars, r->n_vars);
+  dict_end_batch (dict);
+  if (!ok)
     goto error;
 
   /* Create an index of dictionary variable widths for
@@ -18,12 +18,14 @@
 
 #include <ctype.h>
 #include <errno.h>
+#include <limits.h>
 #include <math.h>
 #include <setjmp.h>
 #include <stdarg.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "data/any-reader.h"
 #include "data/casereader-provider.h"
@@ -75,9 +77,25 @@ struct pfm_reader
     struct file_handle *fh;     /* File handle. */
     struct fh_lock *lock;       /* Read lock for file. */
     FILE *file;			/* File stream. */
-    int line_length;            /* Number of characters so far on this line. */
     char cc;			/* Current character. */
     char *trans;                /* 256-byte character set translation table. */
+
+    /* Current line, with carriage returns deleted, padded with spaces to 80
+       characters if it was shorter, and translated through 'trans'. */
+    char *line;
+    size_t line_len;            /* Number of characters in 'line'. */
+    size_t line_pos;            /* Index in 'line' of character after 'cc'. */
+    size_t line_allocated;      /* Bytes allocated for 'line'. */
+    off_t line_ofs;             /* File offset of the start of 'line'. */
+
+    /* Data read from 'file' but not yet copied into 'line'. */
+    char *buf;                  /* PFM_BUF_SIZE bytes. */
+    size_t buf_pos;             /* Offset of first unused byte. */
+    size_t buf_len;             /* Number of bytes in 'buf'. */
+    off_t buf_ofs;              /* File offset of the start of 'buf'. */
+
+    double neg_pow30[16];       /* neg_pow30[i] is pow (30.0, -i). */
+
     int var_cnt;                /* Number of variables. */
     int weight_index;		/* 0-based index of weight variable, or -1. */
     struct caseproto *proto;    /* Format of output cases. */
@@ -86,6 +104,16 @@ struct pfm_reader
 
 static const struct casereader_class por_file_casereader_class;
 
+/* Number of bytes to read from a portable file at a time. */
+#define PFM_BUF_SIZE 65536
+
+/* Returns the file offset of the character after R's current character. */
+static off_t
+pfm_tell (const struct pfm_reader *r)
+{
+  return r->line_ofs + MIN (r->line_pos, r->line_len);
+}
+
 static struct pfm_reader *
 pfm_reader_cast (const struct any_reader *r_)
 {
@@ -109,7 +137,7 @@ error (struct pfm_reader *r, const char *msg, ...)
 
   ds_init_empty (&text);
   ds_put_format (&text, _("portable file %s corrupt at offset 0x%llx: "),
-                 fh_get_file_name (r->fh), (long long int) ftello (r->file));
+                 fh_get_file_name (r->fh), (long long int) pfm_tell (r));
   va_start (args, msg);
   ds_put_vformat (&text, msg, args);
   va_end (args);
@@ -141,7 +169,7 @@ warning (struct pfm_reader *r, const char *msg, ...)
 
   ds_init_empty (&text);
   ds_put_format (&text, _("reading portable file %s at offset 0x%llx: "),
-                 fh_get_file_name (r->fh), (long long int) ftello (r->file));
+                 fh_get_file_name (r->fh), (long long int) pfm_tell (r));
   va_start (args, msg);
   ds_put_vformat (&text, msg, args);
   va_end (args);
@@ -197,39 +225,92 @@ por_file_casereader_destroy (struct casereader *reader, void *r_)
     casereader_force_error (reader);
 }
 
-/* Read a single character into cur_char.  */
+/* Appends the N bytes in DATA to R's current line, except for carriage
+   returns, which are ignored entirely. */
 static void
-advance (struct pfm_reader *r)
+append_to_line (struct pfm_reader *r, const char *data, size_t n)
 {
-  int c;
+  const char *end = data + n;
+
+  if (r->line_len + n + 80 > r->line_allocated)
+    {
+      r->line_allocated = MAX (2 * r->line_allocated, r->line_len + n + 80);
+      r->line = pool_realloc (r->pool, r->line, r->line_allocated);
+    }
+
+  while (data < end)
+    {
+      const char *cr = memchr (data, '\r', end - data);
+      size_t chunk = (cr != NULL ? cr : end) - data;
+
+      memcpy (&r->line[r->line_len], data, chunk);
+      r->line_len += chunk;
+      data += chunk + (cr != NULL);
+    }
+}
+
+/* Reads the next line from R's file into R's line buffer.
+
+   Carriage returns are ignored entirely.  New-lines are mostly ignored, but
+   if a new-line occurs before the line has reached 80 bytes in length, then
+   the "missing" bytes are treated as spaces. */
+static void
+read_line (struct pfm_reader *r)
+{
+  size_t i;
 
-  /* Read the next character from the file.
-     Ignore carriage returns entirely.
-     Mostly ignore new-lines, but if a new-line occurs before the
-     line has reached 80 bytes in length, then treat the
-     "missing" bytes as spaces. */
+  r->line_ofs = r->buf_ofs + r->buf_pos;
+  r->line_len = r->line_pos = 0;
   for (;;)
     {
-      while ((c = getc (r->file)) == '\r')
-        continue;
-      if (c != '\n')
-        break;
+      const char *start, *end, *nl;
 
-      if (r->line_length < 80)
+      if (r->buf_pos >= r->buf_len)
         {
-          c = ' ';
-          ungetc ('\n', r->file);
+          r->buf_ofs += r->buf_len;
+          r->buf_pos = 0;
+          r->buf_len = fread (r->buf, 1, PFM_BUF_SIZE, r->file);
+          if (r->buf_len == 0)
+            {
+              if (r->line_len > 0)
+                break;
+              error (r, _("unexpected end of file"));
+            }
+        }
+
+      start = &r->buf[r->buf_pos];
+      end = &r->buf[r->buf_len];
+      nl = memchr (start, '\n', end - start);
+      if (nl == NULL)
+        {
+          append_to_line (r, start, end - start);
+          r->buf_pos = r->buf_len;
+        }
+      else
+        {
+          append_to_line (r, start, nl - start);
+          r->buf_pos = nl + 1 - r->buf;
+          if (r->line_len < 80)
+            {
+              memset (&r->line[r->line_len], ' ', 80 - r->line_len);
+              r->line_len = 80;
+            }
           break;
         }
-      r->line_length = 0;
     }
-  if (c == EOF)
-    error (r, _("unexpected end of file"));
 
   if (r->trans != NULL)
-    c = r->trans[c];
-  r->cc = c;
-  r->line_length++;
+    for (i = 0; i < r->line_len; i++)
+      r->line[i] = r->trans[(unsigned char) r->line[i]];
+}
+
+/* Read a single character into cur_char.  */
+static inline void
+advance (struct pfm_reader *r)
+{
+  if (r->line_pos >= r->line_len)
+    read_line (r);
+  r->cc = r->line[r->line_pos++];
 }
 
 /* Skip a single character if present, and return whether it was
@@ -260,6 +341,7 @@ pfm_open (struct file_handle *fh)
 {
   struct pool *volatile pool = NULL;
   struct pfm_reader *volatile r = NULL;
+  int i;
 
   /* Create and initialize reader. */
   pool = pool_create ();
@@ -271,7 +353,14 @@ pfm_open (struct file_handle *fh)
   r->fh = fh_ref (fh);
   r->lock = NULL;
   r->file = NULL;
-  r->line_length = 0;
+  r->line = NULL;
+  r->line_len = r->line_pos = r->line_allocated = 0;
+  r->line_ofs = 0;
+  r->buf = pool_malloc (pool, PFM_BUF_SIZE);
+  r->buf_pos = r->buf_len = 0;
+  r->buf_ofs = 0;
+  for (i = 0; i < sizeof r->neg_pow30 / sizeof *r->neg_pow30; i++)
+    r->neg_pow30[i] = pow (30.0, -i);
   r->weight_index = -1;
   r->trans = NULL;
   r->var_cnt = 0;
@@ -343,12 +432,21 @@ pfm_decode (struct any_reader *r_, const char *encoding UNUSED,
 
 /* Returns the value of base-30 digit C,
    or -1 if C is not a base-30 digit. */
-static int
+static inline int
 base_30_value (unsigned char c)
 {
-  static const char base_30_digits[] = "0123456789ABCDEFGHIJKLMNOPQRST";
-  const char *p = strchr (base_30_digits, c);
-  return p != NULL ? p - base_30_digits : -1;
+  /* Maps each base-30 digit to 1 more than its value, and each other
+     character to 0. */
+  static const unsigned char base_30_values[UCHAR_MAX + 1] =
+    {
+      ['0'] = 1, ['1'] = 2, ['2'] = 3, ['3'] = 4, ['4'] = 5,
+      ['5'] = 6, ['6'] = 7, ['7'] = 8, ['8'] = 9, ['9'] = 10,
+      ['A'] = 11, ['B'] = 12, ['C'] = 13, ['D'] = 14, ['E'] = 15,
+      ['F'] = 16, ['G'] = 17, ['H'] = 18, ['I'] = 19, ['J'] = 20,
+      ['K'] = 21, ['L'] = 22, ['M'] = 23, ['N'] = 24, ['O'] = 25,
+      ['P'] = 26, ['Q'] = 27, ['R'] = 28, ['S'] = 29, ['T'] = 30,
+    };
+  return base_30_values[c] - 1;
 }
 
 /* Read a floating point value and return its value. */
@@ -443,7 +541,9 @@ read_float (struct pfm_reader *r)
   /* Multiply `num' by 30 to the `exponent' power, checking for
      overflow.  */
   if (exponent < 0)
-    num *= pow (30.0, (double) exponent);
+    num *= ((size_t) -exponent < sizeof r->neg_pow30 / sizeof *r->neg_pow30
+            ? r->neg_pow30[-exponent]
+            : pow (30.0, (double) exponent));
   else if (exponent > 0)
     {
       if (num > DBL_MAX * pow (30.0, (double) -exponent))
@@ -491,12 +591,14 @@ static size_t
 read_bytes (struct pfm_reader *r, uint8_t *buf)
 {
   int n = read_int (r);
+  int i;
+
   if (n < 0 || n > 255)
     error (r, _("Bad string length %d."), n);
 
-  while (n-- > 0)
+  for (i = 0; i < n; i++)
     {
-      *buf++ = r->cc;
+      buf[i] = r->cc;
       advance (r);
     }
   return n;
@@ -519,6 +621,7 @@ static void
 read_header (struct pfm_reader *r)
 {
   char *trans;
+  size_t j;
   int i;
 
   /* Read and ignore vanity splash strings. */
@@ -549,6 +652,8 @@ read_header (struct pfm_reader *r)
   /* Set up the translation table, then read the first
      translated character. */
   r->trans = trans;
+  for (j = r->line_pos; j < r->line_len; j++)
+    r->line[j] = trans[(unsigned char) r->line[j]];
   advance (r);
 
   /* Skip and verify signature. */
@@ -703,6 +808,7 @@ read_variables (struct pfm_reader *r, struct dictionary *dict)
         error (r, _("Weight variable name (%s) truncated."), weight_name);
     }
 
+  dict_begin_batch (dict);
   for (i = 0; i < r->var_cnt; i++)
     {
       int width;
@@ -789,6 +895,7 @@ read_variables (struct pfm_reader *r, struct dictionary *dict)
           var_set_label (v, label); /* XXX */
         }
     }
+  dict_end_batch (dict);
 
   if (weight_name != NULL)
     {
@@ -53,8 +53,13 @@ psql_open_reader (struct psql_read_info *info UNUSED, struct dictionary **dict U
 #else
 
 #include <stdint.h>
+#include <string.h>
 #include <libpq-fe.h>
 
+#include "gl/glthread/cond.h"
+#include "gl/glthread/lock.h"
+#include "gl/glthread/thread.h"
+
 
 /* Default width of string variables. */
 #define PSQL_DEFAULT_WIDTH 8
@@ -94,12 +99,24 @@ static const struct casereader_class psql_casereader_class =
     NULL,
   };
 
+/* Rows received from the server by COPY, in its binary format. */
+struct copy_batch
+  {
+    char **rows;                /* Each row, as returned by PQgetCopyData. */
+    int *lengths;               /* Length of each row, in bytes. */
+    int n_rows;                 /* Number of rows. */
+  };
+
 struct psql_reader
 {
   PGconn *conn;
   PGresult *res;
   int tuple;
 
+  /* The type of each column in the result. */
+  Oid *types;
+  int n_fields;
+
   bool integer_datetimes;
 
   double postgres_epoch;
@@ -114,10 +131,42 @@ struct psql_reader
 
   struct string fetch_cmd;
   int cache_size;
+
+  /* Reading with COPY, instead of fetching from a cursor.  Used only by
+     the thread that receives rows from the server (see below). */
+  bool copy;                    /* Reading with COPY? */
+  bool copy_eof;                /* Received all the rows? */
+  char *copy_error;             /* Error from the server, if any. */
+
+  /* Reading with COPY.  Used only by the thread that converts rows into
+     cases. */
+  struct copy_batch *batch;     /* Batch being converted into cases. */
+  int row;                      /* Index of next row in BATCH. */
+  bool copy_header_seen;        /* Parsed the COPY header? */
+
+  /* Prefetching.
+
+     When COPY is in use, a separate thread receives batches of rows from
+     the server and passes them through READY to the thread that reads
+     cases, so that the latter converts one batch while the server sends
+     the next.  */
+  bool prefetching;             /* Is there a prefetch thread? */
+  gl_thread_t thread;           /* The prefetch thread. */
+  gl_lock_t lock;               /* Protects the members below. */
+  gl_cond_t cond;               /* Signaled when the members below change. */
+  struct copy_batch *ready;     /* Batch waiting to be converted. */
+  bool prefetch_done;           /* Prefetch thread received all it will? */
+  bool stop;                    /* Should the prefetch thread give up? */
 };
 
 
 static struct ccase *set_value (struct psql_reader *r);
+static void set_field (struct psql_reader *, struct ccase *, int field,
+                       const uint8_t *vptr, int length);
+static bool copy_start (struct psql_reader *, const struct psql_read_info *);
+static void copy_stop (struct psql_reader *);
+static struct ccase *copy_read_case (struct psql_reader *);
+static void *copy_prefetch (void *);
 
 
 
@@ -368,6 +417,11 @@ psql_open_reader (struct psql_read_info *info, struct dictionary **dict)
   r->vmap = NULL;
   r->vmapsize = 0;
 
+  r->n_fields = n_fields;
+  r->types = xnmalloc (n_fields, sizeof *r->types);
+  for (i = 0 ; i < n_fields ; ++i )
+    r->types[i] = PQftype (qres, i);
+
   for (i = 0 ; i < n_fields ; ++i )
     {
       struct variable *var;
@@ -531,12 +585,16 @@ psql_open_reader (struct psql_read_info *info, struct dictionary **dict)
 
   r->cache_size = info->bsize != -1 ? info->bsize: 4096;
 
-  ds_init_empty (&r->fetch_cmd);
-  ds_put_format (&r->fetch_cmd,  "FETCH FORWARD %d FROM pspp", r->cache_size);
-
-  reload_cache (r);
   r->proto = caseproto_ref (dict_get_proto (*dict));
 
+  ds_init_empty (&r->fetch_cmd);
+  if (version < 80200 || !copy_start (r, info))
+    {
+      ds_put_format (&r->fetch_cmd,  "FETCH FORWARD %d FROM pspp",
+                     r->cache_size);
+      reload_cache (r);
+    }
+
   return casereader_create_sequential
     (NULL,
      r->proto,
@@ -558,8 +616,12 @@ psql_casereader_destroy (struct casereader *reader UNUSED, void *r_)
   if (r == NULL)
     return ;
 
+  if (r->copy)
+    copy_stop (r);
+
   ds_destroy (&r->fetch_cmd);
   free (r->vmap);
+  free (r->types);
   if (r->res) PQclear (r->res);
   PQfinish (r->conn);
   caseproto_unref (r->proto);
@@ -574,6 +636,9 @@ psql_casereader_read (struct casereader *reader UNUSED, void *r_)
 {
   struct psql_reader *r = r_;
 
+  if (r->copy)
+    return copy_read_case (r);
+
   if ( NULL == r->res || r->tuple >= r->cache_size)
     {
       if ( ! reload_cache (r) )
@@ -603,297 +668,635 @@ set_value (struct psql_reader *r)
 
   for (i = 0 ; i < n_vars ; ++i )
     {
-      Oid type = PQftype (r->res, i);
-      const struct variable *v = r->vmap[i];
-      union value *val = case_data_rw (c, v);
+      if (PQgetisnull (r->res, r->tuple, i))
+        set_field (r, c, i, NULL, 0);
+      else
+        set_field (r, c, i,
+                   (const uint8_t *) PQgetvalue (r->res, r->tuple, i),
+                   PQgetlength (r->res, r->tuple, i));
+    }
+
+  r->tuple++;
+
+  return c;
+}
+
+/* Sets the variable or variables that correspond to column FIELD in C to
+   the value in VPTR, which is LENGTH bytes long and in PostgreSQL's binary
+   format, or to missing values if VPTR is null. */
+static void
+set_field (struct psql_reader *r, struct ccase *c, int field,
+           const uint8_t *vptr, int length)
+{
+  Oid type = r->types[field];
+  const struct variable *v = r->vmap[field];
+  union value *val = case_data_rw (c, v);
+
+  union value *val1 = NULL;
+
+  switch (type)
+    {
+    case INTERVALOID:
+    case TIMESTAMPTZOID:
+    case TIMETZOID:
+      if (field < r->vmapsize && var_get_dict_index(v) + 1 < dict_get_var_cnt (r->dict))
+	{
+	  const struct variable *v1 = NULL;
+	  v1 = dict_get_var (r->dict, var_get_dict_index (v) + 1);
 
-      union value *val1 = NULL;
+	  val1 = case_data_rw (c, v1);
+	}
+      break;
+    default:
+      break;
+    }
+
+
+  if (vptr == NULL)
+    {
+      value_set_missing (val, var_get_width (v));
 
       switch (type)
 	{
 	case INTERVALOID:
 	case TIMESTAMPTZOID:
 	case TIMETZOID:
-	  if (i < r->vmapsize && var_get_dict_index(v) + 1 < dict_get_var_cnt (r->dict))
-	    {
-	      const struct variable *v1 = NULL;
-	      v1 = dict_get_var (r->dict, var_get_dict_index (v) + 1);
-
-	      val1 = case_data_rw (c, v1);
-	    }
+	  val1->f = SYSMIS;
 	  break;
 	default:
 	  break;
 	}
+    }
+  else
+    {
+      int var_width = var_get_width (v);
+      switch (type)
+	{
+	case BOOLOID:
+	  {
+	    int8_t x;
+	    GET_VALUE (&vptr, x);
+	    val->f = x;
+	  }
+	  break;
 
+	case OIDOID:
+	case INT2OID:
+	  {
+	    int16_t x;
+	    GET_VALUE (&vptr, x);
+	    val->f = x;
+	  }
+	  break;
 
-      if (PQgetisnull (r->res, r->tuple, i))
-	{
-	  value_set_missing (val, var_get_width (v));
+	case INT4OID:
+	  {
+	    int32_t x;
+	    GET_VALUE (&vptr, x);
+	    val->f = x;
+	  }
+	  break;
 
-	  switch (type)
-	    {
-	    case INTERVALOID:
-	    case TIMESTAMPTZOID:
-	    case TIMETZOID:
-	      val1->f = SYSMIS;
-	      break;
-	    default:
-	      break;
-	    }
-	}
-      else
-	{
-	  const uint8_t *vptr = (const uint8_t *) PQgetvalue (r->res, r->tuple, i);
-	  int length = PQgetlength (r->res, r->tuple, i);
+	case INT8OID:
+	  {
+	    int64_t x;
+	    GET_VALUE (&vptr, x);
+	    val->f = x;
+	  }
+	  break;
 
-	  int var_width = var_get_width (v);
-	  switch (type)
-	    {
-	    case BOOLOID:
+	case FLOAT4OID:
+	  {
+	    float n;
+	    GET_VALUE (&vptr, n);
+	    val->f = n;
+	  }
+	  break;
+
+	case FLOAT8OID:
+	  {
+	    double n;
+	    GET_VALUE (&vptr, n);
+	    val->f = n;
+	  }
+	  break;
+
+	case CASHOID:
+	  {
+	    /* Postgres 8.3 uses 64 bits.
+	       Earlier versions use 32 */
+	    switch (length)
 	      {
-		int8_t x;
-		GET_VALUE (&vptr, x);
-		val->f = x;
+	      case 8:
+		{
+		  int64_t x;
+		  GET_VALUE (&vptr, x);
+		  val->f = x / 100.0;
+		}
+		break;
+	      case 4:
+		{
+		  int32_t x;
+		  GET_VALUE (&vptr, x);
+		  val->f = x / 100.0;
+		}
+		break;
+	      default:
+		val->f = SYSMIS;
+		break;
 	      }
-	      break;
+	  }
+	  break;
 
-	    case OIDOID:
-	    case INT2OID:
+	case INTERVALOID:
+	  {
+	    if ( r->integer_datetimes )
 	      {
-		int16_t x;
-		GET_VALUE (&vptr, x);
-		val->f = x;
+		uint32_t months;
+		uint32_t days;
+		uint32_t us;
+		uint32_t things;
+
+		GET_VALUE (&vptr, things);
+		GET_VALUE (&vptr, us);
+		GET_VALUE (&vptr, days);
+		GET_VALUE (&vptr, months);
+
+		val->f = us / 1000000.0;
+		val->f += days * 24 * 3600;
+
+		val1->f = months;
+	      }
+	    else
+	      {
+		uint32_t days, months;
+		double seconds;
+
+		GET_VALUE (&vptr, seconds);
+		GET_VALUE (&vptr, days);
+		GET_VALUE (&vptr, months);
+
+		val->f = seconds;
+		val->f += days * 24 * 3600;
+
+		val1->f = months;
 	      }
-	      break;
+	  }
+	  break;
+
+	case DATEOID:
+	  {
+	    int32_t x;
+
+	    GET_VALUE (&vptr, x);
+
+	    val->f = (x + r->postgres_epoch) * 24 * 3600 ;
+	  }
+	  break;
 
-	    case INT4OID:
+	case TIMEOID:
+	  {
+	    if ( r->integer_datetimes)
 	      {
-		int32_t x;
+		uint64_t x;
 		GET_VALUE (&vptr, x);
-		val->f = x;
+		val->f = x / 1000000.0;
 	      }
-	      break;
-
-	    case INT8OID:
+	    else
 	      {
-		int64_t x;
+		double x;
 		GET_VALUE (&vptr, x);
 		val->f = x;
 	      }
-	      break;
+	  }
+	  break;
 
-	    case FLOAT4OID:
+	case TIMETZOID:
+	  {
+	    int32_t zone;
+	    if ( r->integer_datetimes)
 	      {
-		float n;
-		GET_VALUE (&vptr, n);
-		val->f = n;
-	      }
-	      break;
+		uint64_t x;
 
-	    case FLOAT8OID:
-	      {
-		double n;
-		GET_VALUE (&vptr, n);
-		val->f = n;
-	      }
-	      break;
 
-	    case CASHOID:
+		GET_VALUE (&vptr, x);
+		val->f = x / 1000000.0;
+	      }
+	    else
 	      {
-		/* Postgres 8.3 uses 64 bits.
-		   Earlier versions use 32 */
-		switch (length)
-		  {
-		  case 8:
-		    {
-		      int64_t x;
-		      GET_VALUE (&vptr, x);
-		      val->f = x / 100.0;
-		    }
-		    break;
-		  case 4:
-		    {
-		      int32_t x;
-		      GET_VALUE (&vptr, x);
-		      val->f = x / 100.0;
-		    }
-		    break;
-		  default:
-		    val->f = SYSMIS;
-		    break;
-		  }
+		double x;
+
+		GET_VALUE (&vptr, x);
+		val->f = x ;
 	      }
-	      break;
 
-	    case INTERVALOID:
+	    GET_VALUE (&vptr, zone);
+	    val1->f = zone / 3600.0;
+	  }
+	  break;
+
+	case TIMESTAMPOID:
+	case TIMESTAMPTZOID:
+	  {
+	    if ( r->integer_datetimes)
 	      {
-		if ( r->integer_datetimes )
-		  {
-		    uint32_t months;
-		    uint32_t days;
-		    uint32_t us;
-		    uint32_t things;
-
-		    GET_VALUE (&vptr, things);
-		    GET_VALUE (&vptr, us);
-		    GET_VALUE (&vptr, days);
-		    GET_VALUE (&vptr, months);
-
-		    val->f = us / 1000000.0;
-		    val->f += days * 24 * 3600;
-
-		    val1->f = months;
-		  }
-		else
-		  {
-		    uint32_t days, months;
-		    double seconds;
-
-		    GET_VALUE (&vptr, seconds);
-		    GET_VALUE (&vptr, days);
-		    GET_VALUE (&vptr, months);
-
-		    val->f = seconds;
-		    val->f += days * 24 * 3600;
-
-		    val1->f = months;
-		  }
-	      }
-	      break;
+		int64_t x;
+
+		GET_VALUE (&vptr, x);
 
-	    case DATEOID:
+		x /= 1000000;
+
+		val->f = (x + r->postgres_epoch * 24 * 3600 );
+	      }
+	    else
 	      {
-		int32_t x;
+		double x;
 
 		GET_VALUE (&vptr, x);
 
-		val->f = (x + r->postgres_epoch) * 24 * 3600 ;
+		val->f = (x + r->postgres_epoch * 24 * 3600 );
 	      }
-	      break;
+	  }
+	  break;
+	case TEXTOID:
+	case VARCHAROID:
+	case BPCHAROID:
+	case BYTEAOID:
+	  memcpy (value_str_rw (val, var_width), vptr,
+		  MIN (length, var_width));
+	  break;
 
-	    case TIMEOID:
+	case NUMERICOID:
+	  {
+	    double f = 0.0;
+	    int i;
+	    int16_t n_digits, weight, dscale;
+	    uint16_t sign;
+
+	    GET_VALUE (&vptr, n_digits);
+	    GET_VALUE (&vptr, weight);
+	    GET_VALUE (&vptr, sign);
+	    GET_VALUE (&vptr, dscale);
+
+#if 0
+	    {
+	      struct fmt_spec fmt;
+	      fmt.d = dscale;
+	      fmt.type = FMT_E;
+	      fmt.w = fmt_max_output_width (fmt.type) ;
+	      fmt.d =  MIN (dscale, fmt_max_output_decimals (fmt.type, fmt.w));
+	      var_set_both_formats (v, &fmt);
+	    }
+#endif
+
+	    for (i = 0 ; i < n_digits;  ++i)
 	      {
-		if ( r->integer_datetimes)
-		  {
-		    uint64_t x;
-		    GET_VALUE (&vptr, x);
-		    val->f = x / 1000000.0;
-		  }
-		else
-		  {
-		    double x;
-		    GET_VALUE (&vptr, x);
-		    val->f = x;
-		  }
+		uint16_t x;
+		GET_VALUE (&vptr, x);
+		f += x * pow (10000, weight--);
 	      }
-	      break;
 
-	    case TIMETZOID:
-	      {
-		int32_t zone;
-		if ( r->integer_datetimes)
-		  {
-		    uint64_t x;
+	    if ( sign == 0x4000)
+	      f *= -1.0;
 
+	    if ( sign == 0xC000)
+	      val->f = SYSMIS;
+	    else
+	      val->f = f;
+	  }
+	  break;
 
-		    GET_VALUE (&vptr, x);
-		    val->f = x / 1000000.0;
-		  }
-		else
-		  {
-		    double x;
+	default:
+	  val->f = SYSMIS;
+	  break;
+	}
+    }
+}
 
-		    GET_VALUE (&vptr, x);
-		    val->f = x ;
-		  }
 
-		GET_VALUE (&vptr, zone);
-		val1->f = zone / 3600.0;
-	      }
-	      break;
+/* Reading with COPY. */
 
-	    case TIMESTAMPOID:
-	    case TIMESTAMPTZOID:
-	      {
-		if ( r->integer_datetimes)
-		  {
-		    int64_t x;
+/* Starts transferring the result of INFO's query from R's server with COPY
+   in PostgreSQL's binary format, which transfers the data as a stream
+   instead of in one round trip per FETCH, and starts a thread to receive the
+   data in the background.  Returns true if successful, false if the server
+   could not COPY the query, in which case the transaction is left as it
+   was. */
+static bool
+copy_start (struct psql_reader *r, const struct psql_read_info *info)
+{
+  struct string query;
+  PGresult *qres;
 
-		    GET_VALUE (&vptr, x);
+  qres = PQexec (r->conn, "SAVEPOINT pspp_copy");
+  if ( PQresultStatus (qres) != PGRES_COMMAND_OK )
+    {
+      PQclear (qres);
+      return false;
+    }
+  PQclear (qres);
 
-		    x /= 1000000;
+  ds_init_cstr (&query, "COPY (");
+  ds_put_substring (&query, info->sql.ss);
+  ds_put_cstr (&query, ") TO STDOUT WITH BINARY");
+  qres = PQexec (r->conn, ds_cstr (&query));
+  ds_destroy (&query);
+  if ( PQresultStatus (qres) != PGRES_COPY_OUT )
+    {
+      PQclear (qres);
+      PQclear (PQexec (r->conn, "ROLLBACK TO SAVEPOINT pspp_copy"));
+      return false;
+    }
+  PQclear (qres);
 
-		    val->f = (x + r->postgres_epoch * 24 * 3600 );
-		  }
-		else
-		  {
-		    double x;
+  r->copy = true;
 
-		    GET_VALUE (&vptr, x);
+  gl_lock_init (r->lock);
+  gl_cond_init (r->cond);
+  r->prefetching = !glthread_create (&r->thread, copy_prefetch, r);
+  if (!r->prefetching)
+    {
+      gl_cond_destroy (r->cond);
+      gl_lock_destroy (r->lock);
+    }
 
-		    val->f = (x + r->postgres_epoch * 24 * 3600 );
-		  }
-	      }
-	      break;
-	    case TEXTOID:
-	    case VARCHAROID:
-	    case BPCHAROID:
-	    case BYTEAOID:
-	      memcpy (value_str_rw (val, var_width), vptr,
-                      MIN (length, var_width));
-	      break;
-
-	    case NUMERICOID:
-	      {
-		double f = 0.0;
-		int i;
-		int16_t n_digits, weight, dscale;
-		uint16_t sign;
+  return true;
+}
 
-		GET_VALUE (&vptr, n_digits);
-		GET_VALUE (&vptr, weight);
-		GET_VALUE (&vptr, sign);
-		GET_VALUE (&vptr, dscale);
+static void
+copy_batch_destroy (struct copy_batch *b)
+{
+  if (b != NULL)
+    {
+      int i;
 
-#if 0
-		{
-		  struct fmt_spec fmt;
-		  fmt.d = dscale;
-		  fmt.type = FMT_E;
-		  fmt.w = fmt_max_output_width (fmt.type) ;
-		  fmt.d =  MIN (dscale, fmt_max_output_decimals (fmt.type, fmt.w));
-		  var_set_both_formats (v, &fmt);
-		}
-#endif
+      for (i = 0; i < b->n_rows; i++)
+        PQfreemem (b->rows[i]);
+      free (b->rows);
+      free (b->lengths);
+      free (b);
+    }
+}
 
-		for (i = 0 ; i < n_digits;  ++i)
-		  {
-		    uint16_t x;
-		    GET_VALUE (&vptr, x);
-		    f += x * pow (10000, weight--);
-		  }
+/* Receives up to R->cache_size rows from R's server and returns them, or
+   returns a null pointer if all the rows have already been received or if
+   an error occurs, in which case R->copy_error is set.
 
-		if ( sign == 0x4000)
-		  f *= -1.0;
+   Only one thread, the prefetch thread if there is one, may call this
+   function. */
+static struct copy_batch *
+copy_receive_batch (struct psql_reader *r)
+{
+  struct copy_batch *b;
 
-		if ( sign == 0xC000)
-		  val->f = SYSMIS;
-		else
-		  val->f = f;
-	      }
-	      break;
+  if (r->copy_eof)
+    return NULL;
 
-	    default:
-	      val->f = SYSMIS;
-	      break;
-	    }
-	}
+  b = xmalloc (sizeof *b);
+  b->rows = xnmalloc (r->cache_size, sizeof *b->rows);
+  b->lengths = xnmalloc (r->cache_size, sizeof *b->lengths);
+  b->n_rows = 0;
+  while (b->n_rows < r->cache_size)
+    {
+      char *row;
+      int length = PQgetCopyData (r->conn, &row, false);
+      if (length < 0)
+        {
+          PGresult *res;
+
+          r->copy_eof = true;
+          if (length == -2)
+            r->copy_error = xstrdup (PQerrorMessage (r->conn));
+          while ((res = PQgetResult (r->conn)) != NULL)
+            {
+              if (PQresultStatus (res) != PGRES_COMMAND_OK
+                  && r->copy_error == NULL)
+                r->copy_error = xstrdup (PQresultErrorMessage (res));
+              PQclear (res);
+            }
+          break;
+        }
+
+      b->rows[b->n_rows] = row;
+      b->lengths[b->n_rows] = length;
+      b->n_rows++;
     }
 
-  r->tuple++;
+  if (b->n_rows == 0)
+    {
+      copy_batch_destroy (b);
+      return NULL;
+    }
+  return b;
+}
 
-  return c;
+/* The prefetch thread.  Receives batches of rows from the server and hands
+   them over, one at a time, to the thread that reads cases. */
+static void *
+copy_prefetch (void *r_)
+{
+  struct psql_reader *r = r_;
+
+  for (;;)
+    {
+      struct copy_batch *b = copy_receive_batch (r);
+
+      gl_lock_lock (r->lock);
+      while (r->ready != NULL && !r->stop)
+        gl_cond_wait (r->cond, r->lock);
+      if (r->stop)
+        {
+          gl_lock_unlock (r->lock);
+          copy_batch_destroy (b);
+          return NULL;
+        }
+      if (b != NULL)
+        r->ready = b;
+      else
+        r->prefetch_done = true;
+      gl_cond_broadcast (r->cond);
+      gl_lock_unlock (r->lock);
+
+      if (b == NULL)
+        return NULL;
+    }
+}
+
+/* Returns the next batch of rows received from R's server, or a null pointer
+   if there are no more. */
+static struct copy_batch *
+copy_next_batch (struct psql_reader *r)
+{
+  struct copy_batch *b;
+
+  if (!r->prefetching)
+    return copy_receive_batch (r);
+
+  gl_lock_lock (r->lock);
+  while (r->ready == NULL && !r->prefetch_done)
+    gl_cond_wait (r->cond, r->lock);
+  b = r->ready;
+  r->ready = NULL;
+  gl_cond_broadcast (r->cond);
+  gl_lock_unlock (r->lock);
+
+  return b;
+}
+
+/* Stops R's prefetch thread, if any, cancelling the transfer of the rows
+   that it has not yet received, and frees the rows not yet read. */
+static void
+copy_stop (struct psql_reader *r)
+{
+  if (r->prefetching)
+    {
+      bool done;
+
+      gl_lock_lock (r->lock);
+      r->stop = true;
+      done = r->prefetch_done;
+      gl_cond_broadcast (r->cond);
+      gl_lock_unlock (r->lock);
+
+      /* The prefetch thread might be waiting for data from the server. */
+      if (!done)
+        {
+          PGcancel *cancel = PQgetCancel (r->conn);
+          if (cancel != NULL)
+            {
+              char errbuf[256];
+              PQcancel (cancel, errbuf, sizeof errbuf);
+              PQfreeCancel (cancel);
+            }
+        }
+
+      glthread_join (r->thread, NULL);
+      gl_cond_destroy (r->cond);
+      gl_lock_destroy (r->lock);
+      r->prefetching = false;
+
+      copy_batch_destroy (r->ready);
+      r->ready = NULL;
+    }
+
+  copy_batch_destroy (r->batch);
+  r->batch = NULL;
+  free (r->copy_error);
+  r->copy_error = NULL;
+}
+
+/* Parses DATA, a row of LENGTH bytes in PostgreSQL's binary COPY format,
+   into a new case and stores it in *C, or stores a null pointer in *C if
+   DATA contains no tuple (that is, if it is the end-of-data marker or only
+   the header).  Returns false if DATA is malformed. */
+static bool
+parse_copy_row (struct psql_reader *r, const uint8_t *data, int length,
+                struct ccase **c)
+{
+  const uint8_t *vptr = data;
+  const uint8_t *end = data + length;
+  int16_t n_fields;
+  int i;
+
+  *c = NULL;
+
+  /* The first row begins with the COPY header. */
+  if (!r->copy_header_seen)
+    {
+      static const char signature[] = "PGCOPY\n\377\r\n"; /* Includes \0. */
+      int32_t flags, extension_length;
+
+      if (length < sizeof signature + 8
+          || memcmp (vptr, signature, sizeof signature))
+        return false;
+      vptr += sizeof signature;
+
+      GET_VALUE (&vptr, flags);
+      GET_VALUE (&vptr, extension_length);
+      if (extension_length < 0 || extension_length > end - vptr)
+        return false;
+      vptr += extension_length;
+
+      r->copy_header_seen = true;
+      if (vptr == end)
+        return true;
+    }
+
+  if (end - vptr < sizeof n_fields)
+    return false;
+  GET_VALUE (&vptr, n_fields);
+  if (n_fields == -1)
+    return true;
+  else if (n_fields != r->n_fields)
+    return false;
+
+  *c = case_create (r->proto);
+  case_set_missing (*c);
+  for (i = 0; i < n_fields; i++)
+    {
+      int32_t field_length;
+
+      if (end - vptr < sizeof field_length)
+        goto error;
+      GET_VALUE (&vptr, field_length);
+      if (field_length < 0)
+        set_field (r, *c, i, NULL, 0);
+      else if (field_length > end - vptr)
+        goto error;
+      else
+        {
+          set_field (r, *c, i, vptr, field_length);
+          vptr += field_length;
+        }
+    }
+  return true;
+
+error:
+  case_unref (*c);
+  *c = NULL;
+  return false;
+}
+
+/* Reads and returns a case from R's COPY stream, or returns a null pointer
+   at end of data or on error. */
+static struct ccase *
+copy_read_case (struct psql_reader *r)
+{
+  for (;;)
+    {
+      struct ccase *c;
+
+      if (r->batch == NULL || r->row >= r->batch->n_rows)
+        {
+          copy_batch_destroy (r->batch);
+          r->batch = copy_next_batch (r);
+          r->row = 0;
+          if (r->batch == NULL)
+            {
+              /* The prefetch thread, if any, has finished, so it is safe to
+                 look at the error that it reported. */
+              if (r->copy_error != NULL)
+                {
+                  msg (ME, _("Error from psql source: %s."), r->copy_error);
+                  free (r->copy_error);
+                  r->copy_error = NULL;
+                }
+              return NULL;
+            }
+        }
+
+      if (!parse_copy_row (r, CHAR_CAST (const uint8_t *,
+                                         r->batch->rows[r->row]),
+                           r->batch->lengths[r->row], &c))
+        {
+          msg (ME, _("Malformed data received from psql source."));
+          return NULL;
+        }
+      r->row++;
+
+      if (c != NULL)
+        return c;
+    }
 }
 
 #endif
@@ -761,6 +761,7 @@ sfm_decode (struct any_reader *r_, const char *encoding,
 {
   struct sfm_reader *r = sfm_reader_cast (r_);
   struct dictionary *dict;
+  bool ok;
   size_t i;
 
   if (encoding == NULL)
@@ -802,7 +803,10 @@ sfm_decode (struct any_reader *r_, const char *encoding,
   parse_header (r, &r->header, &r->info, dict);
 
   /* Parse the variable records, the basis of almost everything else. */
-  if (!parse_variable_records (r, dict, r->vars, r->n_vars))
+  dict_begin_batch (dict);
+  ok = parse_variable_records (r, dict, r->vars, r->n_vars);
+  dict_end_batch (dict);
+  if (!ok)
     goto error;
 
   /* Parse value labels and the weight variable immediately after the variable
@@ -2091,10 +2095,22 @@ parse_long_string_map (struct sfm_reader *r,
                        const struct sfm_extension_record *record,
                        struct dictionary *dict)
 {
+  struct variable **segments;
+  size_t n_segments;
+  bool *is_segment;
   struct text_record *text;
   struct variable *var;
   char *length_s;
 
+  /* The segments after the first in each very long string are deleted all
+     at once at the end, because deleting them one string at a time takes
+     time quadratic in the number of variables. */
+  segments = pool_nmalloc (r->pool, dict_get_var_cnt (dict),
+                           sizeof *segments);
+  n_segments = 0;
+  is_segment = pool_calloc (r->pool, dict_get_var_cnt (dict),
+                            sizeof *is_segment);
+
   text = open_text_record (r, record, true);
   while (read_variable_to_value_pair (r, dict, text, &var, &length_s))
     {
@@ -2103,6 +2119,15 @@ parse_long_string_map (struct sfm_reader *r,
       int segment_cnt;
       int i;
 
+      if (is_segment[idx])
+        {
+          /* Warn as if VAR had already been deleted. */
+          text_warn (r, text,
+                     _("Dictionary record refers to unknown variable %s."),
+                     var_get_name (var));
+          continue;
+        }
+
       /* Get length. */
       length = strtol (length_s, NULL, 10);
       if (length < 1 || length > MAX_STRING)
@@ -2151,10 +2176,15 @@ parse_long_string_map (struct sfm_reader *r,
               return false;
             }
         }
-      dict_delete_consecutive_vars (dict, idx + 1, segment_cnt - 1);
+      for (i = 1; i < segment_cnt; i++)
+        {
+          is_segment[idx + i] = true;
+          segments[n_segments++] = dict_get_var (dict, idx + i);
+        }
       var_set_width (var, length);
     }
   close_text_record (r, text);
+  dict_delete_vars (dict, segments, n_segments);
   dict_compact_values (dict);
 
   return true;
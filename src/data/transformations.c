@@ -34,6 +34,7 @@ struct transformation
     int idx_ofs;
     trns_finalize_func *finalize;       /* Finalize proc. */
     trns_proc_func *execute;            /* Executes the transformation. */
+    trns_batch_func *batch;             /* Executes it on a batch, or NULL. */
     trns_free_func *free;               /* Garbage collector proc. */
     void *aux;                          /* Auxiliary data. */
   };
@@ -45,6 +46,11 @@ struct trns_chain
     size_t trns_cnt;                    /* Number of transformations. */
     size_t trns_cap;                    /* Allocated capacity. */
     bool finalized;                     /* Finalize functions called? */
+
+    /* The greatest index that might be the target of a jump, that is, the
+       last value returned by trns_chain_next(), or the end of the chain
+       most recently spliced onto this one. */
+    size_t last_target;
   };
 
 /* Allocates and returns a new transformation chain. */
@@ -56,6 +62,7 @@ trns_chain_create (void)
   chain->trns_cnt = 0;
   chain->trns_cap = 0;
   chain->finalized = false;
+  chain->last_target = 0;
   return chain;
 }
 
@@ -136,10 +143,21 @@ trns_chain_append (struct trns_chain *chain, trns_finalize_func *finalize,
   trns->idx_ofs = 0;
   trns->finalize = finalize;
   trns->execute = execute;
+  trns->batch = NULL;
   trns->free = free;
   trns->aux = aux;
 }
 
+/* Sets BATCH as the function that executes the transformation most recently
+   appended to CHAIN on a batch of cases.  BATCH must have the same effect on
+   each case as the transformation's execute function. */
+void
+trns_chain_set_batch (struct trns_chain *chain, trns_batch_func *batch)
+{
+  assert (chain->trns_cnt > 0);
+  chain->trns[chain->trns_cnt - 1].batch = batch;
+}
+
 /* Appends the transformations in SRC to those in DST,
    and destroys SRC.
    Both DST and SRC must already be finalized. */
@@ -165,6 +183,7 @@ trns_chain_splice (struct trns_chain *dst, struct trns_chain *src)
       d->idx_ofs += src->trns_cnt;
     }
   dst->trns_cnt += src->trns_cnt;
+  dst->last_target = dst->trns_cnt;
 
   src->trns_cnt = 0;
   trns_chain_destroy (src);
@@ -175,9 +194,27 @@ trns_chain_splice (struct trns_chain *dst, struct trns_chain *src)
 size_t
 trns_chain_next (struct trns_chain *chain)
 {
+  chain->last_target = chain->trns_cnt;
   return chain->trns_cnt;
 }
 
+/* Returns the auxiliary data for the transformation most recently appended
+   to CHAIN, if its execute function is EXECUTE and if a transformation
+   appended to CHAIN now would not be the target of a jump, so that the
+   caller may extend the most recent transformation in place of appending a
+   new one.  Otherwise, returns a null pointer. */
+void *
+trns_chain_get_last (const struct trns_chain *chain, trns_proc_func *execute)
+{
+  const struct transformation *last;
+
+  if (chain->trns_cnt == 0 || chain->last_target == chain->trns_cnt)
+    return NULL;
+
+  last = &chain->trns[chain->trns_cnt - 1];
+  return last->execute == execute ? last->aux : NULL;
+}
+
 /* Executes the given CHAIN of transformations on *C,
    passing CASE_NR as the case number.
    *C may be replaced by a new case.
@@ -205,3 +242,37 @@ trns_chain_execute (const struct trns_chain *chain, enum trns_result start,
 
   return TRNS_CONTINUE;
 }
+
+/* Returns true if every transformation in CHAIN can execute on a batch of
+   cases, so that trns_chain_execute_batch() may be used in place of
+   trns_chain_execute(). */
+bool
+trns_chain_is_batchable (const struct trns_chain *chain)
+{
+  size_t i;
+
+  for (i = 0; i < chain->trns_cnt; i++)
+    if (chain->trns[i].batch == NULL)
+      return false;
+  return true;
+}
+
+/* Executes the given CHAIN of transformations, which must be batchable, on
+   the N cases in CASES[].  Each transformation executes on every case
+   before the next transformation starts.  Cases may be replaced, and
+   dropped cases are removed from CASES[] without disturbing the order of
+   the others.  Returns the number of cases that remain. */
+size_t
+trns_chain_execute_batch (const struct trns_chain *chain,
+                          struct ccase **cases, size_t n)
+{
+  size_t i;
+
+  assert (chain->finalized);
+  for (i = 0; i < chain->trns_cnt && n > 0; i++)
+    {
+      const struct transformation *trns = &chain->trns[i];
+      n = trns->batch (trns->aux, cases, n);
+    }
+  return n;
+}
@@ -35,6 +35,14 @@ struct ccase;
 typedef void trns_finalize_func (void *);
 typedef int trns_proc_func (void *, struct ccase **, casenumber);
 typedef bool trns_free_func (void *);
+
+/* Executes a transformation on each of the N cases in CASES[], in order, as
+   a batch.  The function may replace cases in CASES[], and it may drop a
+   case by unreferencing it, in which case it must move the following cases
+   down to fill the gap.  Returns the number of cases that remain.  Unlike a
+   trns_proc_func, a batch function may not fail or jump to another
+   transformation, and it does not receive case numbers. */
+typedef size_t trns_batch_func (void *, struct ccase **cases, size_t n);
 
 /* Transformation chains. */
 
@@ -46,11 +54,17 @@ bool trns_chain_is_empty (const struct trns_chain *);
 
 void trns_chain_append (struct trns_chain *, trns_finalize_func *,
                         trns_proc_func *, trns_free_func *, void *);
+void trns_chain_set_batch (struct trns_chain *, trns_batch_func *);
 size_t trns_chain_next (struct trns_chain *);
+void *trns_chain_get_last (const struct trns_chain *, trns_proc_func *);
 enum trns_result trns_chain_execute (const struct trns_chain *,
                                      enum trns_result, struct ccase **,
                                      casenumber case_nr);
 
+bool trns_chain_is_batchable (const struct trns_chain *);
+size_t trns_chain_execute_batch (const struct trns_chain *,
+                                 struct ccase **cases, size_t n);
+
 void trns_chain_splice (struct trns_chain *, struct trns_chain *);
 
 #endif /* transformations.h */
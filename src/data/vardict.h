@@ -39,6 +39,7 @@ bool var_has_vardict (const struct variable *);
 void var_clear_vardict (struct variable *);
 
 /* Called by variable.c, defined in dictionary.c. */
+struct variable *dict_var_prepare_change (const struct variable *);
 void dict_var_changed (const struct variable *v, unsigned int what, struct variable *ov);
 
 int vardict_get_dict_index (const struct vardict_info *);
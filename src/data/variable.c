@@ -164,7 +164,7 @@ var_set_name_quiet (struct variable *v, const char *name)
 void
 var_set_name (struct variable *v, const char *name)
 {
-  struct variable *ov = var_clone (v);
+  struct variable *ov = dict_var_prepare_change (v);
   var_set_name_quiet (v, name);
   dict_var_changed (v, VAR_TRAIT_NAME, ov);
 }
@@ -253,7 +253,7 @@ var_set_width_and_formats (struct variable *v, int new_width,
   struct variable *ov;
   unsigned int traits = 0;
 
-  ov = var_clone (v);
+  ov = dict_var_prepare_change (v);
 
   if (var_has_missing_values (v))
     {
@@ -305,6 +305,8 @@ var_set_width_and_formats (struct variable *v, int new_width,
 
   if (traits != 0)
     dict_var_changed (v, traits, ov);
+  else
+    var_destroy (ov);
 }
 
 /* Changes the width of V to NEW_WIDTH.
@@ -370,7 +372,7 @@ var_set_missing_values_quiet (struct variable *v, const struct missing_values *m
 void
 var_set_missing_values (struct variable *v, const struct missing_values *miss)
 {
-  struct variable *ov = var_clone (v);
+  struct variable *ov = dict_var_prepare_change (v);
   var_set_missing_values_quiet (v, miss);
   dict_var_changed (v, VAR_TRAIT_MISSING_VALUES, ov);
 }
@@ -459,7 +461,7 @@ var_set_value_labels_quiet (struct variable *v, const struct val_labs *vls)
 void
 var_set_value_labels (struct variable *v, const struct val_labs *vls)
 {
-  struct variable *ov = var_clone (v);
+  struct variable *ov = dict_var_prepare_change (v);
   var_set_value_labels_quiet (v, vls);
   dict_var_changed (v, VAR_TRAIT_LABEL, ov);
 }
@@ -595,7 +597,7 @@ var_set_print_format_quiet (struct variable *v, const struct fmt_spec *print)
 void
 var_set_print_format (struct variable *v, const struct fmt_spec *print)
 {
-  struct variable *ov = var_clone (v);
+  struct variable *ov = dict_var_prepare_change (v);
   var_set_print_format_quiet (v, print);
   dict_var_changed (v, VAR_TRAIT_PRINT_FORMAT, ov);
 }
@@ -628,7 +630,7 @@ var_set_write_format_quiet (struct variable *v, const struct fmt_spec *write)
 void
 var_set_write_format (struct variable *v, const struct fmt_spec *write)
 {
-  struct variable *ov = var_clone (v);
+  struct variable *ov = dict_var_prepare_change (v);
   var_set_write_format_quiet (v, write);
   dict_var_changed (v, VAR_TRAIT_WRITE_FORMAT, ov);
 }
@@ -641,7 +643,7 @@ var_set_write_format (struct variable *v, const struct fmt_spec *write)
 void
 var_set_both_formats (struct variable *v, const struct fmt_spec *format)
 {
-  struct variable *ov = var_clone (v);
+  struct variable *ov = dict_var_prepare_change (v);
   var_set_print_format_quiet (v, format);
   var_set_write_format_quiet (v, format);
   dict_var_changed (v, VAR_TRAIT_PRINT_FORMAT | VAR_TRAIT_WRITE_FORMAT, ov);
@@ -738,7 +740,7 @@ var_set_label_quiet (struct variable *v, const char *label)
 void
 var_set_label (struct variable *v, const char *label)
 {
-  struct variable *ov = var_clone (v);
+  struct variable *ov = dict_var_prepare_change (v);
   var_set_label_quiet (v, label);
   dict_var_changed (v, VAR_TRAIT_LABEL, ov);
 }
@@ -828,7 +830,7 @@ var_set_measure_quiet (struct variable *v, enum measure measure)
 void
 var_set_measure (struct variable *v, enum measure measure)
 {
-  struct variable *ov = var_clone (v);
+  struct variable *ov = dict_var_prepare_change (v);
   var_set_measure_quiet (v, measure);
   dict_var_changed (v, VAR_TRAIT_MEASURE, ov);
 }
@@ -942,7 +944,7 @@ var_set_role_quiet (struct variable *v, enum var_role role)
 void
 var_set_role (struct variable *v, enum var_role role)
 {
-  struct variable *ov = var_clone (v);
+  struct variable *ov = dict_var_prepare_change (v);
   var_set_role_quiet (v, role);
   dict_var_changed (v, VAR_TRAIT_ROLE, ov);
 }
@@ -969,7 +971,7 @@ var_set_display_width (struct variable *v, int new_width)
 {
   if (v->display_width != new_width)
     {
-      struct variable *ov = var_clone (v);
+      struct variable *ov = dict_var_prepare_change (v);
       var_set_display_width_quiet (v, new_width);
       dict_var_changed (v, VAR_TRAIT_DISPLAY_WIDTH, ov);
     }
@@ -1051,7 +1053,7 @@ var_set_alignment_quiet (struct variable *v, enum alignment alignment)
 void
 var_set_alignment (struct variable *v, enum alignment alignment)
 {
-  struct variable *ov = var_clone (v);
+  struct variable *ov = dict_var_prepare_change (v);
   var_set_alignment_quiet (v, alignment);
   dict_var_changed (v, VAR_TRAIT_ALIGNMENT, ov);
 }
@@ -1090,7 +1092,7 @@ var_set_leave_quiet (struct variable *v, bool leave)
 void
 var_set_leave (struct variable *v, bool leave)
 {
-  struct variable *ov = var_clone (v);
+  struct variable *ov = dict_var_prepare_change (v);
   var_set_leave_quiet (v, leave);
   dict_var_changed (v, VAR_TRAIT_LEAVE, ov);
 }
@@ -1139,7 +1141,7 @@ var_get_short_name (const struct variable *var, size_t idx)
 void
 var_set_short_name (struct variable *var, size_t idx, const char *short_name)
 {
-  struct variable *ov = var_clone (var);
+  struct variable *ov = dict_var_prepare_change (var);
 
   assert (short_name == NULL || id_is_plausible (short_name, false));
 
@@ -1227,7 +1229,7 @@ var_set_attributes_quiet (struct variable *v, const struct attrset *attrs)
 void
 var_set_attributes (struct variable *v, const struct attrset *attrs)
 {
-  struct variable *ov = var_clone (v);
+  struct variable *ov = dict_var_prepare_change (v);
   var_set_attributes_quiet (v, attrs);
   dict_var_changed (v, VAR_TRAIT_ATTRIBUTES, ov);
 }
@@ -125,6 +125,16 @@ static const struct command commands[] =
 
 static const size_t command_cnt = sizeof commands / sizeof *commands;
 
+/* The names of the commands, in the same order as 'commands'. */
+#define DEF_CMD(STATES, FLAGS, NAME, FUNCTION) NAME,
+#define UNIMPL_CMD(NAME, DESCRIPTION) NAME,
+static const char *const command_names[] =
+  {
+#include "command.def"
+  };
+#undef DEF_CMD
+#undef UNIMPL_CMD
+
 static bool in_correct_state (const struct command *, enum cmd_state);
 static bool report_state_mismatch (const struct command *, enum cmd_state);
 static void set_completion_state (enum cmd_state);
@@ -176,12 +186,14 @@ do_parse_command (struct lexer *lexer,
   const struct command *command = NULL;
   enum cmd_result result;
   bool opened = false;
+  bool dict_batch;
   int n_tokens;
 
   /* Read the command's first token. */
   set_completion_state (state);
   if (lex_token (lexer) == T_STOP)
     {
+      dataset_end_dict_batch (ds);
       result = CMD_EOF;
       goto finish;
     }
@@ -196,12 +208,20 @@ do_parse_command (struct lexer *lexer,
   command = parse_command_name (lexer, &n_tokens);
   if (command == NULL)
     {
+      dataset_end_dict_batch (ds);
       result = CMD_FAILURE;
       goto finish;
     }
   text_item_submit (text_item_create (TEXT_ITEM_COMMAND_OPEN, command->name));
   opened = true;
 
+  /* A run of transformation and dictionary commands, such as COMPUTE and
+     VARIABLE LABELS, makes its changes to the dictionary as a single batch,
+     which ends before any other kind of command. */
+  dict_batch = command->states == (S_DATA | S_INPUT_PROGRAM);
+  if (!dict_batch)
+    dataset_end_dict_batch (ds);
+
   if (command->function == NULL)
     {
       msg (SE, _("%s is not yet implemented."), command->name);
@@ -230,8 +250,12 @@ do_parse_command (struct lexer *lexer,
 
       for (i = 0; i < n_tokens; i++)
         lex_get (lexer);
+      if (dict_batch)
+        dataset_begin_dict_batch (ds);
       result = command->function (lexer, ds);
     }
+  if (dict_batch && cmd_result_is_failure (result))
+    dataset_end_dict_batch (ds);
 
   assert (cmd_result_is_valid (result));
 
@@ -256,13 +280,28 @@ finish:
 static int
 find_best_match (struct substring s, const struct command **matchp)
 {
-  const struct command *cmd;
+  static struct command_index cmd_index;
+  static bool inited;
+
   struct command_matcher cm;
+  const size_t *indexes;
   int missing_words;
+  size_t i, n;
+
+  if (!inited)
+    {
+      inited = true;
+      command_index_init (&cmd_index, command_names, command_cnt);
+    }
 
+  /* Only the commands that the index yields can possibly match S. */
   command_matcher_init (&cm, s);
-  for (cmd = commands; cmd < &commands[command_cnt]; cmd++)
-    command_matcher_add (&cm, ss_cstr (cmd->name), CONST_CAST (void *, cmd));
+  n = command_index_lookup (&cmd_index, s, &indexes);
+  for (i = 0; i < n; i++)
+    {
+      const struct command *cmd = &commands[indexes[i]];
+      command_matcher_add (&cm, ss_cstr (cmd->name), CONST_CAST (void *, cmd));
+    }
 
   *matchp = command_matcher_get_match (&cm);
   missing_words = command_matcher_get_missing_words (&cm);
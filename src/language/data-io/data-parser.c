@@ -18,8 +18,11 @@
 
 #include "language/data-io/data-parser.h"
 
+#include <limits.h>
+#include <stdarg.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "data/casereader-provider.h"
 #include "data/data-in.h"
@@ -29,21 +32,48 @@
 #include "data/file-handle-def.h"
 #include "data/settings.h"
 #include "language/data-io/data-reader.h"
+#include "libpspp/cast.h"
+#include "libpspp/compiler.h"
+#include "libpspp/i18n.h"
 #include "libpspp/message.h"
 #include "libpspp/str.h"
 #include "output/tab.h"
 
+#include "gl/glthread/lock.h"
+#include "gl/glthread/thread.h"
 #include "gl/xalloc.h"
+#include "gl/xvasprintf.h"
 
 #include "gettext.h"
 #define _(msgid) gettext (msgid)
 
+/* Classes of bytes in delimited data, as bits in data_parser's
+   byte_class[]. */
+enum
+  {
+    BC_SOFT = 1 << 0,           /* Soft separator. */
+    BC_HARD = 1 << 1,           /* Hard separator. */
+    BC_QUOTE = 1 << 2           /* Quote character. */
+  };
+
+/* Word-at-a-time scanning: ONES has the value 1 in each of its 8 bytes, and
+   the macros below test all of the bytes in a 64-bit word X at once. */
+#define ONES UINT64_C (0x0101010101010101)
+#define HIGHS (ONES * 0x80)
+#define HAS_ZERO_BYTE(X) (((X) - ONES) & ~(X) & HIGHS)
+#define HAS_BYTE_BELOW(X, N) (((X) - ONES * (N)) & ~(X) & HIGHS) /* N<=128. */
+
+/* Maximum number of separators with byte values of '0' or greater for which
+   span_field() can skip over 8 bytes at a time. */
+#define MAX_BIG_SEPS 4
+
 /* Data parser for textual data like that read by DATA LIST. */
 struct data_parser
   {
     const struct dictionary *dict; /*Dictionary of destination */
     enum data_parser_type type; /* Type of data to parse. */
     int skip_records;           /* Records to skip before first real data. */
+    int n_threads;              /* Number of threads to parse with. */
 
     struct field *fields;       /* Fields to parse. */
     size_t field_cnt;           /* Number of fields. */
@@ -57,7 +87,12 @@ struct data_parser
     bool quote_escape;          /* Doubled quote acts as escape? */
     struct substring soft_seps; /* Two soft separators act like just one. */
     struct substring hard_seps; /* Two hard separators yield empty fields. */
-    struct string any_sep;      /* Concatenation of soft_seps and hard_seps. */
+
+    /* Derived from the above by set_byte_classes(), for cut_field__(). */
+    unsigned char byte_class[UCHAR_MAX + 1]; /* Bitwise OR of BC_*. */
+    unsigned char sep_below;    /* Every separator below '0' is below this. */
+    size_t n_big_seps;          /* Number of separators '0' and above. */
+    uint64_t big_seps[MAX_BIG_SEPS]; /* Each big separator, 8 times. */
 
     /* DP_FIXED parsers only. */
     int records_per_case;       /* Number of records in each case. */
@@ -75,7 +110,7 @@ struct field
     int first_column;           /* First column in record (1-based). */
   };
 
-static void set_any_sep (struct data_parser *parser);
+static void set_byte_classes (struct data_parser *parser);
 
 /* Creates and returns a new data parser. */
 struct data_parser *
@@ -85,6 +120,7 @@ data_parser_create (const struct dictionary *dict)
 
   parser->type = DP_FIXED;
   parser->skip_records = 0;
+  parser->n_threads = 1;
 
   parser->fields = NULL;
   parser->field_cnt = 0;
@@ -98,8 +134,7 @@ data_parser_create (const struct dictionary *dict)
   parser->quote_escape = false;
   ss_alloc_substring (&parser->soft_seps, ss_cstr (CC_SPACES));
   ss_alloc_substring (&parser->hard_seps, ss_cstr (","));
-  ds_init_empty (&parser->any_sep);
-  set_any_sep (parser);
+  set_byte_classes (parser);
 
   parser->records_per_case = 0;
 
@@ -120,7 +155,6 @@ data_parser_destroy (struct data_parser *parser)
       ss_dealloc (&parser->quotes);
       ss_dealloc (&parser->soft_seps);
       ss_dealloc (&parser->hard_seps);
-      ds_destroy (&parser->any_sep);
       free (parser);
     }
 }
@@ -152,6 +186,33 @@ data_parser_set_skip (struct data_parser *parser, int initial_records_to_skip)
   parser->skip_records = initial_records_to_skip;
 }
 
+/* Returns the number of threads that PARSER is configured to use. */
+int
+data_parser_get_threads (const struct data_parser *parser)
+{
+  return parser->n_threads;
+}
+
+/* Configures PARSER to parse data using up to N_THREADS threads.  By
+   default, PARSER uses only 1 thread, parsing one case at a time.
+
+   With more than one thread, the casereader created by
+   data_parser_make_active_file() reads a batch of records at a time,
+   divides them into chunks that it parses in parallel, and then returns the
+   cases, along with any warnings about them, in their original order.  This
+   is possible only if each case occupies a fixed number of records, that is,
+   for DP_FIXED parsers and for DP_DELIMITED parsers that do not allow cases
+   to span records.  Other parsers ignore this setting.
+
+   This setting does not affect data_parser_parse(), which always parses one
+   case at a time. */
+void
+data_parser_set_threads (struct data_parser *parser, int n_threads)
+{
+  assert (n_threads >= 1);
+  parser->n_threads = n_threads;
+}
+
 /* Returns true if PARSER is configured to allow cases to span
    multiple records. */
 bool
@@ -215,6 +276,7 @@ data_parser_set_quotes (struct data_parser *parser, struct substring quotes)
 {
   ss_dealloc (&parser->quotes);
   ss_alloc_substring (&parser->quotes, quotes);
+  set_byte_classes (parser);
 }
 
 /* If ESCAPE is false (the default setting), a character used for
@@ -245,7 +307,7 @@ data_parser_set_soft_delimiters (struct data_parser *parser,
 {
   ss_dealloc (&parser->soft_seps);
   ss_alloc_substring (&parser->soft_seps, delimiters);
-  set_any_sep (parser);
+  set_byte_classes (parser);
 }
 
 /* Sets PARSER's hard delimiters to DELIMITERS.  Hard delimiters
@@ -261,7 +323,7 @@ data_parser_set_hard_delimiters (struct data_parser *parser,
 {
   ss_dealloc (&parser->hard_seps);
   ss_alloc_substring (&parser->hard_seps, delimiters);
-  set_any_sep (parser);
+  set_byte_classes (parser);
 }
 
 /* Returns the number of records per case. */
@@ -348,10 +410,41 @@ data_parser_any_fields (const struct data_parser *parser)
 }
 
 static void
-set_any_sep (struct data_parser *parser)
+set_byte_class (struct data_parser *parser, struct substring bytes,
+                unsigned char class)
 {
-  ds_assign_substring (&parser->any_sep, parser->soft_seps);
-  ds_put_substring (&parser->any_sep, parser->hard_seps);
+  size_t i;
+
+  for (i = 0; i < bytes.length; i++)
+    parser->byte_class[(unsigned char) bytes.string[i]] |= class;
+}
+
+static void
+set_byte_classes (struct data_parser *parser)
+{
+  int c;
+
+  memset (parser->byte_class, 0, sizeof parser->byte_class);
+  set_byte_class (parser, parser->soft_seps, BC_SOFT);
+  set_byte_class (parser, parser->hard_seps, BC_HARD);
+  set_byte_class (parser, parser->quotes, BC_QUOTE);
+
+  /* Separators are usually white space or punctuation with small byte
+     values, which span_field() can find all at once.  It has to look for
+     other separators one by one, so it gives up on skipping over 8 bytes at
+     a time if there are too many of them. */
+  parser->sep_below = 0;
+  parser->n_big_seps = 0;
+  for (c = 0; c <= UCHAR_MAX; c++)
+    if (parser->byte_class[c] & (BC_SOFT | BC_HARD))
+      {
+        if (c < '0')
+          parser->sep_below = c + 1;
+        else if (parser->n_big_seps < MAX_BIG_SEPS)
+          parser->big_seps[parser->n_big_seps++] = ONES * c;
+        else
+          parser->n_big_seps = SIZE_MAX;
+      }
 }
 
 static bool parse_delimited_span (const struct data_parser *,
@@ -397,58 +490,248 @@ data_parser_parse (struct data_parser *parser, struct dfm_reader *reader,
   return retval;
 }
 
-/* Extracts a delimited field from the current position in the
-   current record according to PARSER, reading data from READER.
+/* A chunk of records for parsing in parallel with other chunks.
+
+   The main thread reads the records from the data file and creates the
+   cases to be filled in.  Then one thread parses the records into the cases.
+   That thread may not emit messages, because the message code is not
+   thread-safe, so it saves them in the chunk, each one with the index of the
+   case that it concerns, and the main thread emits them in order later. */
+struct dp_chunk
+  {
+    /* Set by the main thread. */
+    const struct data_parser *parser;
+    const char *file_name;      /* Data file name, or NULL. */
+    int first_line;             /* Line number of first record, or -1. */
+    char *encoding;             /* Encoding of all of the records. */
+    bool ascii;                 /* Encoding and dict encoding ASCII-based? */
+    struct string text;         /* Records, concatenated. */
+    size_t *ends;               /* ends[i] is offset just past record i. */
+    size_t n_records, allocated_records;
+    struct ccase **cases;       /* Cases to fill in. */
+    size_t n_cases;
+
+    /* Set by the thread that parses the chunk. */
+    struct dp_chunk_msg *msgs;
+    size_t n_msgs, allocated_msgs;
+  };
+
+/* A message saved by the thread parsing a chunk. */
+struct dp_chunk_msg
+  {
+    size_t case_idx;            /* Index of case in chunk. */
+    struct msg msg;
+  };
+
+/* Context for parsing the fields in a record. */
+struct parse_ctx
+  {
+    const char *file_name;      /* Data file name, or NULL. */
+    int line_number;            /* Line number of record, or -1. */
+    const char *input_encoding; /* Encoding of record. */
+    struct dp_chunk *chunk;     /* Chunk being parsed, or NULL. */
+    size_t case_idx;            /* Index in CHUNK of case being parsed. */
+  };
+
+/* Serializes calls to data_in() and other functions that recode through
+   the shared iconv converters, when they are made by threads parsing
+   chunks. */
+gl_lock_define_initialized (static, recode_lock)
+
+static void
+parse_ctx_init (struct parse_ctx *ctx, const struct dfm_reader *reader)
+{
+  ctx->file_name = dfm_get_file_name (reader);
+  ctx->line_number = dfm_get_line_number (reader);
+  ctx->input_encoding = dfm_reader_get_encoding (reader);
+  ctx->chunk = NULL;
+  ctx->case_idx = 0;
+}
+
+/* Emits M, or saves it in CTX's chunk if there is one. */
+static void
+parse_emit (const struct parse_ctx *ctx, struct msg *m)
+{
+  struct dp_chunk *chunk = ctx->chunk;
+
+  if (chunk == NULL)
+    msg_emit (m);
+  else
+    {
+      struct dp_chunk_msg *cm;
+
+      if (chunk->n_msgs >= chunk->allocated_msgs)
+        chunk->msgs = x2nrealloc (chunk->msgs, &chunk->allocated_msgs,
+                                  sizeof *chunk->msgs);
+      cm = &chunk->msgs[chunk->n_msgs++];
+      cm->case_idx = ctx->case_idx;
+      cm->msg = *m;
+    }
+}
+
+/* Equivalent to msg (DW, FORMAT, ...) but sends the message to
+   parse_emit(). */
+static void PRINTF_FORMAT (2, 3)
+parse_warning (const struct parse_ctx *ctx, const char *format, ...)
+{
+  va_list args;
+  struct msg m;
+
+  va_start (args, format);
+  m.category = msg_class_to_category (DW);
+  m.severity = msg_class_to_severity (DW);
+  m.file_name = NULL;
+  m.first_line = m.last_line = 0;
+  m.first_column = m.last_column = 0;
+  m.text = xvasprintf (format, args);
+  va_end (args);
+
+  parse_emit (ctx, &m);
+}
+
+/* Returns true if S contains only ASCII characters. */
+static bool
+is_ascii (struct substring s)
+{
+  size_t i;
+
+  for (i = 0; i < s.length; i++)
+    if ((unsigned char) s.string[i] >= 0x80)
+      return false;
+  return true;
+}
+
+/* Parses S as field F into VALUE, returning NULL if successful or an error
+   message that the caller must free. */
+static char *
+parse_value (const struct data_parser *parser, const struct parse_ctx *ctx,
+             const struct field *f, struct substring s, union value *value)
+{
+  const char *output_encoding = dict_get_encoding (parser->dict);
+  int width = fmt_var_width (&f->format);
+  char *error;
+
+  if (ctx->chunk == NULL)
+    error = data_in (s, ctx->input_encoding, f->format.type,
+                     value, width, output_encoding);
+  else if ((ctx->chunk->ascii && is_ascii (s))
+           || (fmt_get_category (f->format.type)
+               & (FMT_CAT_BINARY | FMT_CAT_LEGACY)))
+    error = data_in_ascii (s, f->format.type, value, width);
+  else
+    {
+      gl_lock_lock (recode_lock);
+      error = data_in (s, ctx->input_encoding, f->format.type,
+                       value, width, output_encoding);
+      gl_lock_unlock (recode_lock);
+    }
+  return error;
+}
+
+/* Returns true if 64-bit word X might contain a soft or hard separator for
+   PARSER, false if it definitely does not. */
+static inline bool
+word_may_have_sep (const struct data_parser *parser, uint64_t x)
+{
+  size_t i;
+
+  if (parser->sep_below && HAS_BYTE_BELOW (x, parser->sep_below))
+    return true;
+  for (i = 0; i < parser->n_big_seps; i++)
+    if (HAS_ZERO_BYTE (x ^ parser->big_seps[i]))
+      return true;
+  return false;
+}
+
+/* Returns the number of bytes at the start of S that are not soft or hard
+   separators for PARSER, like ss_cspan() with both kinds of separators as
+   the stop set.  Long fields are skipped over 8 bytes at a time. */
+static size_t
+span_field (const struct data_parser *parser, struct substring s)
+{
+  const unsigned char *p = CHAR_CAST (const unsigned char *, s.string);
+  size_t i = 0;
+
+  if (parser->n_big_seps <= MAX_BIG_SEPS)
+    for (; i + 8 <= s.length; i += 8)
+      {
+        uint64_t x;
+
+        memcpy (&x, &p[i], 8);
+        if (word_may_have_sep (parser, x))
+          break;
+      }
+
+  for (; i < s.length; i++)
+    if (parser->byte_class[p[i]] & (BC_SOFT | BC_HARD))
+      break;
+  return i;
+}
+
+/* Returns the number of soft separators for PARSER at the start of S. */
+static size_t
+span_soft_seps (const struct data_parser *parser, struct substring s)
+{
+  size_t i;
+
+  for (i = 0; i < s.length; i++)
+    if (!(parser->byte_class[(unsigned char) s.string[i]] & BC_SOFT))
+      break;
+  return i;
+}
+
+/* Extracts a delimited field from LINE according to PARSER,
+   starting at 0-based offset *POS, which may be beyond the end of
+   LINE.  (DATA LIST uses a beyond-the-end position to deal with an
+   empty field at the end of the line.)
 
    *FIELD is set to the field content.  The caller must not or
    destroy this constant string.
 
    Sets *FIRST_COLUMN to the 1-based column number of the start of
    the extracted field, and *LAST_COLUMN to the end of the extracted
-   field.
+   field, and advances *POS past the field and its delimiters.
 
-   Returns true on success, false on failure. */
+   Returns true on success, false if no more fields remain in LINE. */
 static bool
-cut_field (const struct data_parser *parser, struct dfm_reader *reader,
-           int *first_column, int *last_column, struct string *tmp,
-           struct substring *field)
+cut_field__ (const struct data_parser *parser, const struct parse_ctx *ctx,
+             struct substring line, size_t *pos,
+             int *first_column, int *last_column, struct string *tmp,
+             struct substring *field)
 {
   size_t length_before_separators;
-  struct substring line, p;
+  struct substring start, p;
   bool quoted;
 
-  if (dfm_eof (reader))
-    return false;
-  if (ss_is_empty (parser->hard_seps))
-    dfm_expand_tabs (reader);
-  line = p = dfm_get_record (reader);
+  start = p = ss_substr (line, *pos, SIZE_MAX);
 
   /* Skip leading soft separators. */
-  ss_ltrim (&p, parser->soft_seps);
+  ss_advance (&p, span_soft_seps (parser, p));
 
   /* Handle empty or completely consumed lines. */
   if (ss_is_empty (p))
     {
-      if (!parser->empty_line_has_field || dfm_columns_past_end (reader) > 0)
+      if (!parser->empty_line_has_field || *pos > ss_length (line))
         return false;
       else
         {
           *field = p;
-          *first_column = dfm_column_start (reader);
+          *first_column = *pos + 1;
           *last_column = *first_column + 1;
-          dfm_forward_columns (reader, 1);
+          *pos += 1;
           return true;
         }
     }
 
-  *first_column = dfm_column_start (reader);
-  quoted = ss_find_byte (parser->quotes, ss_first (p)) != SIZE_MAX;
+  *first_column = *pos + 1;
+  quoted = (parser->byte_class[(unsigned char) ss_first (p)]
+            & BC_QUOTE) != 0;
   if (quoted)
     {
       /* Quoted field. */
       int quote = ss_get_byte (&p);
       if (!ss_get_until (&p, quote, field))
-        msg (DW, _("Quoted string extends beyond end of line."));
+        parse_warning (ctx, _("Quoted string extends beyond end of line."));
       if (parser->quote_escape && ss_first (p) == quote)
         {
           ds_assign_substring (tmp, *field);
@@ -457,58 +740,131 @@ cut_field (const struct data_parser *parser, struct dfm_reader *reader,
               struct substring ss;
               ds_put_byte (tmp, quote);
               if (!ss_get_until (&p, quote, &ss))
-                msg (DW, _("Quoted string extends beyond end of line."));
+                parse_warning (ctx,
+                               _("Quoted string extends beyond end of line."));
               ds_put_substring (tmp, ss);
             }
           *field = ds_ss (tmp);
         }
-      *last_column = *first_column + (ss_length (line) - ss_length (p));
+      *last_column = *first_column + (ss_length (start) - ss_length (p));
     }
   else
     {
       /* Regular field. */
-      ss_get_bytes (&p, ss_cspan (p, ds_ss (&parser->any_sep)), field);
+      ss_get_bytes (&p, span_field (parser, p), field);
       *last_column = *first_column + ss_length (*field);
     }
 
   /* Skip trailing soft separator and a single hard separator if present. */
   length_before_separators = ss_length (p);
-  ss_ltrim (&p, parser->soft_seps);
+  ss_advance (&p, span_soft_seps (parser, p));
   if (!ss_is_empty (p)
-      && ss_find_byte (parser->hard_seps, ss_first (p)) != SIZE_MAX)
+      && parser->byte_class[(unsigned char) ss_first (p)] & BC_HARD)
     {
       ss_advance (&p, 1);
-      ss_ltrim (&p, parser->soft_seps);
+      ss_advance (&p, span_soft_seps (parser, p));
     }
   if (ss_is_empty (p))
-    dfm_forward_columns (reader, 1);
+    *pos += 1;
   else if (quoted && length_before_separators == ss_length (p))
-    msg (DW, _("Missing delimiter following quoted string."));
-  dfm_forward_columns (reader, ss_length (line) - ss_length (p));
+    parse_warning (ctx, _("Missing delimiter following quoted string."));
+  *pos += ss_length (start) - ss_length (p);
+
+  return true;
+}
+
+/* Extracts a delimited field from the current position in the
+   current record according to PARSER, reading data from READER.
+
+   *FIELD is set to the field content.  The caller must not or
+   destroy this constant string.
+
+   Sets *FIRST_COLUMN to the 1-based column number of the start of
+   the extracted field, and *LAST_COLUMN to the end of the extracted
+   field.
+
+   Returns true on success, false on failure. */
+static bool
+cut_field (const struct data_parser *parser, struct dfm_reader *reader,
+           int *first_column, int *last_column, struct string *tmp,
+           struct substring *field)
+{
+  struct parse_ctx ctx;
+  size_t column, pos;
+
+  if (dfm_eof (reader))
+    return false;
+  if (ss_is_empty (parser->hard_seps))
+    dfm_expand_tabs (reader);
 
+  /* dfm_get_record() returns the record starting from the current column,
+     so parse it starting from offset 0, or from just past its end if the
+     current column is already beyond the end of the record. */
+  parse_ctx_init (&ctx, reader);
+  column = dfm_column_start (reader);
+  pos = dfm_columns_past_end (reader) > 0;
+  if (!cut_field__ (parser, &ctx, dfm_get_record (reader), &pos,
+                    first_column, last_column, tmp, field))
+    return false;
+
+  *first_column += column - 1;
+  *last_column += column - 1;
+  dfm_forward_columns (reader, pos);
   return true;
 }
 
 static void
-parse_error (const struct dfm_reader *reader, const struct field *field,
+parse_error (const struct parse_ctx *ctx, const struct field *field,
              int first_column, int last_column, char *error)
 {
   struct msg m;
 
   m.category = MSG_C_DATA;
   m.severity = MSG_S_WARNING;
-  m.file_name = CONST_CAST (char *, dfm_get_file_name (reader));
-  m.first_line = dfm_get_line_number (reader);
+  m.file_name = CONST_CAST (char *, ctx->file_name);
+  m.first_line = ctx->line_number;
   m.last_line = m.first_line + 1;
   m.first_column = first_column;
   m.last_column = last_column;
   m.text = xasprintf (_("Data for variable %s is not valid as format %s: %s"),
                       field->name, fmt_name (field->format.type), error);
-  msg_emit (&m);
+  parse_emit (ctx, &m);
 
   free (error);
 }
 
+/* Parses the fields in LINE, which is record number ROW (1-based) within a
+   case, into C, according to fixed-format syntax rules in PARSER. */
+static void
+parse_fixed_record (const struct data_parser *parser,
+                    const struct parse_ctx *ctx, int row,
+                    struct substring line, struct ccase *c)
+{
+  const struct field *f;
+
+  for (f = parser->fields; f < &parser->fields[parser->field_cnt]; f++)
+    if (f->record == row)
+      {
+        struct substring s = ss_substr (line, f->first_column - 1,
+                                        f->format.w);
+        union value *value = case_data_rw_idx (c, f->case_idx);
+        char *error = parse_value (parser, ctx, f, s, value);
+
+        if (error != NULL)
+          parse_error (ctx, f, f->first_column,
+                       f->first_column + f->format.w, error);
+        else if (f->format.d > 0)
+          {
+            if (ctx->chunk != NULL)
+              gl_lock_lock (recode_lock);
+            data_in_imply_decimals (s, ctx->input_encoding, f->format.type,
+                                    f->format.d, value);
+            if (ctx->chunk != NULL)
+              gl_lock_unlock (recode_lock);
+          }
+      }
+}
+
 /* Reads a case from READER into C, parsing it according to
    fixed-format syntax rules in PARSER.
    Returns true if successful, false at end of file or on I/O error. */
@@ -516,18 +872,14 @@ static bool
 parse_fixed (const struct data_parser *parser, struct dfm_reader *reader,
              struct ccase *c)
 {
-  const char *input_encoding = dfm_reader_get_encoding (reader);
-  const char *output_encoding = dict_get_encoding (parser->dict);
-  struct field *f;
   int row;
 
   if (dfm_eof (reader))
     return false;
 
-  f = parser->fields;
   for (row = 1; row <= parser->records_per_case; row++)
     {
-      struct substring line;
+      struct parse_ctx ctx;
 
       if (dfm_eof (reader))
         {
@@ -536,24 +888,9 @@ parse_fixed (const struct data_parser *parser, struct dfm_reader *reader,
           return false;
         }
       dfm_expand_tabs (reader);
-      line = dfm_get_record (reader);
 
-      for (; f < &parser->fields[parser->field_cnt] && f->record == row; f++)
-        {
-          struct substring s = ss_substr (line, f->first_column - 1,
-                                          f->format.w);
-          union value *value = case_data_rw_idx (c, f->case_idx);
-          char *error = data_in (s, input_encoding, f->format.type,
-                                 value, fmt_var_width (&f->format),
-                                 output_encoding);
-
-          if (error == NULL)
-            data_in_imply_decimals (s, input_encoding, f->format.type,
-                                    f->format.d, value);
-          else
-            parse_error (reader, f, f->first_column,
-                         f->first_column + f->format.w, error);
-        }
+      parse_ctx_init (&ctx, reader);
+      parse_fixed_record (parser, &ctx, row, dfm_get_record (reader), c);
 
       dfm_forward_record (reader);
     }
@@ -568,12 +905,12 @@ static bool
 parse_delimited_span (const struct data_parser *parser,
                       struct dfm_reader *reader, struct ccase *c)
 {
-  const char *output_encoding = dict_get_encoding (parser->dict);
   struct string tmp = DS_EMPTY_INITIALIZER;
   struct field *f;
 
   for (f = parser->fields; f < &parser->fields[parser->field_cnt]; f++)
     {
+      struct parse_ctx ctx;
       struct substring s;
       int first_column, last_column;
       char *error;
@@ -594,31 +931,27 @@ parse_delimited_span (const struct data_parser *parser,
 	    }
 	}
 
-      const char *input_encoding = dfm_reader_get_encoding (reader);
-      error = data_in (s, input_encoding, f->format.type,
-                       case_data_rw_idx (c, f->case_idx),
-                       fmt_var_width (&f->format), output_encoding);
+      parse_ctx_init (&ctx, reader);
+      error = parse_value (parser, &ctx, f, s,
+                           case_data_rw_idx (c, f->case_idx));
       if (error != NULL)
-        parse_error (reader, f, first_column, last_column, error);
+        parse_error (&ctx, f, first_column, last_column, error);
     }
   ds_destroy (&tmp);
   return true;
 }
 
-/* Reads a case from READER into C, parsing it according to
-   delimited syntax rules with one case per record in PARSER.
-   Returns true if successful, false at end of file or on I/O error. */
-static bool
-parse_delimited_no_span (const struct data_parser *parser,
-                         struct dfm_reader *reader, struct ccase *c)
+/* Parses LINE, which contains exactly one case, into C according to
+   delimited syntax rules in PARSER. */
+static void
+parse_delimited_record (const struct data_parser *parser,
+                        const struct parse_ctx *ctx, struct substring line,
+                        struct ccase *c)
 {
-  const char *output_encoding = dict_get_encoding (parser->dict);
   struct string tmp = DS_EMPTY_INITIALIZER;
   struct substring s;
-  struct field *f, *end;
-
-  if (dfm_eof (reader))
-    return false;
+  const struct field *f, *end;
+  size_t pos = 0;
 
   end = &parser->fields[parser->field_cnt];
   for (f = parser->fields; f < end; f++)
@@ -626,38 +959,57 @@ parse_delimited_no_span (const struct data_parser *parser,
       int first_column, last_column;
       char *error;
 
-      if (!cut_field (parser, reader, &first_column, &last_column, &tmp, &s))
+      if (!cut_field__ (parser, ctx, line, &pos,
+                        &first_column, &last_column, &tmp, &s))
 	{
 	  if (f < end - 1 && settings_get_undefined () && parser->warn_missing_fields)
-	    msg (DW, _("Missing value(s) for all variables from %s onward.  "
-                       "These will be filled with the system-missing value "
-                       "or blanks, as appropriate."),
-		 f->name);
+	    parse_warning (ctx, _("Missing value(s) for all variables from "
+                                  "%s onward.  These will be filled with "
+                                  "the system-missing value or blanks, as "
+                                  "appropriate."),
+                           f->name);
           for (; f < end; f++)
             value_set_missing (case_data_rw_idx (c, f->case_idx),
                                fmt_var_width (&f->format));
           goto exit;
 	}
 
-      const char *input_encoding = dfm_reader_get_encoding (reader);
-      error = data_in (s, input_encoding, f->format.type,
-                       case_data_rw_idx (c, f->case_idx),
-                       fmt_var_width (&f->format), output_encoding);
+      error = parse_value (parser, ctx, f, s,
+                           case_data_rw_idx (c, f->case_idx));
       if (error != NULL)
-        parse_error (reader, f, first_column, last_column, error);
+        parse_error (ctx, f, first_column, last_column, error);
     }
 
-  s = dfm_get_record (reader);
-  ss_ltrim (&s, parser->soft_seps);
+  s = ss_substr (line, pos, SIZE_MAX);
+  ss_advance (&s, span_soft_seps (parser, s));
   if (!ss_is_empty (s))
-    msg (DW, _("Record ends in data not part of any field."));
+    parse_warning (ctx, _("Record ends in data not part of any field."));
 
 exit:
-  dfm_forward_record (reader);
   ds_destroy (&tmp);
+}
+
+/* Reads a case from READER into C, parsing it according to
+   delimited syntax rules with one case per record in PARSER.
+   Returns true if successful, false at end of file or on I/O error. */
+static bool
+parse_delimited_no_span (const struct data_parser *parser,
+                         struct dfm_reader *reader, struct ccase *c)
+{
+  struct parse_ctx ctx;
+
+  if (dfm_eof (reader))
+    return false;
+  if (ss_is_empty (parser->hard_seps))
+    dfm_expand_tabs (reader);
+
+  parse_ctx_init (&ctx, reader);
+  parse_delimited_record (parser, &ctx, dfm_get_record (reader), c);
+
+  dfm_forward_record (reader);
   return true;
 }
-
+
 /* Displays a table giving information on fixed-format variable
    parsing on DATA LIST. */
 static void
@@ -747,8 +1099,19 @@ struct data_parser_casereader
     struct data_parser *parser; /* Parser. */
     struct dfm_reader *reader;  /* Data file reader. */
     struct caseproto *proto;    /* Format of cases. */
+
+    /* For parsing in parallel, a batch of chunks, one per thread.  Null if
+       parsing serially. */
+    struct dp_chunk *chunks;
+    size_t n_chunks;            /* Number of chunks in use. */
+    size_t chunk_idx;           /* Chunk currently being returned. */
+    size_t case_idx;            /* Next case to return from the chunk. */
+    size_t msg_idx;             /* Next message to emit from the chunk. */
   };
 
+/* Maximum number of cases in a chunk. */
+#define DP_CHUNK_CASES 4096
+
 static const struct casereader_class data_parser_casereader_class;
 
 /* Replaces DS's active dataset by an input program that reads data
@@ -773,6 +1136,17 @@ data_parser_make_active_file (struct data_parser *parser, struct dataset *ds,
   r->parser = parser;
   r->reader = reader;
   r->proto = caseproto_ref (dict_get_proto (dict));
+  r->chunks = NULL;
+  r->n_chunks = r->chunk_idx = r->case_idx = r->msg_idx = 0;
+  if (parser->n_threads > 1
+      && (parser->type == DP_FIXED || !parser->span))
+    {
+      size_t i;
+
+      r->chunks = xcalloc (parser->n_threads, sizeof *r->chunks);
+      for (i = 0; i < parser->n_threads; i++)
+        ds_init_empty (&r->chunks[i].text);
+    }
   casereader0 = casereader_create_sequential (NULL, r->proto,
                                              CASENUMBER_MAX,
                                              &data_parser_casereader_class, r);
@@ -786,12 +1160,235 @@ data_parser_make_active_file (struct data_parser *parser, struct dataset *ds,
   dataset_set_source (ds, casereader1);
 }
 
+/* Empties CHUNK so that it may be reused. */
+static void
+dp_chunk_clear (struct dp_chunk *chunk)
+{
+  size_t i;
+
+  for (i = 0; i < chunk->n_cases; i++)
+    case_unref (chunk->cases[i]);
+  free (chunk->cases);
+  chunk->cases = NULL;
+  chunk->n_cases = 0;
+
+  for (i = 0; i < chunk->n_msgs; i++)
+    free (chunk->msgs[i].msg.text);
+  chunk->n_msgs = 0;
+
+  free (chunk->encoding);
+  chunk->encoding = NULL;
+  ds_clear (&chunk->text);
+  chunk->n_records = 0;
+}
+
+static void
+dp_chunk_destroy (struct dp_chunk *chunk)
+{
+  dp_chunk_clear (chunk);
+  free (chunk->msgs);
+  free (chunk->ends);
+  ds_destroy (&chunk->text);
+}
+
+/* Reads records from R's data file into CHUNK, which must be empty, and
+   creates the cases that they will be parsed into.  Returns true if at
+   least one record was read, false at end of file. */
+static bool
+dp_chunk_read (struct data_parser_casereader *r, struct dp_chunk *chunk)
+{
+  const struct data_parser *parser = r->parser;
+  int records_per_case = (parser->type == DP_FIXED
+                          ? parser->records_per_case : 1);
+  size_t max_records = DP_CHUNK_CASES * records_per_case;
+  bool expand_tabs = (parser->type == DP_FIXED
+                      || ss_is_empty (parser->hard_seps));
+  size_t i;
+
+  assert (chunk->n_records == 0);
+  while (chunk->n_records < max_records && !dfm_eof (r->reader))
+    {
+      const char *encoding = dfm_reader_get_encoding (r->reader);
+
+      if (chunk->n_records == 0)
+        {
+          chunk->parser = parser;
+          chunk->file_name = dfm_get_file_name (r->reader);
+          chunk->first_line = dfm_get_line_number (r->reader);
+          chunk->encoding = xstrdup (encoding);
+          chunk->ascii = (is_encoding_ascii_compatible (encoding)
+                          && is_encoding_ascii_compatible (
+                            dict_get_encoding (parser->dict)));
+        }
+      else if (chunk->n_records % records_per_case == 0
+               && strcmp (encoding, chunk->encoding))
+        {
+          /* Start a new chunk for the new encoding. */
+          break;
+        }
+
+      if (expand_tabs)
+        dfm_expand_tabs (r->reader);
+      ds_put_substring (&chunk->text, dfm_get_record (r->reader));
+      if (chunk->n_records >= chunk->allocated_records)
+        chunk->ends = x2nrealloc (chunk->ends, &chunk->allocated_records,
+                                  sizeof *chunk->ends);
+      chunk->ends[chunk->n_records++] = ds_length (&chunk->text);
+      dfm_forward_record (r->reader);
+    }
+
+  /* Creating a case references R->proto, which is not thread-safe, so we
+     create the cases here instead of in the thread that parses them. */
+  chunk->n_cases = chunk->n_records / records_per_case;
+  chunk->cases = xnmalloc (chunk->n_cases, sizeof *chunk->cases);
+  for (i = 0; i < chunk->n_cases; i++)
+    chunk->cases[i] = case_create (r->proto);
+
+  return chunk->n_records > 0;
+}
+
+/* Parses the records in CHUNK_ into its cases.  This may be called from any
+   thread, concurrently with other chunks. */
+static void *
+dp_chunk_parse (void *chunk_)
+{
+  struct dp_chunk *chunk = chunk_;
+  const struct data_parser *parser = chunk->parser;
+  int records_per_case = (parser->type == DP_FIXED
+                          ? parser->records_per_case : 1);
+  struct parse_ctx ctx;
+  size_t record;
+
+  ctx.file_name = chunk->file_name;
+  ctx.line_number = chunk->first_line;
+  ctx.input_encoding = chunk->encoding;
+  ctx.chunk = chunk;
+  for (ctx.case_idx = 0; ctx.case_idx < chunk->n_cases; ctx.case_idx++)
+    {
+      struct ccase *c = chunk->cases[ctx.case_idx];
+      int row;
+
+      for (row = 1; row <= records_per_case; row++)
+        {
+          size_t start;
+          struct substring line;
+
+          record = ctx.case_idx * records_per_case + (row - 1);
+          start = record > 0 ? chunk->ends[record - 1] : 0;
+          line = ds_substr (&chunk->text, start,
+                            chunk->ends[record] - start);
+          ctx.line_number = (chunk->first_line < 0 ? -1
+                             : chunk->first_line + record);
+
+          if (parser->type == DP_FIXED)
+            parse_fixed_record (parser, &ctx, row, line, c);
+          else
+            parse_delimited_record (parser, &ctx, line, c);
+        }
+    }
+
+  /* A partial case can only occur at the end of the file. */
+  record = chunk->n_cases * records_per_case;
+  if (record < chunk->n_records)
+    parse_warning (&ctx, _("Partial case of %d of %d records discarded."),
+                   (int) (chunk->n_records - record), records_per_case);
+
+  return NULL;
+}
+
+/* Reads and parses the next batch of chunks in R.  Returns true if
+   successful, false at end of file. */
+static bool
+dp_read_batch (struct data_parser_casereader *r)
+{
+  struct data_parser *parser = r->parser;
+  gl_thread_t *threads;
+  bool *started;
+  size_t i;
+
+  for (; parser->skip_records > 0; parser->skip_records--)
+    {
+      if (dfm_eof (r->reader))
+        return false;
+      dfm_forward_record (r->reader);
+    }
+
+  for (i = 0; i < r->n_chunks; i++)
+    dp_chunk_clear (&r->chunks[i]);
+  r->n_chunks = r->chunk_idx = r->case_idx = r->msg_idx = 0;
+
+  while (r->n_chunks < parser->n_threads
+         && dp_chunk_read (r, &r->chunks[r->n_chunks]))
+    r->n_chunks++;
+  if (r->n_chunks == 0)
+    return false;
+
+  /* Parse the first chunk in this thread and the others in new threads,
+     falling back to this thread if a new thread cannot be created. */
+  threads = xnmalloc (r->n_chunks, sizeof *threads);
+  started = xnmalloc (r->n_chunks, sizeof *started);
+  for (i = 1; i < r->n_chunks; i++)
+    started[i] = !glthread_create (&threads[i], dp_chunk_parse,
+                                   &r->chunks[i]);
+  dp_chunk_parse (&r->chunks[0]);
+  for (i = 1; i < r->n_chunks; i++)
+    if (!started[i])
+      dp_chunk_parse (&r->chunks[i]);
+  for (i = 1; i < r->n_chunks; i++)
+    if (started[i])
+      glthread_join (threads[i], NULL);
+  free (started);
+  free (threads);
+
+  return true;
+}
+
+/* Returns the next case from R, which is parsing in parallel. */
+static struct ccase *
+dp_read_parallel (struct data_parser_casereader *r)
+{
+  for (;;)
+    {
+      if (r->chunk_idx < r->n_chunks)
+        {
+          struct dp_chunk *chunk = &r->chunks[r->chunk_idx];
+
+          /* Emit the messages for the next case, or for the end of the
+             chunk if there are no more cases. */
+          while (r->msg_idx < chunk->n_msgs
+                 && chunk->msgs[r->msg_idx].case_idx <= r->case_idx)
+            {
+              /* msg_emit() frees the message's text. */
+              struct msg *m = &chunk->msgs[r->msg_idx++].msg;
+              msg_emit (m);
+              m->text = NULL;
+            }
+
+          if (r->case_idx < chunk->n_cases)
+            {
+              struct ccase *c = chunk->cases[r->case_idx];
+              chunk->cases[r->case_idx++] = NULL;
+              return c;
+            }
+
+          r->chunk_idx++;
+          r->case_idx = r->msg_idx = 0;
+        }
+      else if (!dp_read_batch (r))
+        return NULL;
+    }
+}
 
 static struct ccase *
 data_parser_casereader_read (struct casereader *reader UNUSED, void *r_)
 {
   struct data_parser_casereader *r = r_;
-  struct ccase *c = case_create (r->proto);
+  struct ccase *c;
+
+  if (r->chunks != NULL)
+    return dp_read_parallel (r);
+
+  c = case_create (r->proto);
   if (data_parser_parse (r->parser, r->reader, c))
     return c;
   else
@@ -807,6 +1404,14 @@ data_parser_casereader_destroy (struct casereader *reader UNUSED, void *r_)
   struct data_parser_casereader *r = r_;
   if (dfm_reader_error (r->reader))
     casereader_force_error (reader);
+  if (r->chunks != NULL)
+    {
+      size_t i;
+
+      for (i = 0; i < r->parser->n_threads; i++)
+        dp_chunk_destroy (&r->chunks[i]);
+      free (r->chunks);
+    }
   data_parser_destroy (r->parser);
   dfm_close_reader (r->reader);
   caseproto_unref (r->proto);
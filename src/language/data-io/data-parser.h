@@ -46,6 +46,9 @@ void data_parser_set_type (struct data_parser *, enum data_parser_type);
 
 void data_parser_set_skip (struct data_parser *, int initial_records_to_skip);
 
+int data_parser_get_threads (const struct data_parser *);
+void data_parser_set_threads (struct data_parser *, int n_threads);
+
 /* For configuring delimited parsers only. */
 bool data_parser_get_span (const struct data_parser *);
 void data_parser_set_span (struct data_parser *, bool may_cases_span_records);
@@ -62,7 +62,9 @@ struct dfm_reader
     struct file_handle *fh;     /* File handle. */
     struct fh_lock *lock;       /* Mutual exclusion lock for file. */
     int line_number;            /* Current line or record number. */
-    struct string line;         /* Current line. */
+    struct string line;         /* Line buffer. */
+    struct substring record;    /* Current line, in 'line' or, for the
+                                   inline file, in the lexer's buffer. */
     struct string scratch;      /* Extra line buffer. */
     enum dfm_reader_flags flags; /* Zero or more of DFM_*. */
     FILE *file;                 /* Associated file. */
@@ -147,6 +149,7 @@ dfm_open_reader (struct file_handle *fh, struct lexer *lexer,
   r->lock = lock;
   r->lexer = lexer;
   ds_init_empty (&r->line);
+  r->record = ss_empty ();
   ds_init_empty (&r->scratch);
   r->flags = DFM_ADVANCE;
   r->eof_cnt = 0;
@@ -223,10 +226,17 @@ read_inline_record (struct dfm_reader *r)
       lex_match (r->lexer, T_ENDCMD);
     }
 
+  bool is_data;
   if (r->flags & DFM_CONSUME)
-    lex_get (r->lexer);
+    is_data = lex_get_inline_data (r->lexer, &r->record);
+  else
+    {
+      is_data = lex_is_string (r->lexer);
+      if (is_data)
+        r->record = lex_tokss (r->lexer);
+    }
 
-  if (!lex_is_string (r->lexer))
+  if (!is_data)
     {
       if (!lex_match_id (r->lexer, "END") || !lex_match_id (r->lexer, "DATA"))
         {
@@ -240,7 +250,6 @@ read_inline_record (struct dfm_reader *r)
       return false;
     }
 
-  ds_assign_substring (&r->line, lex_tokss (r->lexer));
   r->flags |= DFM_CONSUME;
 
   return true;
@@ -531,7 +540,10 @@ read_record (struct dfm_reader *r)
     {
       bool ok = read_file_record (r);
       if (ok)
-        r->line_number++;
+        {
+          r->line_number++;
+          r->record = ds_ss (&r->line);
+        }
       return ok;
     }
   else
@@ -583,7 +595,7 @@ dfm_get_record (struct dfm_reader *r)
   assert ((r->flags & DFM_ADVANCE) == 0);
   assert (r->eof_cnt == 0);
 
-  return ds_substr (&r->line, r->pos, SIZE_MAX);
+  return ss_substr (r->record, r->pos, SIZE_MAX);
 }
 
 /* Expands tabs in the current line into the equivalent number of
@@ -605,22 +617,22 @@ dfm_expand_tabs (struct dfm_reader *r)
   if (r->fh != fh_inline_file ()
       && (fh_get_mode (r->fh) != FH_MODE_TEXT
           || fh_get_tab_width (r->fh) == 0
-          || ds_find_byte (&r->line, '\t') == SIZE_MAX))
+          || ss_find_byte (r->record, '\t') == SIZE_MAX))
     return;
 
-  /* Expand tabs from r->line into r->scratch, and figure out
+  /* Expand tabs from r->record into r->scratch, and figure out
      new value for r->pos. */
   tab_width = fh_get_tab_width (r->fh);
   ds_clear (&r->scratch);
   new_pos = SIZE_MAX;
-  for (ofs = 0; ofs < ds_length (&r->line); ofs++)
+  for (ofs = 0; ofs < r->record.length; ofs++)
     {
       unsigned char c;
 
       if (ofs == r->pos)
         new_pos = ds_length (&r->scratch);
 
-      c = ds_data (&r->line)[ofs];
+      c = r->record.string[ofs];
       if (c != '\t')
         ds_put_byte (&r->scratch, c);
       else
@@ -636,12 +648,13 @@ dfm_expand_tabs (struct dfm_reader *r)
          length that we had before.  DATA LIST uses a
          beyond-the-end position to deal with an empty field at
          the end of the line. */
-      assert (r->pos >= ds_length (&r->line));
-      new_pos = (r->pos - ds_length (&r->line)) + ds_length (&r->scratch);
+      assert (r->pos >= r->record.length);
+      new_pos = (r->pos - r->record.length) + ds_length (&r->scratch);
     }
 
   /* Swap r->line and r->scratch and set new r->pos. */
   ds_swap (&r->line, &r->scratch);
+  r->record = ds_ss (&r->line);
   r->pos = new_pos;
 }
 
@@ -694,7 +707,7 @@ dfm_column_start (const struct dfm_reader *r)
 size_t
 dfm_columns_past_end (const struct dfm_reader *r)
 {
-  return r->pos < ds_length (&r->line) ? 0 : ds_length (&r->line) - r->pos;
+  return r->pos < r->record.length ? 0 : r->record.length - r->pos;
 }
 
 /* Returns the 1-based column within the current line that P
@@ -702,7 +715,7 @@ dfm_columns_past_end (const struct dfm_reader *r)
 size_t
 dfm_get_column (const struct dfm_reader *r, const char *p)
 {
-  return ds_pointer_to_position (&r->line, p) + 1;
+  return ss_pointer_to_position (r->record, p) + 1;
 }
 
 const char *
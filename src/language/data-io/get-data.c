@@ -21,6 +21,10 @@
 
 #include <string.h>
 
+#include "data/any-reader.h"
+#include "data/arrow-file-reader.h"
+#include "data/case-map.h"
+#include "data/casereader.h"
 #include "data/dataset.h"
 #include "data/dictionary.h"
 #include "data/format.h"
@@ -29,17 +33,21 @@
 #include "data/spreadsheet-reader.h"
 #include "data/psql-reader.h"
 #include "data/settings.h"
+#include "data/variable.h"
 #include "language/command.h"
 #include "language/data-io/data-parser.h"
 #include "language/data-io/data-reader.h"
 #include "language/data-io/file-handle.h"
 #include "language/data-io/placement-parser.h"
+#include "language/data-io/trim.h"
 #include "language/lexer/format-parser.h"
 #include "language/lexer/lexer.h"
+#include "language/lexer/value-parser.h"
 #include "libpspp/cast.h"
 #include "libpspp/i18n.h"
 #include "libpspp/message.h"
 
+#include "gl/minmax.h"
 #include "gl/xalloc.h"
 
 #include "gettext.h"
@@ -53,6 +61,7 @@ static void destroy_spreadsheet_read_info (struct spreadsheet_read_options *);
 
 static int parse_get_txt (struct lexer *lexer, struct dataset *);
 static int parse_get_psql (struct lexer *lexer, struct dataset *);
+static int parse_get_arrow (struct lexer *lexer, struct dataset *);
 
 int
 cmd_get_data (struct lexer *lexer, struct dataset *ds)
@@ -90,6 +99,11 @@ cmd_get_data (struct lexer *lexer, struct dataset *ds)
       free (tok);
       return parse_get_psql (lexer, ds);
     }
+  else if (lex_match_id (lexer, "ARROW"))
+    {
+      free (tok);
+      return parse_get_arrow (lexer, ds);
+    }
   else if (lex_match_id (lexer, "GNM") ||
       lex_match_id (lexer, "ODS"))
     {
@@ -217,6 +231,159 @@ parse_get_psql (struct lexer *lexer, struct dataset *ds)
   return CMD_FAILURE;
 }
 
+/* A range of values selected with the SELECT subcommand. */
+struct arrow_select
+  {
+    char *name;                 /* Column name. */
+    double low, high;           /* Range of values to read. */
+  };
+
+static int
+parse_get_arrow (struct lexer *lexer, struct dataset *ds)
+{
+  struct any_reader *any_reader = NULL;
+  struct casereader *reader = NULL;
+  struct file_handle *fh = NULL;
+  struct dictionary *dict = NULL;
+  struct case_map_stage *stage = NULL;
+  struct case_map *map;
+  char *encoding = NULL;
+  struct arrow_select *selects = NULL;
+  size_t n_selects = 0, allocated_selects = 0;
+  size_t *case_indexes;
+  size_t i, n;
+
+  for (;;)
+    {
+      lex_match (lexer, T_SLASH);
+
+      if (lex_match_id (lexer, "FILE"))
+        {
+          lex_match (lexer, T_EQUALS);
+
+          fh_unref (fh);
+          fh = fh_parse (lexer, FH_REF_FILE, NULL);
+          if (fh == NULL)
+            goto error;
+        }
+      else if (lex_match_id (lexer, "ENCODING"))
+        {
+          lex_match (lexer, T_EQUALS);
+
+          if (!lex_force_string (lexer))
+            goto error;
+
+          free (encoding);
+          encoding = ss_xstrdup (lex_tokss (lexer));
+
+          lex_get (lexer);
+        }
+      else if (lex_match_id (lexer, "SELECT"))
+        {
+          lex_match (lexer, T_EQUALS);
+
+          do
+            {
+              struct arrow_select *sel;
+
+              if (!lex_force_id (lexer))
+                goto error;
+
+              if (n_selects >= allocated_selects)
+                selects = x2nrealloc (selects, &allocated_selects,
+                                      sizeof *selects);
+              sel = &selects[n_selects++];
+              sel->name = xstrdup (lex_tokcstr (lexer));
+              lex_get (lexer);
+
+              if (!lex_force_match (lexer, T_LPAREN)
+                  || !parse_num_range (lexer, &sel->low, &sel->high, NULL)
+                  || !lex_force_match (lexer, T_RPAREN))
+                goto error;
+            }
+          while (lex_token (lexer) == T_ID);
+        }
+      else
+        break;
+    }
+
+  if (fh == NULL)
+    {
+      lex_sbc_missing ("FILE");
+      goto error;
+    }
+
+  any_reader = any_reader_open (fh);
+  if (any_reader == NULL)
+    goto error;
+  if (any_reader->klass != &arrow_file_reader_class)
+    {
+      msg (SE, _("`%s' is not an Arrow file."), fh_get_file_name (fh));
+      goto error;
+    }
+  for (i = 0; i < n_selects; i++)
+    if (!arrow_reader_select_range (any_reader, selects[i].name,
+                                    selects[i].low, selects[i].high))
+      goto error;
+
+  reader = any_reader_decode (any_reader, encoding, &dict, NULL);
+  any_reader = NULL;
+  if (reader == NULL)
+    goto error;
+
+  if (dict_get_var_cnt (dict) == 0)
+    {
+      msg (SE, _("%s: Data file dictionary has no variables."),
+           fh_get_name (fh));
+      goto error;
+    }
+
+  stage = case_map_stage_create (dict);
+  while (lex_token (lexer) != T_ENDCMD)
+    {
+      lex_match (lexer, T_SLASH);
+      if (!parse_dict_trim (lexer, dict))
+        goto error;
+    }
+
+  /* Read only the columns for the variables that remain. */
+  n = dict_get_var_cnt (dict);
+  case_indexes = xnmalloc (n, sizeof *case_indexes);
+  for (i = 0; i < n; i++)
+    case_indexes[i] = var_get_case_index (dict_get_var (dict, i));
+  arrow_casereader_project (reader, case_indexes, n);
+  free (case_indexes);
+
+  dict_compact_values (dict);
+  map = case_map_stage_get_case_map (stage);
+  case_map_stage_destroy (stage);
+  if (map != NULL)
+    reader = case_map_create_input_translator (map, reader);
+
+  dataset_set_dict (ds, dict);
+  dataset_set_source (ds, reader);
+
+  for (i = 0; i < n_selects; i++)
+    free (selects[i].name);
+  free (selects);
+  fh_unref (fh);
+  free (encoding);
+  return CMD_SUCCESS;
+
+ error:
+  case_map_stage_destroy (stage);
+  any_reader_close (any_reader);
+  casereader_destroy (reader);
+  if (dict != NULL)
+    dict_destroy (dict);
+  for (i = 0; i < n_selects; i++)
+    free (selects[i].name);
+  free (selects);
+  fh_unref (fh);
+  free (encoding);
+  return CMD_CASCADING_FAILURE;
+}
+
 static bool
 parse_spreadsheet (struct lexer *lexer, char **filename,
 		   struct spreadsheet_read_options *opts)
@@ -482,6 +649,19 @@ parse_get_txt (struct lexer *lexer, struct dataset *ds)
           data_parser_set_records (parser, lex_integer (lexer));
           lex_get (lexer);
         }
+      else if (lex_match_id (lexer, "THREADS"))
+        {
+	  lex_match (lexer, T_EQUALS);
+          if (!lex_force_int (lexer))
+            goto error;
+          if (lex_integer (lexer) < 1)
+            {
+              msg (SE, _("Value of %s must be 1 or greater."), "THREADS");
+              goto error;
+            }
+          data_parser_set_threads (parser, MIN (lex_integer (lexer), 64));
+          lex_get (lexer);
+        }
       else if (lex_match_id (lexer, "IMPORTCASES"))
         {
           lex_match (lexer, T_EQUALS);
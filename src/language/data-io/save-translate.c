@@ -18,6 +18,7 @@
 
 #include <stdlib.h>
 
+#include "data/arrow-file-writer.h"
 #include "data/case-map.h"
 #include "data/casereader.h"
 #include "data/casewriter.h"
@@ -42,7 +43,7 @@
 int
 cmd_save_translate (struct lexer *lexer, struct dataset *ds)
 {
-  enum { CSV_FILE = 1, TAB_FILE } type;
+  enum { CSV_FILE = 1, TAB_FILE, ARROW_FILE } type;
 
   struct dictionary *dict;
   struct case_map_stage *stage;
@@ -51,6 +52,7 @@ cmd_save_translate (struct lexer *lexer, struct dataset *ds)
   struct file_handle *handle;
 
   struct csv_writer_options csv_opts;
+  struct arrow_writer_options arrow_opts;
 
   bool replace;
 
@@ -62,6 +64,7 @@ cmd_save_translate (struct lexer *lexer, struct dataset *ds)
   char decimal;
   char delimiter;
   char qualifier;
+  int bsize;
 
   bool ok;
 
@@ -82,6 +85,7 @@ cmd_save_translate (struct lexer *lexer, struct dataset *ds)
   decimal = settings_get_decimal_char (FMT_F);
   delimiter = 0;
   qualifier = '"';
+  bsize = 0;
 
   stage = case_map_stage_create (dict);
   dict_delete_scratch_vars (dict);
@@ -118,14 +122,30 @@ cmd_save_translate (struct lexer *lexer, struct dataset *ds)
             type = CSV_FILE;
           else if (lex_match_id (lexer, "TAB"))
             type = TAB_FILE;
+          else if (lex_match_id (lexer, "ARROW"))
+            type = ARROW_FILE;
           else
             {
-              lex_error_expecting (lexer, "CSV", "TAB", NULL_SENTINEL);
+              lex_error_expecting (lexer, "CSV", "TAB", "ARROW",
+                                   NULL_SENTINEL);
               goto error;
             }
         }
       else if (lex_match_id (lexer, "REPLACE"))
         replace = true;
+      else if (lex_match_id (lexer, "BSIZE"))
+        {
+          lex_match (lexer, T_EQUALS);
+          if (!lex_force_int (lexer))
+            goto error;
+          if (lex_integer (lexer) <= 0)
+            {
+              msg (SE, _("%s must be a positive integer."), "BSIZE");
+              goto error;
+            }
+          bsize = lex_integer (lexer);
+          lex_get (lexer);
+        }
       else if (lex_match_id (lexer, "FIELDNAMES"))
         include_var_names = true;
       else if (lex_match_id (lexer, "MISSING"))
@@ -258,18 +278,30 @@ cmd_save_translate (struct lexer *lexer, struct dataset *ds)
   dict_delete_scratch_vars (dict);
   dict_compact_values (dict);
 
-  csv_opts.recode_user_missing = recode_user_missing;
-  csv_opts.include_var_names = include_var_names;
-  csv_opts.use_value_labels = use_value_labels;
-  csv_opts.use_print_formats = use_print_formats;
-  csv_opts.decimal = decimal;
-  csv_opts.delimiter = (delimiter ? delimiter
-                        : type == TAB_FILE ? '\t'
-                        : decimal == '.' ? ','
-                        : ';');
-  csv_opts.qualifier = qualifier;
-
-  writer = csv_writer_open (handle, dict, &csv_opts);
+  if (type == ARROW_FILE)
+    {
+      arrow_writer_options_init (&arrow_opts);
+      arrow_opts.recode_user_missing = recode_user_missing;
+      arrow_opts.use_value_labels = use_value_labels;
+      arrow_opts.batch_cases = bsize;
+
+      writer = arrow_writer_open (handle, dict, &arrow_opts);
+    }
+  else
+    {
+      csv_opts.recode_user_missing = recode_user_missing;
+      csv_opts.include_var_names = include_var_names;
+      csv_opts.use_value_labels = use_value_labels;
+      csv_opts.use_print_formats = use_print_formats;
+      csv_opts.decimal = decimal;
+      csv_opts.delimiter = (delimiter ? delimiter
+                            : type == TAB_FILE ? '\t'
+                            : decimal == '.' ? ','
+                            : ';');
+      csv_opts.qualifier = qualifier;
+
+      writer = csv_writer_open (handle, dict, &csv_opts);
+    }
   if (writer == NULL)
     goto error;
   fh_unref (handle);
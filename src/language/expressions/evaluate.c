@@ -19,6 +19,7 @@
 #include "evaluate.h"
 
 #include <ctype.h>
+#include <string.h>
 
 #include "libpspp/assertion.h"
 #include "libpspp/message.h"
@@ -29,15 +30,95 @@
 
 #include "xalloc.h"
 
+/* Stores an OP_number constant into its slot.  Used only for elements of
+   array arguments, since an operation may rearrange them; other constants
+   are stored in their slots once, when the expression is compiled. */
+static void
+exec_number (struct expression *e, const struct expr_insn *insn,
+             const struct ccase *const cases[] UNUSED, size_t n_cases,
+             size_t case_idx UNUSED)
+{
+  double *number_row = e->number_slots;
+  size_t k;
+
+  for (k = 0; k < n_cases; k++, number_row += e->n_number_slots)
+    number_row[insn->dst] = e->ops[insn->aux].number;
+}
+
+/* Stores an OP_string constant into its slot.  String operations do not
+   modify their arguments, so the slot can refer to the constant itself. */
+static void
+exec_string (struct expression *e, const struct expr_insn *insn,
+             const struct ccase *const cases[] UNUSED, size_t n_cases,
+             size_t case_idx UNUSED)
+{
+  struct substring *string_row = e->string_slots;
+  size_t k;
+
+  for (k = 0; k < n_cases; k++, string_row += e->n_string_slots)
+    string_row[insn->dst] = e->ops[insn->aux].string;
+}
+
+/* Copies the number in slot NS_ARGS into slot DST.  Used for an
+   occurrence of a subexpression whose value was already computed for an
+   earlier occurrence. */
+void
+expr_copy_number (struct expression *e, const struct expr_insn *insn,
+                  const struct ccase *const cases[] UNUSED, size_t n_cases,
+                  size_t case_idx UNUSED)
+{
+  double *number_row = e->number_slots;
+  size_t k;
+
+  for (k = 0; k < n_cases; k++, number_row += e->n_number_slots)
+    number_row[insn->dst] = number_row[insn->ns_args];
+}
+
+/* Copies the string in slot SS_ARGS into slot DST, in the same way as
+   expr_copy_number(). */
+void
+expr_copy_string (struct expression *e, const struct expr_insn *insn,
+                  const struct ccase *const cases[] UNUSED, size_t n_cases,
+                  size_t case_idx UNUSED)
+{
+  struct substring *string_row = e->string_slots;
+  size_t k;
+
+  for (k = 0; k < n_cases; k++, string_row += e->n_string_slots)
+    string_row[insn->dst] = string_row[insn->ss_args];
+}
+
+#include "evaluate.inc"
+
+/* Returns the function that carries out operation TYPE in a compiled
+   expression. */
+expr_insn_func *
+expr_get_insn_func (operation_type type)
+{
+  expr_insn_func *func;
+
+  switch (type)
+    {
+    case OP_number:
+    case OP_boolean:
+      return exec_number;
+
+    case OP_string:
+      return exec_string;
+
+    default:
+      func = lookup_insn_func (type);
+      assert (func != NULL);
+      return func;
+    }
+}
+
 static void
 expr_evaluate (struct expression *e, const struct ccase *c, int case_idx,
                void *result)
 {
-  struct dataset *ds = e->ds;
-  union operation_data *op = e->ops;
-
-  double *ns = e->number_stack;
-  struct substring *ss = e->string_stack;
+  const struct expr_insn *insn;
+  const struct expr_insn *end = &e->insns[e->n_insns];
 
   /* Without a dictionary/dataset, the expression can't refer to variables,
      and you don't need to specify a case when you evaluate the
@@ -46,38 +127,18 @@ expr_evaluate (struct expression *e, const struct ccase *c, int case_idx,
      expression. */
   assert ((c != NULL) == (e->ds != NULL));
 
-  pool_clear (e->eval_pool);
-
-  for (;;)
-    {
-      assert (op < e->ops + e->op_cnt);
-      switch (op++->operation)
-	{
-        case OP_number:
-        case OP_boolean:
-          *ns++ = op++->number;
-          break;
-
-        case OP_string:
-          {
-            const struct substring *s = &op++->string;
-            *ss++ = copy_string (e, s->string, s->length);
-          }
-          break;
+  reset_strings (e);
 
-        case OP_return_number:
-          *(double *) result = isfinite (ns[-1]) ? ns[-1] : SYSMIS;
-          return;
+  for (insn = e->insns; insn < end; insn++)
+    insn->func (e, insn, &c, 1, case_idx);
 
-        case OP_return_string:
-          *(struct substring *) result = ss[-1];
-          return;
-
-#include "evaluate.inc"
-
-	default:
-	  NOT_REACHED ();
-	}
+  /* The expression's value is in the first slot of its type. */
+  if (e->type == OP_string)
+    *(struct substring *) result = e->string_slots[0];
+  else
+    {
+      double d = e->number_slots[0];
+      *(double *) result = isfinite (d) ? d : SYSMIS;
     }
 }
 
@@ -104,6 +165,72 @@ expr_evaluate_str (struct expression *e, const struct ccase *c, int case_idx,
   buf_copy_rpad (dst, dst_size, s.string, s.length, ' ');
 }
 
+/* Returns true if E may be evaluated with expr_evaluate_num_batch(), that
+   is, if E is a numeric or Boolean expression whose value for a case does
+   not depend on the order in which cases are evaluated. */
+bool
+expr_is_batchable (const struct expression *e)
+{
+  return e->type != OP_string && !e->sequential;
+}
+
+/* Makes E's slots hold at least N_ROWS rows, copying row 0, which holds
+   E's constants, into any new rows. */
+static void
+allocate_rows (struct expression *e, size_t n_rows)
+{
+  size_t i;
+
+  if (n_rows <= e->n_rows)
+    return;
+
+  e->number_slots = pool_nrealloc (e->expr_pool, e->number_slots,
+                                   n_rows * e->n_number_slots,
+                                   sizeof *e->number_slots);
+  for (i = e->n_rows; i < n_rows; i++)
+    memcpy (&e->number_slots[i * e->n_number_slots], e->number_slots,
+            e->n_number_slots * sizeof *e->number_slots);
+
+  if (e->n_string_slots > 0)
+    e->string_slots = pool_nrealloc (e->expr_pool, e->string_slots,
+                                     n_rows * e->n_string_slots,
+                                     sizeof *e->string_slots);
+
+  e->n_rows = n_rows;
+}
+
+/* Evaluates numeric or Boolean expression E for each of the N cases in
+   CASES[], storing the value for CASES[i] into RESULTS[i].  The results are
+   the same as calling expr_evaluate_num() for each case in turn, but each
+   operation in E runs over all N cases before the next one starts, which
+   amortizes the cost of dispatching the operation and keeps its code and
+   data hot.  E must satisfy expr_is_batchable(). */
+void
+expr_evaluate_num_batch (struct expression *e, struct ccase *const cases[],
+                         size_t n, double results[])
+{
+  const struct expr_insn *insn;
+  const struct expr_insn *end = &e->insns[e->n_insns];
+  size_t k;
+
+  assert (expr_is_batchable (e));
+  assert (e->ds != NULL);
+  if (n == 0)
+    return;
+
+  allocate_rows (e, n);
+  reset_strings (e);
+
+  for (insn = e->insns; insn < end; insn++)
+    insn->func (e, insn, (const struct ccase *const *) cases, n, 0);
+
+  for (k = 0; k < n; k++)
+    {
+      double d = e->number_slots[k * e->n_number_slots];
+      results[k] = isfinite (d) ? d : SYSMIS;
+    }
+}
+
 #include "language/lexer/lexer.h"
 #include "language/command.h"
 
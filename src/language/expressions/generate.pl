@@ -181,8 +181,8 @@ sub init_all_types {
 #
 # Types with role "any" require:
 #
-#   STACK: Name of the local variable in expr_evaluate(), used for
-#   maintaining the stack for this type.
+#   STACK: Name of the local variable in the functions generated for
+#   evaluate.inc that points to the slots for arguments of this type.
 #
 #   MISSING_VALUE: Expression used for the missing value of this
 #   type.
@@ -375,6 +375,13 @@ sub parse_input {
 	    die "block or expression expected";
 	}
 
+	# An operation that depends on the position of the case in the active
+	# dataset, or that draws random numbers, must be evaluated one case at
+	# a time, in order.
+	$op{SEQUENTIAL} = (grep (any ($_->{TYPE}, @type{qw (CASE_IDX DATASET)}),
+				 @{$op{AUX} || []})
+			   || ($op{BLOCK} || $op{EXPRESSION} || '') =~ /\bget_rng\b/);
+
 	die "duplicate operation name $opname" if defined $ops{$opname};
 	$ops{$opname} = \%op;
 	if ($op{CATEGORY} eq 'function') {
@@ -617,18 +624,17 @@ sub generate_evaluate_h {
     }
 }
 
+# Generates one function per operation, each of which evaluates a single
+# instruction in a compiled expression (see struct expr_insn in private.h),
+# followed by lookup_insn_func(), which maps an operation to its function.
 sub generate_evaluate_inc {
     for my $opname (@order) {
 	my ($op) = $ops{$opname};
-
-	if ($op->{UNIMPLEMENTED}) {
-	    print "case $opname:\n";
-	    print "  NOT_REACHED ();\n\n";
-	    next;
-	}
+	next if $op->{UNIMPLEMENTED};
 
 	my (@decls);
 	my (@args);
+	my (%n_stack_args) = (ns => 0, ss => 0);
 	for my $arg (@{$op->{ARGS}}) {
 	    my ($name) = $arg->{NAME};
 	    my ($type) = $arg->{TYPE};
@@ -638,7 +644,9 @@ sub generate_evaluate_inc {
 	    if (!defined ($idx)) {
 		my ($decl) = "${c_type}arg_$name";
 		if ($type->{ROLE} eq 'any') {
-		    unshift (@decls, "$decl = *--$type->{STACK}");
+		    my ($stack) = $type->{STACK};
+		    push (@decls, "$decl = $stack\[$n_stack_args{$stack}]");
+		    $n_stack_args{$stack}++;
 		} elsif ($type->{ROLE} eq 'leaf') {
 		    push (@decls, "$decl = op++->$type->{ATOM}");
 		} else {
@@ -647,9 +655,10 @@ sub generate_evaluate_inc {
 	    } else {
 		my ($stack) = $type->{STACK};
 		defined $stack or die;
-		unshift (@decls,
-			 "$c_type*arg_$arg->{NAME} = $stack -= arg_$idx");
+		unshift (@decls, "$c_type*arg_$arg->{NAME} = "
+			 . "&$stack\[$n_stack_args{$stack}]");
 		unshift (@decls, "size_t arg_$arg->{IDX} = op++->integer");
+		$n_stack_args{$stack}++;
 
 		my ($idx) = "arg_$idx";
 		if ($arg->{TIMES} != 1) {
@@ -658,6 +667,8 @@ sub generate_evaluate_inc {
 		push (@args, $idx);
 	    }
 	}
+	my ($uses_ds) = 0;
+	my ($uses_c) = 0;
 	for my $aux (@{$op->{AUX}}) {
 	    my ($type) = $aux->{TYPE};
 	    my ($name) = $aux->{NAME};
@@ -667,32 +678,76 @@ sub generate_evaluate_inc {
 		push (@args, "aux_$name");
 	    } elsif ($type->{ROLE} eq 'fixed') {
 		push (@args, $type->{FIXED_VALUE});
+		$uses_ds = 1 if $type->{FIXED_VALUE} eq 'ds';
+		$uses_c = 1 if $type->{FIXED_VALUE} eq 'c';
 	    }
 	}
 
 	my ($sysmis_cond) = make_sysmis_decl ($op, "op++->integer");
 	push (@decls, $sysmis_cond) if defined $sysmis_cond;
 
-	my ($result) = "eval_$op->{OPNAME} (" . join (', ', @args) . ")";
-
-	my ($stack) = $op->{RETURNS}{STACK};
+	unshift (@decls, "struct dataset *ds = e->ds") if $uses_ds;
+	unshift (@decls, "const struct ccase *c = cases[k]") if $uses_c;
+	unshift (@decls, "struct substring *ss = "
+		 . "&string_row[insn->ss_args]") if $n_stack_args{ss};
+	unshift (@decls, "double *ns = "
+		 . "&number_row[insn->ns_args]") if $n_stack_args{ns};
+	unshift (@decls, "const union operation_data *op = "
+		 . "&e->ops[insn->aux]") if grep (/op\+\+/, @decls);
 
-	print "case $opname:\n";
-	if (@decls) {
-	    print "  {\n";
-	    print "    $_;\n" foreach @decls;
-	    if (defined $sysmis_cond) {
-		my ($miss_ret) = $op->{RETURNS}{MISSING_VALUE};
-		print "    *$stack++ = force_sysmis ? $miss_ret : $result;\n";
+	my ($result) = "eval_$op->{OPNAME} (" . join (', ', @args) . ")";
+	if (defined $sysmis_cond) {
+	    my ($miss_ret) = $op->{RETURNS}{MISSING_VALUE};
+	    $result = "force_sysmis ? $miss_ret : $result";
+	}
+	my ($dst_row) = ($op->{RETURNS}{STACK} eq 'ns'
+			 ? 'number_row' : 'string_row');
+	my (@rows) = ($dst_row);
+	push (@rows, 'number_row')
+	  if $n_stack_args{ns} && $dst_row ne 'number_row';
+	push (@rows, 'string_row')
+	  if $n_stack_args{ss} && $dst_row ne 'string_row';
+
+	print "static void\n";
+	print "exec_$opname (struct expression *e, const struct expr_insn *insn,\n";
+	print "    const struct ccase *const cases[] UNUSED, size_t n_cases,\n";
+	print "    size_t case_idx UNUSED)\n";
+	print "{\n";
+	for my $row (@rows) {
+	    if ($row eq 'number_row') {
+		print "  double *number_row = e->number_slots;\n";
 	    } else {
-		print "    *$stack++ = $result;\n";
+		print "  struct substring *string_row = e->string_slots;\n";
 	    }
-	    print "  }\n";
-	} else {
-	    print "  *$stack++ = $result;\n";
 	}
-	print "  break;\n\n";
+	print "  size_t k;\n\n";
+	print "  for (k = 0; k < n_cases; k++";
+	for my $row (@rows) {
+	    my ($n) = $row eq 'number_row' ? 'n_number_slots' : 'n_string_slots';
+	    print ",\n         $row += e->$n";
+	}
+	print ")\n";
+	print "    {\n";
+	print "      $_;\n" foreach @decls;
+	print "      ${dst_row}\[insn->dst] = $result;\n";
+	print "    }\n";
+	print "}\n\n";
+    }
+
+    print "static expr_insn_func *\n";
+    print "lookup_insn_func (operation_type type)\n";
+    print "{\n";
+    print "  switch (type)\n";
+    print "    {\n";
+    for my $opname (@order) {
+	next if $ops{$opname}->{UNIMPLEMENTED};
+	print "    case $opname:\n";
+	print "      return exec_$opname;\n";
     }
+    print "    default:\n";
+    print "      return NULL;\n";
+    print "    }\n";
+    print "}\n";
 }
 
 sub generate_operations_h {
@@ -888,6 +943,7 @@ sub generate_parse_inc {
 	push (@flags, "OPF_UNIMPLEMENTED") if $op->{UNIMPLEMENTED};
 	push (@flags, "OPF_PERM_ONLY") if $op->{PERM_ONLY};
 	push (@flags, "OPF_NO_ABBREV") if $op->{NO_ABBREV};
+	push (@flags, "OPF_SEQUENTIAL") if $op->{SEQUENTIAL};
 	push (@members, @flags ? join (' | ', @flags) : 0);
 
 	push (@members, "OP_$op->{RETURNS}{NAME}");
@@ -439,15 +439,60 @@ count_valid (double *d, size_t d_cnt)
   return valid_cnt;
 }
 
+/* Returns a string LENGTH bytes long, whose contents are undefined, that
+   lasts until the next evaluation of E. */
 struct substring
 alloc_string (struct expression *e, size_t length)
 {
   struct substring s;
+
   s.length = length;
-  s.string = pool_alloc (e->eval_pool, length);
+  if (length <= e->eval_arena_size - e->eval_arena_used)
+    {
+      s.string = e->eval_arena + e->eval_arena_used;
+      e->eval_arena_used += length;
+    }
+  else
+    {
+      s.string = pool_alloc_unaligned (e->eval_pool, length);
+      e->eval_overflow += length;
+    }
   return s;
 }
 
+/* Shortens S, which must be the string most recently returned by
+   alloc_string() for E, to LENGTH bytes, and makes the bytes beyond that
+   available to later calls to alloc_string(). */
+void
+trim_string (struct expression *e, struct substring *s, size_t length)
+{
+  assert (length <= s->length);
+  if (s->string + s->length == e->eval_arena + e->eval_arena_used)
+    e->eval_arena_used -= s->length - length;
+  s->length = length;
+}
+
+/* Frees the strings allocated while evaluating E, in preparation for
+   evaluating E again.  If the strings did not all fit in E's arena, enlarges
+   it so that they will next time. */
+void
+reset_strings (struct expression *e)
+{
+  if (e->eval_overflow > 0)
+    {
+      size_t size = e->eval_arena_used + e->eval_overflow;
+      if (size < 2 * e->eval_arena_size)
+        size = 2 * e->eval_arena_size;
+
+      pool_free (e->expr_pool, e->eval_arena);
+      e->eval_arena = pool_malloc (e->expr_pool, size);
+      e->eval_arena_size = size;
+      e->eval_overflow = 0;
+    }
+  e->eval_arena_used = 0;
+  pool_clear (e->eval_pool);
+}
+
 struct substring
 copy_string (struct expression *e, const char *old, size_t length)
 {
@@ -702,15 +747,15 @@ replace_string (struct expression *e,
     return haystack;
 
   struct substring result = alloc_string (e, MAX_STRING);
-  result.length = 0;
+  size_t result_len = 0;
 
   size_t i = 0;
   while (i <= haystack.length - needle.length)
     if (!memcmp (&haystack.string[i], needle.string, needle.length))
       {
-        size_t copy_len = MIN (replacement.length, MAX_STRING - result.length);
-        memcpy (&result.string[result.length], replacement.string, copy_len);
-        result.length += copy_len;
+        size_t copy_len = MIN (replacement.length, MAX_STRING - result_len);
+        memcpy (&result.string[result_len], replacement.string, copy_len);
+        result_len += copy_len;
         i += needle.length;
 
         if (--n < 1)
@@ -718,13 +763,14 @@ replace_string (struct expression *e,
       }
     else
       {
-        if (result.length < MAX_STRING)
-          result.string[result.length++] = haystack.string[i];
+        if (result_len < MAX_STRING)
+          result.string[result_len++] = haystack.string[i];
         i++;
       }
-  while (i < haystack.length && result.length < MAX_STRING)
-    result.string[result.length++] = haystack.string[i++];
+  while (i < haystack.length && result_len < MAX_STRING)
+    result.string[result_len++] = haystack.string[i++];
 
+  trim_string (e, &result, result_len);
   return result;
 }
 
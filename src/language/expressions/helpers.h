@@ -64,6 +64,8 @@ double expr_date_sum (double date, double quantity, struct substring unit_name,
 struct substring alloc_string (struct expression *, size_t length);
 struct substring copy_string (struct expression *,
                               const char *, size_t length);
+void trim_string (struct expression *, struct substring *, size_t length);
+void reset_strings (struct expression *);
 
 static inline bool
 is_valid (double d)
@@ -22,6 +22,7 @@
 #include <ctype.h>
 #include <errno.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "data/calendar.h"
 #include "data/data-in.h"
@@ -30,6 +31,8 @@
 #include "language/expressions/helpers.h"
 #include "language/expressions/public.h"
 #include "libpspp/assertion.h"
+#include "libpspp/hash-functions.h"
+#include "libpspp/hmap.h"
 #include "libpspp/message.h"
 #include "libpspp/misc.h"
 #include "libpspp/pool.h"
@@ -217,11 +220,36 @@ get_format_arg (struct composite_node *c, size_t arg_idx)
   return &c->args[arg_idx]->format.f;
 }
 
-/* Expression flattening. */
+/* Expression flattening.
+
+   Flattening produces two equivalent linear forms of an expression's tree.
+   The postfix form in ops[] holds each operation followed by its auxiliary
+   data (variables, formats, and so on).  expr_debug_print_postfix() prints
+   it.  The compiled form in insns[] is what expr_evaluate() executes.  Each
+   instruction calls a function for its operation directly.  It reads the
+   auxiliary data from ops[] and its arguments from value slots (see struct
+   expr_insn).
+
+   The compiled form evaluates each distinct subexpression only
+   once.  When a subexpression occurs again, e.g. "(x - m) / s" in
+   "((x - m) / s) ** 2 + (x - m) / s", the later occurrence copies the value
+   from the slot of the first instead of computing it again.  The postfix
+   form still spells out every occurrence. */
+
+/* A subexpression whose value is in a slot, for reuse by later occurrences
+   of the same subexpression. */
+struct subexpr
+  {
+    struct hmap_node hmap_node; /* In the table passed to flatten_node(). */
+    const union any_node *node; /* The subexpression. */
+    size_t slot;                /* Slot that holds its value. */
+  };
 
 static union operation_data *allocate_aux (struct expression *,
                                                 operation_type);
-static void flatten_node (union any_node *, struct expression *);
+static void flatten_node (union any_node *, struct expression *,
+                          struct hmap *subexprs, size_t dst, bool in_array);
+static void flatten_postfix (const union any_node *, struct expression *);
 
 static void
 emit_operation (struct expression *e, operation_type type)
@@ -266,28 +294,246 @@ emit_integer (struct expression *e, int i)
   allocate_aux (e, OP_integer)->integer = i;
 }
 
+/* Appends to E an instruction that calls FUNC, taking its auxiliary data
+   from ops[AUX] onward, its numeric and string arguments from the slots
+   starting at NS_ARGS and SS_ARGS, respectively, and storing its result in
+   slot DST. */
+static void
+append_insn (struct expression *e, expr_insn_func *func, size_t aux,
+             size_t dst, size_t ns_args, size_t ss_args)
+{
+  struct expr_insn *insn;
+
+  if (e->n_insns >= e->allocated_insns)
+    {
+      e->allocated_insns = (e->allocated_insns + 8) * 3 / 2;
+      e->insns = pool_realloc (e->expr_pool, e->insns,
+                               sizeof *e->insns * e->allocated_insns);
+    }
+
+  insn = &e->insns[e->n_insns++];
+  insn->func = func;
+  insn->aux = aux;
+  insn->dst = dst;
+  insn->ns_args = ns_args;
+  insn->ss_args = ss_args;
+}
+
+/* Appends to E an instruction that carries out operation TYPE, with
+   arguments as described for append_insn(). */
+static void
+emit_insn (struct expression *e, operation_type type, size_t aux,
+           size_t dst, size_t ns_args, size_t ss_args)
+{
+  append_insn (e, expr_get_insn_func (type), aux, dst, ns_args, ss_args);
+}
+
+/* Allocates N consecutive slots in E for values of the given TYPE, which must
+   be OP_number, OP_boolean, or OP_string, and returns the index of the
+   first one. */
+static size_t
+allocate_slots (struct expression *e, atom_type type, size_t n)
+{
+  size_t first;
+
+  if (type == OP_string)
+    {
+      first = e->n_string_slots;
+      e->n_string_slots += n;
+      if (e->n_string_slots > e->allocated_string_slots)
+        {
+          e->allocated_string_slots = e->n_string_slots * 2;
+          e->string_slots = pool_realloc (
+            e->expr_pool, e->string_slots,
+            sizeof *e->string_slots * e->allocated_string_slots);
+        }
+    }
+  else
+    {
+      assert (type == OP_number || type == OP_boolean);
+      first = e->n_number_slots;
+      e->n_number_slots += n;
+      if (e->n_number_slots > e->allocated_number_slots)
+        {
+          e->allocated_number_slots = e->n_number_slots * 2;
+          e->number_slots = pool_realloc (
+            e->expr_pool, e->number_slots,
+            sizeof *e->number_slots * e->allocated_number_slots);
+        }
+    }
+  return first;
+}
+
+/* Returns a hash value for the subexpression rooted at N. */
+static unsigned int
+hash_node (const union any_node *n)
+{
+  unsigned int hash = hash_int (n->type, 0);
+  size_t i;
+
+  switch (n->type)
+    {
+    case OP_number:
+    case OP_boolean:
+      return hash_double (n->number.n, hash);
+
+    case OP_string:
+      return hash_bytes (n->string.s.string, n->string.s.length, hash);
+
+    case OP_num_var:
+    case OP_str_var:
+      return hash_pointer (n->variable.v, hash);
+
+    case OP_vector:
+      return hash_pointer (n->vector.v, hash);
+
+    case OP_no_format:
+    case OP_ni_format:
+      hash = hash_int (n->format.f.type, hash);
+      return hash_int (n->format.f.w, hash_int (n->format.f.d, hash));
+
+    case OP_pos_int:
+      return hash_int (n->integer.i, hash);
+
+    default:
+      assert (is_composite (n->type));
+      hash = hash_int (n->composite.min_valid, hash);
+      for (i = 0; i < n->composite.arg_cnt; i++)
+        hash = hash_int (hash_node (n->composite.args[i]), hash);
+      return hash;
+    }
+}
+
+/* Returns true if the subexpressions rooted at A and B are the same. */
+static bool
+nodes_equal (const union any_node *a, const union any_node *b)
+{
+  size_t i;
+
+  if (a->type != b->type)
+    return false;
+
+  switch (a->type)
+    {
+    case OP_number:
+    case OP_boolean:
+      /* Compare representations, to distinguish 0 from -0. */
+      return !memcmp (&a->number.n, &b->number.n, sizeof a->number.n);
+
+    case OP_string:
+      return ss_equals (a->string.s, b->string.s);
+
+    case OP_num_var:
+    case OP_str_var:
+      return a->variable.v == b->variable.v;
+
+    case OP_vector:
+      return a->vector.v == b->vector.v;
+
+    case OP_no_format:
+    case OP_ni_format:
+      return fmt_equal (&a->format.f, &b->format.f);
+
+    case OP_pos_int:
+      return a->integer.i == b->integer.i;
+
+    default:
+      assert (is_composite (a->type));
+      if (a->composite.arg_cnt != b->composite.arg_cnt
+          || a->composite.min_valid != b->composite.min_valid)
+        return false;
+      for (i = 0; i < a->composite.arg_cnt; i++)
+        if (!nodes_equal (a->composite.args[i], b->composite.args[i]))
+          return false;
+      return true;
+    }
+}
+
+/* Returns true if N has the same value everywhere it occurs in an
+   expression for a given case, so that the value of its first occurrence
+   may be reused for the others. */
+static bool
+is_pure (const union any_node *n)
+{
+  size_t i;
+
+  if (!is_composite (n->type))
+    return true;
+  if (operations[n->type].flags & OPF_SEQUENTIAL)
+    return false;
+  for (i = 0; i < n->composite.arg_cnt; i++)
+    if (!is_pure (n->composite.args[i]))
+      return false;
+  return true;
+}
+
+/* Returns true if it is worth reusing the value of composite node N when N
+   occurs more than once in an expression, that is, if computing N involves
+   computing other subexpressions and N is pure. */
+static bool
+is_reusable (const union any_node *n)
+{
+  size_t i;
+
+  for (i = 0; i < n->composite.arg_cnt; i++)
+    if (is_composite (n->composite.args[i]->type))
+      return is_pure (n);
+  return false;
+}
+
+/* Returns the earlier occurrence of N, with hash value HASH, in SUBEXPRS,
+   or a null pointer if there is none. */
+static const struct subexpr *
+find_subexpr (const struct hmap *subexprs, const union any_node *n,
+              unsigned int hash)
+{
+  const struct subexpr *s;
+
+  HMAP_FOR_EACH_WITH_HASH (s, struct subexpr, hmap_node, hash, subexprs)
+    if (nodes_equal (s->node, n))
+      return s;
+  return NULL;
+}
+
 void
 expr_flatten (union any_node *n, struct expression *e)
 {
-  flatten_node (n, e);
+  struct subexpr *s, *next;
+  struct hmap subexprs;
+
+  hmap_init (&subexprs);
   e->type = expr_node_returns (n);
+  flatten_node (n, e, &subexprs, allocate_slots (e, e->type, 1), false);
   emit_operation (e, (e->type == OP_string
                       ? OP_return_string : OP_return_number));
+
+  HMAP_FOR_EACH_SAFE (s, next, struct subexpr, hmap_node, &subexprs)
+    free (s);
+  hmap_destroy (&subexprs);
 }
 
+/* Flattens atom N into E, with slot DST for its value.  IN_ARRAY is true if
+   N is an element of an array argument, whose elements an operation may
+   rearrange. */
 static void
-flatten_atom (union any_node *n, struct expression *e)
+flatten_atom (union any_node *n, struct expression *e,
+              size_t dst, bool in_array)
 {
   switch (n->type)
     {
     case OP_number:
     case OP_boolean:
       emit_operation (e, OP_number);
+      if (in_array)
+        emit_insn (e, OP_number, e->op_cnt, dst, 0, 0);
+      else
+        e->number_slots[dst] = n->number.n;
       emit_number (e, n->number.n);
       break;
 
     case OP_string:
       emit_operation (e, OP_string);
+      emit_insn (e, OP_string, e->op_cnt, dst, 0, 0);
       emit_string (e, n->string.s);
       break;
 
@@ -306,21 +552,17 @@ flatten_atom (union any_node *n, struct expression *e)
     }
 }
 
+/* Appends to E's postfix form the auxiliary data for composite node N,
+   which follows the operation itself. */
 static void
-flatten_composite (union any_node *n, struct expression *e)
+emit_composite_aux (const union any_node *n, struct expression *e)
 {
   const struct operation *op = &operations[n->type];
   size_t i;
 
-  for (i = 0; i < n->composite.arg_cnt; i++)
-    flatten_node (n->composite.args[i], e);
-
-  if (n->type != OP_BOOLEAN_TO_NUM)
-    emit_operation (e, n->type);
-
   for (i = 0; i < n->composite.arg_cnt; i++)
     {
-      union any_node *arg = n->composite.args[i];
+      const union any_node *arg = n->composite.args[i];
       switch (arg->type)
         {
         case OP_num_var:
@@ -353,19 +595,149 @@ flatten_composite (union any_node *n, struct expression *e)
     emit_integer (e, n->composite.min_valid);
 }
 
-void
-flatten_node (union any_node *n, struct expression *e)
+/* Flattens composite node N into E, with slot DST for its value.  IN_ARRAY
+   is true if N is an element of an array argument.  SUBEXPRS holds the
+   reusable subexpressions flattened so far. */
+static void
+flatten_composite (union any_node *n, struct expression *e,
+                   struct hmap *subexprs, size_t dst, bool in_array)
+{
+  const struct operation *op = &operations[n->type];
+  size_t ns_args, ss_args;
+  size_t n_ns_args, n_ss_args;
+  unsigned int hash = 0;
+  bool reusable;
+  size_t aux;
+  size_t i;
+
+  if (n->type == OP_BOOLEAN_TO_NUM)
+    {
+      /* A Boolean is already a number, so the conversion is a no-op. */
+      flatten_node (n->composite.args[0], e, subexprs, dst, in_array);
+      return;
+    }
+
+  reusable = is_reusable (n);
+  if (reusable)
+    {
+      const struct subexpr *s;
+
+      hash = hash_node (n);
+      s = find_subexpr (subexprs, n, hash);
+      if (s != NULL)
+        {
+          flatten_postfix (n, e);
+          if (expr_node_returns (n) == OP_string)
+            append_insn (e, expr_copy_string, 0, dst, 0, s->slot);
+          else
+            append_insn (e, expr_copy_number, 0, dst, s->slot, 0);
+          return;
+        }
+    }
+
+  /* Allocate consecutive slots for the arguments of each type before
+     flattening any of them, since the arguments' own arguments need slots
+     too. */
+  n_ns_args = n_ss_args = 0;
+  for (i = 0; i < n->composite.arg_cnt; i++)
+    {
+      atom_type type = expr_node_returns (n->composite.args[i]);
+      if (type == OP_number || type == OP_boolean)
+        n_ns_args++;
+      else if (type == OP_string)
+        n_ss_args++;
+    }
+  ns_args = allocate_slots (e, OP_number, n_ns_args);
+  ss_args = allocate_slots (e, OP_string, n_ss_args);
+
+  n_ns_args = n_ss_args = 0;
+  for (i = 0; i < n->composite.arg_cnt; i++)
+    {
+      union any_node *arg = n->composite.args[i];
+      atom_type type = expr_node_returns (arg);
+      bool arg_in_array = ((op->flags & OPF_ARRAY_OPERAND)
+                           && i >= op->arg_cnt - 1);
+
+      if (type == OP_number || type == OP_boolean)
+        flatten_node (arg, e, subexprs, ns_args + n_ns_args++, arg_in_array);
+      else if (type == OP_string)
+        flatten_node (arg, e, subexprs, ss_args + n_ss_args++, arg_in_array);
+      else
+        flatten_node (arg, e, subexprs, 0, false);
+    }
+
+  emit_operation (e, n->type);
+  aux = e->op_cnt;
+  emit_composite_aux (n, e);
+
+  if (op->flags & OPF_SEQUENTIAL)
+    e->sequential = true;
+  emit_insn (e, n->type, aux, dst, ns_args, ss_args);
+
+  /* An operation may rearrange the elements of an array argument, so only
+     a value outside an array may be reused. */
+  if (reusable && !in_array)
+    {
+      struct subexpr *s = xmalloc (sizeof *s);
+      s->node = n;
+      s->slot = dst;
+      hmap_insert (subexprs, &s->hmap_node, hash);
+    }
+}
+
+/* Flattens node N into E, with slot DST for its value.  IN_ARRAY is true if
+   N is an element of an array argument.  SUBEXPRS holds the reusable
+   subexpressions flattened so far. */
+static void
+flatten_node (union any_node *n, struct expression *e,
+              struct hmap *subexprs, size_t dst, bool in_array)
 {
   assert (is_operation (n->type));
 
   if (is_atom (n->type))
-    flatten_atom (n, e);
+    flatten_atom (n, e, dst, in_array);
   else if (is_composite (n->type))
-    flatten_composite (n, e);
+    flatten_composite (n, e, subexprs, dst, in_array);
   else
     NOT_REACHED ();
 }
 
+/* Appends N to E's postfix form only, for an occurrence of a subexpression
+   whose value the compiled form reuses. */
+static void
+flatten_postfix (const union any_node *n, struct expression *e)
+{
+  size_t i;
+
+  switch (n->type)
+    {
+    case OP_number:
+    case OP_boolean:
+      emit_operation (e, OP_number);
+      emit_number (e, n->number.n);
+      break;
+
+    case OP_string:
+      emit_operation (e, OP_string);
+      emit_string (e, n->string.s);
+      break;
+
+    case OP_BOOLEAN_TO_NUM:
+      flatten_postfix (n->composite.args[0], e);
+      break;
+
+    default:
+      if (is_composite (n->type))
+        {
+          for (i = 0; i < n->composite.arg_cnt; i++)
+            flatten_postfix (n->composite.args[i], e);
+          emit_operation (e, n->type);
+          emit_composite_aux (n, e);
+        }
+      break;
+    }
+}
+
 static union operation_data *
 allocate_aux (struct expression *e, operation_type type)
 {
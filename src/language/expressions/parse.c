@@ -135,110 +135,18 @@ expr_parse_any (struct lexer *lexer, struct dataset *ds, bool optimize)
 
 /* Finishing up expression building. */
 
-/* Height of an expression's stacks. */
-struct stack_heights
-  {
-    int number_height;  /* Height of number stack. */
-    int string_height;  /* Height of string stack. */
-  };
-
-/* Stack heights used by different kinds of arguments. */
-static const struct stack_heights on_number_stack = {1, 0};
-static const struct stack_heights on_string_stack = {0, 1};
-static const struct stack_heights not_on_stack = {0, 0};
-
-/* Returns the stack heights used by an atom of the given
-   TYPE. */
-static const struct stack_heights *
-atom_type_stack (atom_type type)
-{
-  assert (is_atom (type));
-
-  switch (type)
-    {
-    case OP_number:
-    case OP_boolean:
-      return &on_number_stack;
-
-    case OP_string:
-      return &on_string_stack;
-
-    case OP_format:
-    case OP_ni_format:
-    case OP_no_format:
-    case OP_num_var:
-    case OP_str_var:
-    case OP_integer:
-    case OP_pos_int:
-    case OP_vector:
-      return &not_on_stack;
-
-    default:
-      NOT_REACHED ();
-    }
-}
-
-/* Measures the stack height needed for node N, supposing that
-   the stack height is initially *HEIGHT and updating *HEIGHT to
-   the final stack height.  Updates *MAX, if necessary, to
-   reflect the maximum intermediate or final height. */
-static void
-measure_stack (const union any_node *n,
-               struct stack_heights *height, struct stack_heights *max)
-{
-  const struct stack_heights *return_height;
-
-  if (is_composite (n->type))
-    {
-      struct stack_heights args;
-      int i;
-
-      args = *height;
-      for (i = 0; i < n->composite.arg_cnt; i++)
-        measure_stack (n->composite.args[i], &args, max);
-
-      return_height = atom_type_stack (operations[n->type].returns);
-    }
-  else
-    return_height = atom_type_stack (n->type);
-
-  height->number_height += return_height->number_height;
-  height->string_height += return_height->string_height;
-
-  if (height->number_height > max->number_height)
-    max->number_height = height->number_height;
-  if (height->string_height > max->string_height)
-    max->string_height = height->string_height;
-}
-
-/* Allocates stacks within E sufficient for evaluating node N. */
-static void
-allocate_stacks (union any_node *n, struct expression *e)
-{
-  struct stack_heights initial = {0, 0};
-  struct stack_heights max = {0, 0};
-
-  measure_stack (n, &initial, &max);
-  e->number_stack = pool_alloc (e->expr_pool,
-                                sizeof *e->number_stack * max.number_height);
-  e->string_stack = pool_alloc (e->expr_pool,
-                                sizeof *e->string_stack * max.string_height);
-}
-
 /* Finalizes expression E for evaluating node N. */
 static struct expression *
 finish_expression (union any_node *n, struct expression *e)
 {
-  /* Allocate stacks. */
-  allocate_stacks (n, e);
-
-  /* Output postfix representation. */
+  /* Output postfix representation and compile. */
   expr_flatten (n, e);
 
   /* The eval_pool might have been used for allocating strings
      during optimization.  We need to keep those strings around
      for all subsequent evaluations, so start a new eval_pool. */
   e->eval_pool = pool_create_subpool (e->expr_pool);
+  e->eval_overflow = 0;
 
   return e;
 }
@@ -1340,6 +1248,17 @@ expr_create (struct dataset *ds)
   e->ops = NULL;
   e->op_types = NULL;
   e->op_cnt = e->op_cap = 0;
+  e->insns = NULL;
+  e->n_insns = e->allocated_insns = 0;
+  e->number_slots = NULL;
+  e->n_number_slots = e->allocated_number_slots = 0;
+  e->string_slots = NULL;
+  e->n_string_slots = e->allocated_string_slots = 0;
+  e->n_rows = 1;
+  e->sequential = false;
+  e->eval_arena = NULL;
+  e->eval_arena_used = e->eval_arena_size = 0;
+  e->eval_overflow = 0;
   return e;
 }
 
@@ -62,7 +62,13 @@ enum operation_flags
     OPF_PERM_ONLY = 0100,
 
     /* If set, this operation's name may not be abbreviated. */
-    OPF_NO_ABBREV = 0200
+    OPF_NO_ABBREV = 0200,
+
+    /* If set, this operation must be evaluated one case at a time, in
+       order, because it depends on the position of the case in the active
+       dataset or draws random numbers.  (This applies to LAG, $CASENUM,
+       and the random variate functions.) */
+    OPF_SEQUENTIAL = 0400
   };
 
 #define EXPR_ARG_MAX 4
@@ -152,6 +158,43 @@ union operation_data
     int integer;
   };
 
+struct ccase;
+struct expr_insn;
+
+/* Carries out INSN, one instruction in compiled expression E, for each of
+   the N_CASES cases in CASES[], using the row of slots for each case in
+   turn.  CASE_IDX is the index of the case, which is meaningful only when
+   N_CASES is 1, since expressions that contain an OPF_SEQUENTIAL operation
+   are never evaluated in batches. */
+typedef void expr_insn_func (struct expression *e, const struct expr_insn *insn,
+                             const struct ccase *const cases[], size_t n_cases,
+                             size_t case_idx);
+
+/* One instruction in a compiled expression.
+
+   Each node in an expression's tree that yields a number, Boolean, or string
+   has its own slot in the expression's number_slots[] or string_slots[].
+   An instruction reads its arguments from slots written by earlier
+   instructions and writes its result to its own slot.  The arguments of a
+   given type are always in consecutive slots, so that an operation on an
+   array of arguments can use them in place.  Constants that are not array
+   elements are stored in their slots when the expression is compiled, so
+   that they cost nothing to evaluate.
+
+   To evaluate the expression for a batch of cases, the slots are extended
+   to one row per case, each row holding n_number_slots numbers and
+   n_string_slots strings, so that each instruction can run over the whole
+   batch before the next one starts.  Row 0 holds the constants; other rows
+   are copied from it when they are allocated. */
+struct expr_insn
+  {
+    expr_insn_func *func;       /* Carries out the instruction. */
+    size_t aux;                 /* Index in ops[] of auxiliary data. */
+    size_t dst;                 /* Slot for the result. */
+    size_t ns_args;             /* Slot of first numeric argument. */
+    size_t ss_args;             /* Slot of first string argument. */
+  };
+
 /* An expression. */
 struct expression
   {
@@ -163,8 +206,26 @@ struct expression
     operation_type *op_types;   /* ops[] element types (for debugging). */
     size_t op_cnt, op_cap;      /* Number of ops, amount of allocated space. */
 
-    double *number_stack;       /* Evaluation stack: numerics, Booleans. */
-    struct substring *string_stack; /* Evaluation stack: strings. */
+    struct expr_insn *insns;    /* Compiled form of the expression. */
+    size_t n_insns, allocated_insns;
+
+    double *number_slots;       /* Values of numeric and Boolean nodes. */
+    size_t n_number_slots, allocated_number_slots;
+    struct substring *string_slots; /* Values of string nodes. */
+    size_t n_string_slots, allocated_string_slots;
+    size_t n_rows;              /* Number of rows of slots. */
+    bool sequential;            /* Contains an OPF_SEQUENTIAL operation? */
+
+    /* Strings computed during evaluation.  String values are never
+       modified in place, so most operations that yield a string refer to
+       their argument or to the case instead of copying.  The others
+       allocate from eval_arena, which is emptied before each evaluation.
+       Strings that do not fit go into eval_pool, and then the arena is
+       enlarged before the next evaluation, so that once the arena is big
+       enough, evaluating the expression allocates no memory. */
+    char *eval_arena;           /* Memory for strings. */
+    size_t eval_arena_used, eval_arena_size;
+    size_t eval_overflow;       /* Bytes allocated from eval_pool. */
     struct pool *eval_pool;     /* Pool for evaluation temporaries. */
   };
 
@@ -173,6 +234,9 @@ void expr_debug_print_postfix (const struct expression *);
 
 union any_node *expr_optimize (union any_node *, struct expression *);
 void expr_flatten (union any_node *, struct expression *);
+expr_insn_func *expr_get_insn_func (operation_type);
+expr_insn_func expr_copy_number;
+expr_insn_func expr_copy_string;
 
 atom_type expr_node_returns (const union any_node *);
 
@@ -17,6 +17,7 @@
 #if !expr_h
 #define expr_h 1
 
+#include <stdbool.h>
 #include <stddef.h>
 
 /* Expression parsing flags. */
@@ -48,6 +49,10 @@ double expr_evaluate_num (struct expression *, const struct ccase *,
 void expr_evaluate_str (struct expression *, const struct ccase *,
                         int case_idx, char *dst, size_t dst_size);
 
+bool expr_is_batchable (const struct expression *);
+void expr_evaluate_num_batch (struct expression *, struct ccase *const cases[],
+                              size_t n, double results[]);
+
 const struct operation *expr_get_function (size_t idx);
 size_t expr_get_function_cnt (void);
 const char *expr_operation_get_name (const struct operation *);
@@ -20,10 +20,12 @@
 
 #include <assert.h>
 #include <limits.h>
+#include <stdlib.h>
 
 #include "data/identifier.h"
 
 #include "gl/c-ctype.h"
+#include "gl/xalloc.h"
 
 /* Stores the first word in S into WORD and advances S past that word.  Returns
    true if successful, false if no word remained in S to be extracted.
@@ -233,3 +235,127 @@ command_matcher_get_missing_words (const struct command_matcher *cm)
           : cm->exact_match != NULL ? 0
           : cm->match_missing_words);
 }
+
+/* Returns the key for the first word of S, which is the first 3 bytes of the
+   word (or the whole word, if it is shorter) in uppercase.
+
+   Under the matching rules in lex_id_match(), a word can only match a
+   keyword with the same key: a word of 3 or more bytes must match that many
+   bytes of the keyword, and a shorter word must match all of it.  Thus,
+   command_match() can only succeed for a command whose key is the same as
+   the string's. */
+static unsigned int
+command_key (struct substring s)
+{
+  struct substring word;
+  unsigned int key;
+  size_t i;
+
+  find_word (&s, &word);
+  key = 0;
+  for (i = 0; i < 3; i++)
+    key = (key << CHAR_BIT) | (i < word.length
+                               ? (unsigned char) c_toupper (word.string[i])
+                               : 0);
+  return key;
+}
+
+struct command_index_entry
+  {
+    unsigned int key;
+    size_t index;
+  };
+
+static int
+compare_command_index_entries (const void *a_, const void *b_)
+{
+  const struct command_index_entry *a = a_;
+  const struct command_index_entry *b = b_;
+
+  return (a->key != b->key ? (a->key > b->key ? 1 : -1)
+          : a->index != b->index ? (a->index > b->index ? 1 : -1)
+          : 0);
+}
+
+/* Initializes CI as an index for the N command NAMES, which must be ASCII
+   strings. */
+void
+command_index_init (struct command_index *ci,
+                    const char *const *names, size_t n)
+{
+  struct command_index_entry *entries;
+  size_t i;
+
+  entries = xnmalloc (n, sizeof *entries);
+  for (i = 0; i < n; i++)
+    {
+      entries[i].key = command_key (ss_cstr (names[i]));
+      entries[i].index = i;
+    }
+  qsort (entries, n, sizeof *entries, compare_command_index_entries);
+
+  ci->n = n;
+  ci->keys = xnmalloc (n, sizeof *ci->keys);
+  ci->indexes = xnmalloc (n, sizeof *ci->indexes);
+  for (i = 0; i < n; i++)
+    {
+      ci->keys[i] = entries[i].key;
+      ci->indexes[i] = entries[i].index;
+    }
+  free (entries);
+}
+
+/* Frees the storage associated with CI. */
+void
+command_index_destroy (struct command_index *ci)
+{
+  free (ci->keys);
+  free (ci->indexes);
+}
+
+/* Finds the names in CI that STRING could match with command_match().
+   Stores into *INDEXES a pointer to an array of the indexes of those names
+   and returns the number of names.  All the other names in CI are certain not
+   to match STRING.
+
+   STRING may be ASCII or UTF-8. */
+size_t
+command_index_lookup (const struct command_index *ci,
+                      struct substring string, const size_t **indexes)
+{
+  unsigned int key = command_key (string);
+  size_t low, high, start;
+
+  if (key == 0)
+    {
+      /* No words at all, so every name matches. */
+      *indexes = ci->indexes;
+      return ci->n;
+    }
+
+  /* Find the first entry with KEY, then the first entry beyond it. */
+  low = 0;
+  high = ci->n;
+  while (low < high)
+    {
+      size_t mid = low + (high - low) / 2;
+      if (ci->keys[mid] < key)
+        low = mid + 1;
+      else
+        high = mid;
+    }
+  start = low;
+
+  high = ci->n;
+  while (low < high)
+    {
+      size_t mid = low + (high - low) / 2;
+      if (ci->keys[mid] <= key)
+        low = mid + 1;
+      else
+        high = mid;
+    }
+
+  *indexes = &ci->indexes[start];
+  return low - start;
+}
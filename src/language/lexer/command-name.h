@@ -43,4 +43,20 @@ void command_matcher_add (struct command_matcher *, struct substring command,
 void *command_matcher_get_match (const struct command_matcher *);
 int command_matcher_get_missing_words (const struct command_matcher *);
 
+/* An index into a table of command names, for finding the names that a
+   string might match without trying every name in the table. */
+struct command_index
+  {
+    size_t n;                   /* Number of names. */
+    unsigned int *keys;         /* Sorted keys of the names. */
+    size_t *indexes;            /* Table index of name with each key. */
+  };
+
+void command_index_init (struct command_index *,
+                         const char *const *names, size_t n);
+void command_index_destroy (struct command_index *);
+
+size_t command_index_lookup (const struct command_index *,
+                             struct substring string, const size_t **indexes);
+
 #endif /* command-name.h */
@@ -55,6 +55,9 @@
 #define _(msgid) gettext (msgid)
 #define N_(msgid) msgid
 
+/* Minimum number of bytes to request from a lex_reader at a time. */
+#define LEX_READ_SIZE 65536
+
 /* A token within a lex_source. */
 struct lex_token
   {
@@ -113,7 +116,10 @@ static const struct lex_token *lex_next__ (const struct lexer *, int n);
 static void lex_source_push_endcmd__ (struct lex_source *);
 
 static void lex_source_pop__ (struct lex_source *);
+static void lex_source_journal__ (struct lex_source *, int n_newlines,
+                                 enum segment_type last_segment);
 static bool lex_source_get__ (const struct lex_source *);
+static void lex_source_read__ (struct lex_source *);
 static void lex_source_error_valist (struct lex_source *, int n0, int n1,
                                      const char *format, va_list)
    PRINTF_FORMAT (4, 0);
@@ -234,6 +240,94 @@ lex_get (struct lexer *lexer)
       }
 }
 
+/* Advances LEXER to the next token, like lex_get(), while LEXER is reading
+   the inline data between BEGIN DATA and END DATA.  If the new token is a
+   line of inline data, stores the line into *LINE and returns true;
+   otherwise, returns false.
+
+   This is equivalent to calling lex_get() followed by lex_is_string() and
+   lex_tokss(), but when the current token is itself a line of inline data
+   and there is no lookahead, it is much faster: it extracts the next line
+   without passing it through the scanner, and *LINE then points directly
+   into the lexer's buffer instead of into a copy in the token (whose string
+   is left empty).  Either way, *LINE remains valid only until LEXER next
+   advances or looks ahead. */
+bool
+lex_get_inline_data (struct lexer *lexer, struct substring *line)
+{
+  struct lex_source *src = lex_source__ (lexer);
+
+  if (src != NULL && !src->eof && deque_count (&src->deque) == 1
+      && segmenter_is_inline_data (&src->segmenter))
+    {
+      struct segmenter segmenter = src->segmenter;
+      struct lex_token *token;
+      enum segment_type type;
+      int seg_len;
+
+      /* Replace the current token by the new one.  (The new token must be
+         pushed before reading more input, because the oldest token limits
+         the bytes that reading may discard.) */
+      lex_source_pop__ (src);
+      token = lex_push_token__ (src);
+      token->line_pos = src->line_pos;
+      token->token_pos = src->seg_pos;
+
+      /* Scan the new-line that ends the current line of data, exactly as
+         lex_source_get__() would scan it as a token of its own. */
+      while ((seg_len = segmenter_push (&segmenter,
+                                        &src->buffer[src->seg_pos - src->tail],
+                                        src->head - src->seg_pos,
+                                        &type)) < 0)
+        lex_source_read__ (src);
+      if (type == SEG_NEWLINE)
+        {
+          src->segmenter = segmenter;
+          src->seg_pos += seg_len;
+          src->line_pos = src->seg_pos;
+          src->n_newlines++;
+          lex_source_journal__ (src, 1, SEG_NEWLINE);
+
+          token->line_pos = src->line_pos;
+          token->token_pos = src->seg_pos;
+
+          /* Scan the following line.  It is usually another line of data,
+             but it could be END DATA or something else entirely. */
+          while ((seg_len = segmenter_push (
+                    &segmenter, &src->buffer[src->seg_pos - src->tail],
+                    src->head - src->seg_pos, &type)) < 0)
+            lex_source_read__ (src);
+          if (type == SEG_INLINE_DATA)
+            {
+              src->segmenter = segmenter;
+              src->seg_pos += seg_len;
+
+              token->token.type = T_STRING;
+              token->token_len = seg_len;
+              if (src->reader->line_number > 0)
+                token->first_line = (src->reader->line_number
+                                     + src->n_newlines);
+              else
+                token->first_line = 0;
+
+              *line = ss_buffer (&src->buffer[token->token_pos - src->tail],
+                                 seg_len);
+              return true;
+            }
+        }
+
+      /* Let lex_get() take it from here. */
+      lex_source_pop_front (src);
+    }
+
+  lex_get (lexer);
+  if (!lex_is_string (lexer))
+    return false;
+
+  *line = lex_tokss (lexer);
+  return true;
+}
+
 /* Issuing errors. */
 
 /* Prints a syntax error message containing the current token and
@@ -1151,10 +1245,17 @@ lex_source_max_tail__ (const struct lex_source *src)
   return max_tail;
 }
 
+/* Ensures that SRC's buffer has room for at least LEX_READ_SIZE more bytes
+   at its head, first by discarding bytes at the tail that are no longer
+   needed and then, if that is not enough, by expanding the buffer.
+
+   Reading in large blocks matters for long syntax files.  Each read,
+   besides the call into the lex_reader, also entails moving the unused
+   part of the buffer and scanning the new bytes. */
 static void
 lex_source_expand__ (struct lex_source *src)
 {
-  if (src->head - src->tail >= src->allocated)
+  if (src->allocated - (src->head - src->tail) < LEX_READ_SIZE)
     {
       size_t max_tail = lex_source_max_tail__ (src);
       if (max_tail > src->tail)
@@ -1164,22 +1265,24 @@ lex_source_expand__ (struct lex_source *src)
                    src->head - max_tail);
           src->tail = max_tail;
         }
-      else
+
+      if (src->allocated - (src->head - src->tail) < LEX_READ_SIZE)
         {
-          /* Buffer is completely full.  Expand it. */
-          src->buffer = x2realloc (src->buffer, &src->allocated);
+          /* Not enough room.  Expand the buffer. */
+          src->allocated = MAX (2 * src->allocated,
+                                src->head - src->tail + LEX_READ_SIZE);
+          src->buffer = xrealloc (src->buffer, src->allocated);
         }
     }
-  else
-    {
-      /* There's space available at the head of the buffer.  Nothing to do. */
-    }
 }
 
 static void
 lex_source_read__ (struct lex_source *src)
 {
-  do
+  /* Read until there is at least one full line past seg_pos, searching for a
+     new-line only in newly read bytes. */
+  size_t scan_pos = src->seg_pos;
+  for (;;)
     {
       lex_source_expand__ (src);
 
@@ -1190,23 +1293,23 @@ lex_source_read__ (struct lex_source *src)
                                            space, prompt);
       assert (n <= space);
 
-      for (char *p = &src->buffer[head_ofs]; p < &src->buffer[head_ofs + n];
-           p++)
-        if (*p == '\0')
-          {
-            struct msg m;
-            m.category = MSG_C_SYNTAX;
-            m.severity = MSG_S_ERROR;
-            m.file_name = src->reader->file_name;
-            m.first_line = 0;
-            m.last_line = 0;
-            m.first_column = 0;
-            m.last_column = 0;
-            m.text = xstrdup ("Bad character U+0000 in input.");
-            msg_emit (&m);
-
-            *p = ' ';
-          }
+      char *end = &src->buffer[head_ofs + n];
+      for (char *p = memchr (&src->buffer[head_ofs], '\0', n); p != NULL;
+           p = memchr (p + 1, '\0', end - (p + 1)))
+        {
+          struct msg m;
+          m.category = MSG_C_SYNTAX;
+          m.severity = MSG_S_ERROR;
+          m.file_name = src->reader->file_name;
+          m.first_line = 0;
+          m.last_line = 0;
+          m.first_column = 0;
+          m.last_column = 0;
+          m.text = xstrdup ("Bad character U+0000 in input.");
+          msg_emit (&m);
+
+          *p = ' ';
+        }
 
       if (n == 0)
         {
@@ -1226,9 +1329,11 @@ lex_source_read__ (struct lex_source *src)
         }
 
       src->head += n;
+      if (memchr (&src->buffer[scan_pos - src->tail], '\n',
+                  src->head - scan_pos))
+        return;
+      scan_pos = src->head;
     }
-  while (!memchr (&src->buffer[src->seg_pos - src->tail], '\n',
-                  src->head - src->seg_pos));
 }
 
 static struct lex_source *
@@ -1336,6 +1441,45 @@ lex_get_error (struct lex_source *src, const char *format, ...)
   va_end (args);
 }
 
+/* Passes the lines that SRC has finished scanning to the output engine as
+   syntax text items.  N_NEWLINES is the number of new-lines that SRC just
+   scanned and LAST_SEGMENT is the type of the last segment scanned. */
+static void
+lex_source_journal__ (struct lex_source *src, int n_newlines,
+                      enum segment_type last_segment)
+{
+  /* If we've reached the end of a line, or the end of a command, then pass
+     the line to the output engine as a syntax text item.  */
+  int n_lines = n_newlines;
+  if (last_segment == SEG_END_COMMAND && !src->suppress_next_newline)
+    {
+      n_lines++;
+      src->suppress_next_newline = true;
+    }
+  else if (n_lines > 0 && src->suppress_next_newline)
+    {
+      n_lines--;
+      src->suppress_next_newline = false;
+    }
+  for (int i = 0; i < n_lines; i++)
+    {
+      const char *line = &src->buffer[src->journal_pos - src->tail];
+      const char *newline = rawmemchr (line, '\n');
+      size_t line_len = newline - line;
+      if (line_len > 0 && line[line_len - 1] == '\r')
+        line_len--;
+
+      char *syntax = malloc (line_len + 2);
+      memcpy (syntax, line, line_len);
+      syntax[line_len] = '\n';
+      syntax[line_len + 1] = '\0';
+
+      text_item_submit (text_item_create_nocopy (TEXT_ITEM_SYNTAX, syntax));
+
+      src->journal_pos += newline - line + 1;
+    }
+}
+
 /* Attempts to append an additional token into SRC's deque, reading more from
    the underlying lex_reader if necessary..  Returns true if successful, false
    if the deque already represents (a suffix of) the whole lex_reader's
@@ -1423,36 +1567,7 @@ lex_source_get__ (const struct lex_source *src_)
         break;
     }
 
-  /* If we've reached the end of a line, or the end of a command, then pass
-     the line to the output engine as a syntax text item.  */
-  int n_lines = state.newlines;
-  if (state.last_segment == SEG_END_COMMAND && !src->suppress_next_newline)
-    {
-      n_lines++;
-      src->suppress_next_newline = true;
-    }
-  else if (n_lines > 0 && src->suppress_next_newline)
-    {
-      n_lines--;
-      src->suppress_next_newline = false;
-    }
-  for (int i = 0; i < n_lines; i++)
-    {
-      const char *line = &src->buffer[src->journal_pos - src->tail];
-      const char *newline = rawmemchr (line, '\n');
-      size_t line_len = newline - line;
-      if (line_len > 0 && line[line_len - 1] == '\r')
-        line_len--;
-
-      char *syntax = malloc (line_len + 2);
-      memcpy (syntax, line, line_len);
-      syntax[line_len] = '\n';
-      syntax[line_len + 1] = '\0';
-
-      text_item_submit (text_item_create_nocopy (TEXT_ITEM_SYNTAX, syntax));
-
-      src->journal_pos += newline - line + 1;
-    }
+  lex_source_journal__ (src, state.newlines, state.last_segment);
 
   token->token_len = state.seg_pos - src->seg_pos;
 
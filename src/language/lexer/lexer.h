@@ -101,6 +101,7 @@ void lex_append (struct lexer *, struct lex_reader *);
 
 /* Advancing. */
 void lex_get (struct lexer *);
+bool lex_get_inline_data (struct lexer *, struct substring *line);
 
 /* Token testing functions. */
 bool lex_is_number (struct lexer *);
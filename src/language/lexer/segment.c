@@ -65,6 +65,13 @@ segmenter_u8_to_uc__ (ucs4_t *puc, const char *input_, size_t n)
 
   assert (n > 0);
 
+  if (input[0] < 0x80)
+    {
+      /* Fast path for ASCII, by far the most common case. */
+      *puc = input[0];
+      return 1;
+    }
+
   mblen = u8_mbtoucr (puc, input, n);
   return (mblen >= 0 ? mblen
           : mblen == -2 ? -1
@@ -757,28 +764,34 @@ segmenter_parse_string__ (enum segment_type string_type,
 
   ofs++;
   while (ofs < n)
-    if (input[ofs] == quote)
-      {
+    {
+      /* Skip ahead to the next quote, new-line, or null byte.  Strings can be
+         long, so it is worth using memchr() and memchr2(), which examine many
+         bytes at a time. */
+      const char *q = memchr (input + ofs, quote, n - ofs);
+      size_t limit = q != NULL ? q - input : n;
+      const char *end = memchr2 (input + ofs, '\n', '\0', limit - ofs);
+      if (end != NULL)
+        {
+          *type = SEG_EXPECTED_QUOTE;
+          s->substate = 0;
+          return end - input;
+        }
+      else if (q == NULL)
+        return -1;
+
+      ofs = limit + 1;
+      if (ofs >= n)
+        return -1;
+      else if (input[ofs] == quote)
         ofs++;
-        if (ofs >= n)
-          return -1;
-        else if (input[ofs] == quote)
-          ofs++;
-        else
-          {
-            *type = string_type;
-            s->substate = 0;
-            return ofs;
-          }
-      }
-    else if (input[ofs] == '\n' || input[ofs] == '\0')
-      {
-        *type = SEG_EXPECTED_QUOTE;
-        s->substate = 0;
-        return ofs;
-      }
-    else
-      ofs++;
+      else
+        {
+          *type = string_type;
+          s->substate = 0;
+          return ofs;
+        }
+    }
 
   return -1;
 }
@@ -934,60 +947,39 @@ segmenter_parse_mid_command__ (struct segmenter *s,
     }
 }
 
-static int
-compare_commands (const void *a_, const void *b_)
-{
-  const char *const *ap = a_;
-  const char *const *bp = b_;
-  const char *a = *ap;
-  const char *b = *bp;
-
-  return c_strcasecmp (a, b);
-}
-
-static const char **
-segmenter_get_command_name_candidates (unsigned char first)
-{
+/* The names of all the commands. */
 #define DEF_CMD(STATES, FLAGS, NAME, FUNCTION) NAME,
 #define UNIMPL_CMD(NAME, DESCRIPTION) NAME,
-  static const char *commands[] =
-    {
+static const char *const command_names[] =
+  {
 #include "language/command.def"
-      ""
-    };
-  static size_t n_commands = (sizeof commands / sizeof *commands) - 1;
+  };
 #undef DEF_CMD
 #undef UNIMPL_CMD
 
+/* Returns an index for 'command_names'. */
+static const struct command_index *
+segmenter_get_command_index (void)
+{
+  static struct command_index cmd_index;
   static bool inited;
 
-  static const char **cindex[UCHAR_MAX + 1];
-
   if (!inited)
     {
-      size_t i;
-
       inited = true;
-
-      qsort (commands, n_commands, sizeof *commands, compare_commands);
-      for (i = 0; i < n_commands; i++)
-        {
-          unsigned char c = c_toupper (commands[i][0]);
-          if (cindex[c] == NULL)
-            cindex[c] = &commands[i];
-        }
-      for (i = 0; i <= UCHAR_MAX; i++)
-        if (cindex[i] == NULL)
-          cindex[i] = &commands[n_commands];
+      command_index_init (&cmd_index, command_names,
+                          sizeof command_names / sizeof *command_names);
     }
 
-  return cindex[c_toupper (first)];
+  return &cmd_index;
 }
 
 static int
 segmenter_detect_command_name__ (const char *input, size_t n, int ofs)
 {
-  const char **commands;
+  const size_t *candidates;
+  size_t n_candidates, i;
+  ucs4_t first_uc = 0;
 
   input += ofs;
   n -= ofs;
@@ -1008,6 +1000,8 @@ segmenter_detect_command_name__ (const char *input, size_t n, int ofs)
           || !(lex_uc_is_space (uc) || lex_uc_is_idn (uc) || uc == '-'))
         break;
 
+      if (!ofs)
+        first_uc = uc;
       ofs += mblen;
     }
   if (!ofs)
@@ -1016,15 +1010,19 @@ segmenter_detect_command_name__ (const char *input, size_t n, int ofs)
   if (input[ofs - 1] == '.')
     ofs--;
 
-  for (commands = segmenter_get_command_name_candidates (input[0]);
-       c_toupper (input[0]) == c_toupper ((*commands)[0]);
-       commands++)
+  /* A command name must start at the beginning of the input. */
+  if (lex_uc_is_space (first_uc))
+    return 0;
+
+  n_candidates = command_index_lookup (segmenter_get_command_index (),
+                                       ss_buffer (input, ofs), &candidates);
+  for (i = 0; i < n_candidates; i++)
     {
       int missing_words;
       bool exact;
 
-      if (command_match (ss_cstr (*commands), ss_buffer (input, ofs),
-                         &exact, &missing_words)
+      if (command_match (ss_cstr (command_names[candidates[i]]),
+                         ss_buffer (input, ofs), &exact, &missing_words)
           && missing_words <= 0)
         return 1;
     }
@@ -1597,6 +1595,15 @@ segmenter_push (struct segmenter *s, const char *input, size_t n,
   NOT_REACHED ();
 }
 
+/* Returns true if S is within the inline data between BEGIN DATA and END
+   DATA, just after a line of data, so that segmenter_push() will next yield
+   the new-line that ends the line, false otherwise. */
+bool
+segmenter_is_inline_data (const struct segmenter *s)
+{
+  return s->state == S_BEGIN_DATA_4;
+}
+
 /* Returns the style of command prompt to display to an interactive user for
    input in S.  The return value is most accurate in mode SEG_MODE_INTERACTIVE
    and at the beginning of a line (that is, if segmenter_push() consumed as
@@ -122,5 +122,6 @@ int segmenter_push (struct segmenter *, const char *input, size_t n,
                     enum segment_type *);
 
 enum prompt_style segmenter_get_prompt (const struct segmenter *);
+bool segmenter_is_inline_data (const struct segmenter *);
 
 #endif /* segment.h */
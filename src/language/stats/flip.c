@@ -60,19 +60,46 @@ struct var_names
 static void var_names_init (struct var_names *);
 static void var_names_add (struct pool *, struct var_names *, const char *);
 
-/* Represents a FLIP input program. */
+/* Represents a FLIP input program.
+
+   FLIP collects the input cases into blocks that fill half of the
+   workspace.  If all of the input fits in a single block, then FLIP
+   transposes it in memory.  Otherwise, it transposes each full block in
+   memory and appends it to a temporary file, in which each block thus
+   consists of one run of values for each variable in turn.
+
+   The output cases are then produced in bands that fill the workspace.
+   FLIP reads each band with one sequential read from each block in the
+   temporary file, because the runs for consecutive variables in a block
+   are adjacent.  Each value is thus written and read only once, always in
+   large sequential chunks. */
 struct flip_pgm
   {
     struct pool *pool;          /* Pool containing FLIP data. */
     size_t n_vars;              /* Pre-flip number of variables. */
-    int n_cases;                /* Pre-flip number of cases. */
+    size_t n_cases;             /* Pre-flip number of cases. */
 
     struct variable *new_names_var; /* Variable with new variable names. */
     const char *encoding;           /* Variable names' encoding. */
     struct var_names old_names; /* Variable names before FLIP. */
     struct var_names new_names; /* Variable names after FLIP. */
 
-    FILE *file;                 /* Temporary file containing data. */
+    /* Input. */
+    double *block;              /* Current block, with n_vars values
+                                   per case. */
+    double *tile;               /* Transposed block. */
+    size_t block_cases;         /* Maximum number of cases in a block. */
+    size_t allocated_cases;     /* Number of cases allocated in 'block'. */
+    size_t n_block_cases;       /* Number of cases in 'block'. */
+    FILE *file;                 /* Temporary file containing full blocks. */
+    size_t n_blocks;            /* Number of blocks in 'file'. */
+
+    /* Output. */
+    double *band;               /* Transposed data, n_cases values per
+                                   output case. */
+    size_t band_start;          /* First output case in 'band'. */
+    size_t band_n;              /* Number of output cases in 'band'. */
+    size_t band_cap;            /* Maximum output cases in 'band'. */
     size_t cases_read;          /* Number of cases already read. */
     bool error;                 /* Error reading temporary file? */
   };
@@ -80,6 +107,7 @@ struct flip_pgm
 static const struct casereader_class flip_casereader_class;
 
 static void destroy_flip_pgm (struct flip_pgm *);
+static double *flip_add_case (struct flip_pgm *);
 static bool flip_file (struct flip_pgm *);
 static void make_new_var (struct dictionary *, const char *name);
 
@@ -106,7 +134,14 @@ cmd_flip (struct lexer *lexer, struct dataset *ds)
   flip->new_names_var = NULL;
   var_names_init (&flip->old_names);
   var_names_init (&flip->new_names);
+  flip->block = NULL;
+  flip->tile = NULL;
+  flip->allocated_cases = 0;
+  flip->n_block_cases = 0;
   flip->file = NULL;
+  flip->n_blocks = 0;
+  flip->band = NULL;
+  flip->band_start = flip->band_n = flip->band_cap = 0;
   flip->cases_read = 0;
   flip->error = false;
 
@@ -146,13 +181,8 @@ cmd_flip (struct lexer *lexer, struct dataset *ds)
     }
   if (flip->n_vars <= 0)
     goto error;
-
-  flip->file = pool_create_temp_file (flip->pool);
-  if (flip->file == NULL)
-    {
-      msg (SE, _("Could not create temporary file for %s."), "FLIP");
-      goto error;
-    }
+  flip->block_cases = MAX (1, (settings_get_workspace () / 2
+                               / (flip->n_vars * sizeof *flip->block)));
 
   /* Save old variable names for use as values of CASE_LBL
      variable in flipped file. */
@@ -169,14 +199,19 @@ cmd_flip (struct lexer *lexer, struct dataset *ds)
   dict_clear (new_dict);
 
   input = proc_open_filtering (ds, false);
-  while ((c = casereader_read (input)) != NULL)
+  while (!flip->error && (c = casereader_read (input)) != NULL)
     {
-      flip->n_cases++;
+      double *values = flip_add_case (flip);
+      if (values == NULL)
+        {
+          case_unref (c);
+          break;
+        }
+
       for (i = 0; i < flip->n_vars; i++)
         {
           const struct variable *v = vars[i];
-          double out = var_is_numeric (v) ? case_num (c, v) : SYSMIS;
-          fwrite (&out, sizeof out, 1, flip->file);
+          values[i] = var_is_numeric (v) ? case_num (c, v) : SYSMIS;
         }
       if (flip->new_names_var != NULL)
         {
@@ -211,6 +246,7 @@ cmd_flip (struct lexer *lexer, struct dataset *ds)
     }
 
   /* Flip the dictionary. */
+  dict_begin_batch (new_dict);
   dict_create_var_assert (new_dict, "CASE_LBL", 8);
   for (i = 0; i < flip->n_cases; i++)
     if (flip->new_names.n_names)
@@ -221,6 +257,7 @@ cmd_flip (struct lexer *lexer, struct dataset *ds)
         sprintf (s, "VAR%03zu", i);
         dict_create_var_assert (new_dict, s, 0);
       }
+  dict_end_batch (new_dict);
 
   /* Set up flipped data for reading. */
   reader = casereader_create_sequential (NULL, dict_get_proto (new_dict),
@@ -297,112 +334,163 @@ make_new_var (struct dictionary *dict, const char *name_)
   free (name);
 }
 
-/* Transposes the external file into a new file. */
+/* Transposes the N_ROWS by N_COLS matrix IN, which is stored row by row,
+   into OUT, so that OUT holds the values in each column of IN in turn.
+   Works on square tiles, so that both matrices are accessed with good
+   locality even when they are much larger than the CPU's caches. */
+static void
+transpose (const double *in, size_t n_rows, size_t n_cols, double *out)
+{
+  enum { TILE = 32 };
+  size_t r0, c0;
+
+  for (r0 = 0; r0 < n_rows; r0 += TILE)
+    for (c0 = 0; c0 < n_cols; c0 += TILE)
+      {
+        size_t r_end = MIN (r0 + TILE, n_rows);
+        size_t c_end = MIN (c0 + TILE, n_cols);
+        size_t r, c;
+
+        for (c = c0; c < c_end; c++)
+          for (r = r0; r < r_end; r++)
+            out[c * n_rows + r] = in[r * n_cols + c];
+      }
+}
+
+/* Transposes the cases in FLIP's current block and appends them to FLIP's
+   temporary file, creating it if necessary.  Returns true if successful,
+   false on error. */
 static bool
-flip_file (struct flip_pgm *flip)
+write_block (struct flip_pgm *flip)
 {
-  size_t case_bytes;
-  size_t case_capacity;
-  size_t case_idx;
-  double *input_buf, *output_buf;
-  FILE *input_file, *output_file;
-
-  /* Allocate memory for many cases. */
-  case_bytes = flip->n_vars * sizeof *input_buf;
-  case_capacity = settings_get_workspace () / case_bytes;
-  if (case_capacity > flip->n_cases * 2)
-    case_capacity = flip->n_cases * 2;
-  if (case_capacity < 2)
-    case_capacity = 2;
-  for (;;)
+  size_t n_values = flip->n_block_cases * flip->n_vars;
+
+  if (flip->file == NULL)
     {
-      size_t bytes = case_bytes * case_capacity;
-      if (case_capacity > 2)
-        input_buf = malloc (bytes);
-      else
-        input_buf = xmalloc (bytes);
-      if (input_buf != NULL)
-	break;
-
-      case_capacity /= 2;
-      if (case_capacity < 2)
-	case_capacity = 2;
+      flip->file = pool_create_temp_file (flip->pool);
+      if (flip->file == NULL)
+        {
+          msg (SE, _("Could not create temporary file for %s."), "FLIP");
+          return false;
+        }
+      flip->tile = pool_nmalloc (flip->pool, flip->block_cases * flip->n_vars,
+                                 sizeof *flip->tile);
     }
-  pool_register (flip->pool, free, input_buf);
 
-  /* Use half the allocated memory for input_buf, half for
-     output_buf. */
-  case_capacity /= 2;
-  output_buf = input_buf + flip->n_vars * case_capacity;
-
-  input_file = flip->file;
-  if (fseeko (input_file, 0, SEEK_SET) != 0)
+  transpose (flip->block, flip->n_block_cases, flip->n_vars, flip->tile);
+  if (fwrite (flip->tile, sizeof *flip->tile, n_values, flip->file)
+      != n_values)
     {
-      msg (SE, _("Error rewinding %s file: %s."), "FLIP", strerror (errno));
+      msg (SE, _("Error writing %s source file: %s."), "FLIP",
+           strerror (errno));
       return false;
     }
 
-  output_file = pool_create_temp_file (flip->pool);
-  if (output_file == NULL)
+  flip->n_blocks++;
+  flip->n_block_cases = 0;
+  return true;
+}
+
+/* Adds a case to FLIP and returns the location where the caller should
+   store its n_vars values, or a null pointer if an error occurred. */
+static double *
+flip_add_case (struct flip_pgm *flip)
+{
+  if (flip->n_block_cases >= flip->block_cases && !write_block (flip))
     {
-      msg (SE, _("Error creating %s source file."), "FLIP");
-      return false;
+      flip->error = true;
+      return NULL;
     }
-
-  for (case_idx = 0; case_idx < flip->n_cases; )
+  if (flip->n_block_cases >= flip->allocated_cases)
     {
-      unsigned long read_cases = MIN (flip->n_cases - case_idx,
-                                      case_capacity);
-      size_t i;
+      flip->allocated_cases = MIN (MAX (16, 2 * flip->allocated_cases),
+                                   flip->block_cases);
+      flip->block = pool_nrealloc (flip->pool, flip->block,
+                                   flip->allocated_cases * flip->n_vars,
+                                   sizeof *flip->block);
+    }
 
-      if (read_cases != fread (input_buf, case_bytes, read_cases, input_file))
-        {
-          if (ferror (input_file))
-            msg (SE, _("Error reading %s file: %s."), "FLIP", strerror (errno));
-          else
-            msg (SE, _("Unexpected end of file reading %s file."), "FLIP");
-          return false;
-        }
+  flip->n_cases++;
+  return &flip->block[flip->n_block_cases++ * flip->n_vars];
+}
 
-      for (i = 0; i < flip->n_vars; i++)
-	{
-	  unsigned long j;
+/* Finishes transposing the cases read into FLIP, preparing to read the
+   output cases.  Returns true if successful, false on error. */
+static bool
+flip_file (struct flip_pgm *flip)
+{
+  if (flip->error)
+    return false;
 
-	  for (j = 0; j < read_cases; j++)
-	    output_buf[j] = input_buf[i + j * flip->n_vars];
+  if (flip->file == NULL)
+    {
+      /* All of the data fits in memory. */
+      flip->band = pool_nmalloc (flip->pool, flip->n_vars,
+                                 MAX (1, flip->n_cases) * sizeof *flip->band);
+      transpose (flip->block, flip->n_cases, flip->n_vars, flip->band);
+      flip->band_start = 0;
+      flip->band_n = flip->band_cap = flip->n_vars;
+    }
+  else
+    {
+      if (flip->n_block_cases > 0 && !write_block (flip))
+        return false;
+      pool_free (flip->pool, flip->tile);
+      flip->tile = NULL;
+
+      flip->band_cap = (settings_get_workspace ()
+                        / (flip->n_cases * sizeof *flip->band));
+      flip->band_cap = MAX (1, MIN (flip->band_cap, flip->n_vars));
+      flip->band = pool_nmalloc (flip->pool, flip->band_cap,
+                                 flip->n_cases * sizeof *flip->band);
+      flip->band_start = flip->band_n = 0;
+    }
+  pool_free (flip->pool, flip->block);
+  flip->block = NULL;
 
-	  if (fseeko (output_file,
-                      sizeof *input_buf * (case_idx
-                                           + (off_t) i * flip->n_cases),
-                      SEEK_SET) != 0)
-            {
-              msg (SE, _("Error seeking %s source file: %s."), "FLIP",
-                   strerror (errno));
-              return false;
-            }
+  return true;
+}
 
-	  if (fwrite (output_buf, sizeof *output_buf, read_cases, output_file)
-	      != read_cases)
-            {
-              msg (SE, _("Error writing %s source file: %s."), "FLIP",
-                   strerror (errno));
-              return false;
-            }
-	}
+/* Reads into FLIP's band the values for as many output cases as fit,
+   starting from the next one to be read.  Returns true if successful, false
+   on error. */
+static bool
+read_band (struct flip_pgm *flip)
+{
+  size_t b;
 
-      case_idx += read_cases;
-    }
+  flip->band_start = flip->cases_read;
+  flip->band_n = MIN (flip->band_cap, flip->n_vars - flip->band_start);
+  for (b = 0; b < flip->n_blocks; b++)
+    {
+      size_t first_case = b * flip->block_cases;
+      size_t n = MIN (flip->block_cases, flip->n_cases - first_case);
+      off_t ofs = ((off_t) first_case * flip->n_vars
+                   + (off_t) flip->band_start * n);
+      size_t i;
 
-  pool_fclose_temp_file (flip->pool, input_file);
-  pool_unregister (flip->pool, input_buf);
-  free (input_buf);
+      if (fseeko (flip->file, ofs * sizeof *flip->band, SEEK_SET) != 0)
+        {
+          msg (SE, _("Error seeking %s source file: %s."), "FLIP",
+               strerror (errno));
+          return false;
+        }
 
-  if (fseeko (output_file, 0, SEEK_SET) != 0)
-    {
-      msg (SE, _("Error rewinding %s source file: %s."), "FLIP", strerror (errno));
-      return false;
+      for (i = 0; i < flip->band_n; i++)
+        if (fread (&flip->band[i * flip->n_cases + first_case],
+                   sizeof *flip->band, n, flip->file) != n)
+          {
+            if (ferror (flip->file))
+              msg (SE, _("Error reading %s temporary file: %s."), "FLIP",
+                   strerror (errno));
+            else if (feof (flip->file))
+              msg (SE, _("Unexpected end of file reading %s temporary file."),
+                   "FLIP");
+            else
+              NOT_REACHED ();
+            return false;
+          }
     }
-  flip->file = output_file;
 
   return true;
 }
@@ -413,34 +501,27 @@ static struct ccase *
 flip_casereader_read (struct casereader *reader, void *flip_)
 {
   struct flip_pgm *flip = flip_;
+  const double *values;
   struct ccase *c;
   size_t i;
 
   if (flip->error || flip->cases_read >= flip->n_vars)
     return false;
 
+  if (flip->cases_read >= flip->band_start + flip->band_n
+      && !read_band (flip))
+    {
+      flip->error = true;
+      return NULL;
+    }
+
   c = case_create (casereader_get_proto (reader));
   data_in (ss_cstr (flip->old_names.names[flip->cases_read]), flip->encoding,
            FMT_A, case_data_rw_idx (c, 0), 8, flip->encoding);
 
+  values = &flip->band[(flip->cases_read - flip->band_start) * flip->n_cases];
   for (i = 0; i < flip->n_cases; i++)
-    {
-      double in;
-      if (fread (&in, sizeof in, 1, flip->file) != 1)
-        {
-          case_unref (c);
-          if (ferror (flip->file))
-            msg (SE, _("Error reading %s temporary file: %s."), "FLIP",
-                 strerror (errno));
-          else if (feof (flip->file))
-            msg (SE, _("Unexpected end of file reading %s temporary file."), "FLIP");
-          else
-            NOT_REACHED ();
-          flip->error = true;
-          return NULL;
-        }
-      case_data_rw_idx (c, i + 1)->f = in;
-    }
+    case_data_rw_idx (c, i + 1)->f = values[i];
 
   flip->cases_read++;
 
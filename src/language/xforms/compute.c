@@ -66,6 +66,22 @@ struct compute_trns
 
     /* Rvalue. */
     struct expression *rvalue;	 /* Rvalue expression. */
+
+    /* Execution. */
+    trns_proc_func *proc;        /* Executes on one case. */
+    trns_batch_func *batch;      /* Executes on a batch, or NULL. */
+  };
+
+/* A run of consecutive COMPUTE and IF commands, all of which can execute on
+   batches of cases or none of which can, executed back-to-back as a single
+   transformation.  Syntax that consists of many COMPUTE and IF commands in
+   a row thereby yields only a few transformations.  The run ends at any
+   other transformation and wherever a jump could land, e.g. at the start of
+   a DO IF clause or a LOOP. */
+struct compute_block
+  {
+    struct compute_trns **computes;
+    size_t n, allocated;
   };
 
 static struct expression *parse_rvalue (struct lexer *lexer,
@@ -74,7 +90,10 @@ static struct expression *parse_rvalue (struct lexer *lexer,
 
 static struct compute_trns *compute_trns_create (void);
 static trns_proc_func *get_proc_func (const struct lvalue *);
+static trns_batch_func *get_batch_func (const struct lvalue *,
+                                        const struct compute_trns *);
 static trns_free_func compute_trns_free;
+static void add_compute (struct dataset *, struct compute_trns *);
 
 /* COMPUTE. */
 
@@ -97,7 +116,9 @@ cmd_compute (struct lexer *lexer, struct dataset *ds)
   if (compute->rvalue == NULL)
     goto fail;
 
-  add_transformation (ds, get_proc_func (lvalue), compute_trns_free, compute);
+  compute->proc = get_proc_func (lvalue);
+  compute->batch = get_batch_func (lvalue, compute);
+  add_compute (ds, compute);
 
   lvalue_finalize (lvalue, compute, dict);
 
@@ -128,6 +149,55 @@ compute_num (void *compute_, struct ccase **c, casenumber case_num)
   return TRNS_CONTINUE;
 }
 
+/* Handle COMPUTE or IF with numeric target variable, for a batch
+   of N cases. */
+static size_t
+compute_num_batch (void *compute_, struct ccase **cases, size_t n)
+{
+  struct compute_trns *compute = compute_;
+  double *values = xnmalloc (n, sizeof *values);
+  size_t i;
+
+  if (compute->test == NULL)
+    {
+      expr_evaluate_num_batch (compute->rvalue, cases, n, values);
+      for (i = 0; i < n; i++)
+        {
+          cases[i] = case_unshare (cases[i]);
+          case_data_rw (cases[i], compute->variable)->f = values[i];
+        }
+    }
+  else
+    {
+      /* Evaluate the rvalue only for the cases that pass the test. */
+      struct ccase **selected = xnmalloc (n, sizeof *selected);
+      size_t *indexes = xnmalloc (n, sizeof *indexes);
+      size_t n_selected = 0;
+
+      expr_evaluate_num_batch (compute->test, cases, n, values);
+      for (i = 0; i < n; i++)
+        if (values[i] == 1.0)
+          {
+            selected[n_selected] = cases[i];
+            indexes[n_selected++] = i;
+          }
+
+      expr_evaluate_num_batch (compute->rvalue, selected, n_selected, values);
+      for (i = 0; i < n_selected; i++)
+        {
+          struct ccase **c = &cases[indexes[i]];
+          *c = case_unshare (*c);
+          case_data_rw (*c, compute->variable)->f = values[i];
+        }
+
+      free (selected);
+      free (indexes);
+    }
+
+  free (values);
+  return n;
+}
+
 /* Handle COMPUTE or IF with numeric vector element target
    variable. */
 static int
@@ -225,6 +295,80 @@ compute_str_vec (void *compute_, struct ccase **c, casenumber case_num)
   return TRNS_CONTINUE;
 }
 
+/* Executes each COMPUTE or IF in the block on case *C. */
+static int
+compute_block_proc (void *block_, struct ccase **c, casenumber case_num)
+{
+  struct compute_block *block = block_;
+  size_t i;
+
+  for (i = 0; i < block->n; i++)
+    {
+      struct compute_trns *compute = block->computes[i];
+      compute->proc (compute, c, case_num);
+    }
+
+  return TRNS_CONTINUE;
+}
+
+/* Executes each COMPUTE or IF in the block, in turn, on the N cases in
+   CASES[]. */
+static size_t
+compute_block_batch (void *block_, struct ccase **cases, size_t n)
+{
+  struct compute_block *block = block_;
+  size_t i;
+
+  for (i = 0; i < block->n; i++)
+    {
+      struct compute_trns *compute = block->computes[i];
+      n = compute->batch (compute, cases, n);
+    }
+
+  return n;
+}
+
+/* Destroys the block and each COMPUTE or IF in it. */
+static bool
+compute_block_free (void *block_)
+{
+  struct compute_block *block = block_;
+  size_t i;
+
+  for (i = 0; i < block->n; i++)
+    compute_trns_free (block->computes[i]);
+  free (block->computes);
+  free (block);
+  return true;
+}
+
+/* Adds COMPUTE to the active dataset's transformations, as part of the most
+   recently added block if it can execute in the same way, otherwise in a
+   new block. */
+static void
+add_compute (struct dataset *ds, struct compute_trns *compute)
+{
+  struct compute_block *block;
+
+  block = last_transformation (ds, compute_block_proc);
+  if (block == NULL
+      || (block->computes[0]->batch != NULL) != (compute->batch != NULL))
+    {
+      block = xmalloc (sizeof *block);
+      block->computes = NULL;
+      block->n = block->allocated = 0;
+      add_batch_transformation (ds, compute_block_proc,
+                                (compute->batch != NULL
+                                 ? compute_block_batch : NULL),
+                                compute_block_free, block);
+    }
+
+  if (block->n >= block->allocated)
+    block->computes = x2nrealloc (block->computes, &block->allocated,
+                                  sizeof *block->computes);
+  block->computes[block->n++] = compute;
+}
+
 /* IF. */
 
 int
@@ -253,7 +397,9 @@ cmd_if (struct lexer *lexer, struct dataset *ds)
   if (compute->rvalue == NULL)
     goto fail;
 
-  add_transformation (ds, get_proc_func (lvalue), compute_trns_free, compute);
+  compute->proc = get_proc_func (lvalue);
+  compute->batch = get_batch_func (lvalue, compute);
+  add_compute (ds, compute);
 
   lvalue_finalize (lvalue, compute, dict);
 
@@ -278,6 +424,20 @@ get_proc_func (const struct lvalue *lvalue)
           : (is_vector ? compute_str_vec : compute_str));
 }
 
+/* Returns the function for executing COMPUTE or IF with target LVALUE on a
+   batch of cases, or a null pointer if COMPUTE must execute one case at a
+   time.  Only a numeric variable target is supported. */
+static trns_batch_func *
+get_batch_func (const struct lvalue *lvalue,
+                const struct compute_trns *compute)
+{
+  return (lvalue_get_type (lvalue) == VAL_NUMERIC
+          && !lvalue_is_vector (lvalue)
+          && expr_is_batchable (compute->rvalue)
+          && (compute->test == NULL || expr_is_batchable (compute->test))
+          ? compute_num_batch : NULL);
+}
+
 /* Parses and returns an rvalue expression of the same type as
    LVALUE, or a null pointer on failure. */
 static struct expression *
@@ -299,6 +459,8 @@ compute_trns_create (void)
   compute->vector = NULL;
   compute->element = NULL;
   compute->rvalue = NULL;
+  compute->proc = NULL;
+  compute->batch = NULL;
   return compute;
 }
 
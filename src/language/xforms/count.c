@@ -27,12 +27,16 @@
 #include "language/lexer/lexer.h"
 #include "language/lexer/value-parser.h"
 #include "language/lexer/variable-parser.h"
+#include "libpspp/cast.h"
 #include "libpspp/compiler.h"
+#include "libpspp/hash-functions.h"
+#include "libpspp/hmap.h"
 #include "libpspp/i18n.h"
 #include "libpspp/message.h"
 #include "libpspp/pool.h"
 #include "libpspp/str.h"
 
+#include "gl/minmax.h"
 #include "gl/xalloc.h"
 
 #include "gettext.h"
@@ -52,6 +56,29 @@ struct num_value
     double a, b;                /* Values to count. */
   };
 
+/* With this many distinct criterion values or fewer, it is faster to
+   compare against each value in turn than to look them up in a hash
+   table. */
+#define COUNT_MAX_LINEAR 8
+
+/* Distinct criterion values to count, for variables of a given width.
+   Criterion values for string variables are truncated to the width. */
+struct count_values
+  {
+    int width;                  /* Variable width (0 for numeric). */
+    size_t n;                   /* Number of distinct values. */
+    double *nums;               /* Numeric values, if width is 0. */
+    const char **strs;          /* String values, if width is nonzero. */
+    struct hmap hmap;           /* Contains "struct count_value"s. */
+  };
+
+/* A criterion value in struct count_values's hash table. */
+struct count_value
+  {
+    struct hmap_node hmap_node; /* Hashed on the value. */
+    size_t idx;                 /* Index into "nums" or "strs". */
+  };
+
 struct criteria
   {
     struct criteria *next;
@@ -72,6 +99,11 @@ struct criteria
 	char **str;
       }
     values;
+
+    /* Compiled criteria, built by compile_criteria(). */
+    struct count_values **var_values; /* Values to count for each variable. */
+    struct num_value *ranges;   /* CNT_RANGE values, disjoint and in order. */
+    size_t n_ranges;            /* Number of ranges. */
   };
 
 struct dst_var
@@ -89,12 +121,14 @@ struct count_trns
   };
 
 static trns_proc_func count_trns_proc;
+static trns_batch_func count_trns_batch;
 static trns_free_func count_trns_free;
 
 static bool parse_numeric_criteria (struct lexer *, struct pool *, struct criteria *);
 static bool parse_string_criteria (struct lexer *, struct pool *,
                                    struct criteria *,
                                    const char *dict_encoding);
+static void compile_criteria (struct pool *, struct criteria *);
 
 int
 cmd_count (struct lexer *lexer, struct dataset *ds)
@@ -185,7 +219,16 @@ cmd_count (struct lexer *lexer, struct dataset *ds)
           dv->var = dict_create_var_assert (dataset_dict (ds), dv->name, 0);
       }
 
-  add_transformation (ds, count_trns_proc, count_trns_free, trns);
+  for (dv = trns->dst_vars; dv; dv = dv->next)
+    {
+      struct criteria *crit;
+
+      for (crit = dv->crit; crit; crit = crit->next)
+        compile_criteria (trns->pool, crit);
+    }
+
+  add_batch_transformation (ds, count_trns_proc, count_trns_batch,
+                            count_trns_free, trns);
   return CMD_SUCCESS;
 
 fail:
@@ -278,37 +321,240 @@ parse_string_criteria (struct lexer *lexer, struct pool *pool,
   return true;
 }
 
+/* Compiling criteria. */
+
+/* Returns a hash value for numeric criterion value X.  Because 0 == -0,
+   these must hash to the same value. */
+static unsigned int
+hash_num_value (double x)
+{
+  return hash_double (x == 0.0 ? 0.0 : x, 0);
+}
+
+/* Returns true if VALUES contains numeric value X, whose hash is
+   HASH. */
+static bool
+contains_num (const struct count_values *values, double x, unsigned int hash)
+{
+  const struct count_value *value;
+
+  HMAP_FOR_EACH_WITH_HASH (value, struct count_value, hmap_node,
+                           hash, &values->hmap)
+    if (values->nums[value->idx] == x)
+      return true;
+  return false;
+}
+
+/* Returns true if VALUES contains string value S, which has VALUES's
+   width and whose hash is HASH. */
+static bool
+contains_str (const struct count_values *values, const char *s,
+              unsigned int hash)
+{
+  const struct count_value *value;
+
+  HMAP_FOR_EACH_WITH_HASH (value, struct count_value, hmap_node,
+                           hash, &values->hmap)
+    if (!memcmp (values->strs[value->idx], s, values->width))
+      return true;
+  return false;
+}
+
+/* Destroys VALUES's hash table.  (The rest of VALUES is allocated from
+   its transformation's pool.) */
+static void
+destroy_values (void *values_)
+{
+  struct count_values *values = values_;
+  hmap_destroy (&values->hmap);
+}
+
+/* Creates and returns the distinct values among CRIT's CNT_SINGLE
+   values or string values, as counted in variables of the given
+   WIDTH. */
+static struct count_values *
+create_values (struct pool *pool, const struct criteria *crit, int width)
+{
+  struct count_values *values;
+  size_t i;
+
+  values = pool_alloc (pool, sizeof *values);
+  values->width = width;
+  values->n = 0;
+  values->nums = NULL;
+  values->strs = NULL;
+  hmap_init (&values->hmap);
+  pool_register (pool, destroy_values, values);
+
+  if (width == 0)
+    values->nums = pool_nmalloc (pool, crit->value_cnt, sizeof *values->nums);
+  else
+    values->strs = pool_nmalloc (pool, crit->value_cnt, sizeof *values->strs);
+  for (i = 0; i < crit->value_cnt; i++)
+    {
+      struct count_value *value;
+      unsigned int hash;
+
+      if (width == 0)
+        {
+          const struct num_value *v = &crit->values.num[i];
+          if (v->type != CNT_SINGLE)
+            continue;
+
+          hash = hash_num_value (v->a);
+          if (contains_num (values, v->a, hash))
+            continue;
+          values->nums[values->n] = v->a;
+        }
+      else
+        {
+          const char *s = crit->values.str[i];
+
+          hash = hash_bytes (s, width, 0);
+          if (contains_str (values, s, hash))
+            continue;
+          values->strs[values->n] = s;
+        }
+
+      value = pool_alloc (pool, sizeof *value);
+      value->idx = values->n++;
+      hmap_insert (&values->hmap, &value->hmap_node, hash);
+    }
+
+  return values;
+}
+
+static int
+compare_num_ranges (const void *a_, const void *b_)
+{
+  const struct num_value *a = a_;
+  const struct num_value *b = b_;
+
+  return a->a < b->a ? -1 : a->a > b->a;
+}
+
+/* Collects CRIT's CNT_RANGE values into CRIT->ranges, merging ranges
+   that overlap, since a value is counted only once however many ranges
+   contain it. */
+static void
+compile_ranges (struct pool *pool, struct criteria *crit)
+{
+  size_t i, n;
+
+  crit->ranges = pool_nmalloc (pool, crit->value_cnt, sizeof *crit->ranges);
+  n = 0;
+  for (i = 0; i < crit->value_cnt; i++)
+    if (crit->values.num[i].type == CNT_RANGE)
+      crit->ranges[n++] = crit->values.num[i];
+  qsort (crit->ranges, n, sizeof *crit->ranges, compare_num_ranges);
+
+  crit->n_ranges = 0;
+  for (i = 0; i < n; i++)
+    {
+      const struct num_value *range = &crit->ranges[i];
+      struct num_value *last = (crit->n_ranges > 0
+                                ? &crit->ranges[crit->n_ranges - 1]
+                                : NULL);
+
+      if (last != NULL && range->a <= last->b)
+        last->b = MAX (last->b, range->b);
+      else
+        crit->ranges[crit->n_ranges++] = *range;
+    }
+}
+
+/* Compiles CRIT's values, so that counting does not need to compare
+   each variable's value against every criterion value in turn. */
+static void
+compile_criteria (struct pool *pool, struct criteria *crit)
+{
+  size_t i, j;
+
+  crit->var_values = pool_nmalloc (pool, crit->var_cnt,
+                                   sizeof *crit->var_values);
+  for (i = 0; i < crit->var_cnt; i++)
+    {
+      int width = var_get_width (crit->vars[i]);
+
+      crit->var_values[i] = NULL;
+      for (j = 0; j < i; j++)
+        if (crit->var_values[j]->width == width)
+          {
+            crit->var_values[i] = crit->var_values[j];
+            break;
+          }
+      if (crit->var_values[i] == NULL)
+        crit->var_values[i] = create_values (pool, crit, width);
+    }
+
+  crit->ranges = NULL;
+  crit->n_ranges = 0;
+  if (var_is_numeric (crit->vars[0]))
+    compile_ranges (pool, crit);
+}
+
 /* Transformation. */
 
+/* Returns true if X is one of the numeric values in VALUES. */
+static bool
+match_num (const struct count_values *values, double x)
+{
+  if (values->n <= COUNT_MAX_LINEAR)
+    {
+      size_t i;
+
+      for (i = 0; i < values->n; i++)
+        if (x == values->nums[i])
+          return true;
+      return false;
+    }
+  else
+    return contains_num (values, x, hash_num_value (x));
+}
+
+/* Returns true if X is within one of CRIT's ranges. */
+static bool
+match_range (const struct criteria *crit, double x)
+{
+  size_t low = 0;
+  size_t high = crit->n_ranges;
+
+  /* Find the number of ranges that start at or below X.  Only the last
+     of these can contain X, because the ranges are disjoint. */
+  while (low < high)
+    {
+      size_t mid = low + (high - low) / 2;
+      if (crit->ranges[mid].a <= x)
+        low = mid + 1;
+      else
+        high = mid;
+    }
+  return low > 0 && x <= crit->ranges[low - 1].b;
+}
+
 /* Counts the number of values in case C matching CRIT. */
 static int
-count_numeric (struct criteria *crit, const struct ccase *c)
+count_numeric (const struct criteria *crit, const struct ccase *c)
 {
+  bool count_missing = (crit->count_system_missing
+                        || crit->count_user_missing);
   int counter = 0;
   size_t i;
 
   for (i = 0; i < crit->var_cnt; i++)
     {
       double x = case_num (c, crit->vars[i]);
-      struct num_value *v;
 
-      for (v = crit->values.num; v < crit->values.num + crit->value_cnt;
-           v++)
-        if (v->type == CNT_SINGLE ? x == v->a : x >= v->a && x <= v->b)
-          {
-            counter++;
-            break;
-          }
+      if (match_num (crit->var_values[i], x)
+          || (crit->n_ranges > 0 && match_range (crit, x)))
+        counter++;
 
-      if (var_is_num_missing (crit->vars[i], x, MV_ANY)
+      if (count_missing
+          && var_is_num_missing (crit->vars[i], x, MV_ANY)
           && (x == SYSMIS
               ? crit->count_system_missing
               : crit->count_user_missing))
-        {
-          counter++;
-          continue;
-        }
-
+        counter++;
     }
 
   return counter;
@@ -316,26 +562,49 @@ count_numeric (struct criteria *crit, const struct ccase *c)
 
 /* Counts the number of values in case C matching CRIT. */
 static int
-count_string (struct criteria *crit, const struct ccase *c)
+count_string (const struct criteria *crit, const struct ccase *c)
 {
   int counter = 0;
   size_t i;
 
   for (i = 0; i < crit->var_cnt; i++)
     {
-      char **v;
-      for (v = crit->values.str; v < crit->values.str + crit->value_cnt; v++)
-        if (!memcmp (case_str (c, crit->vars[i]), *v,
-                     var_get_width (crit->vars[i])))
-          {
-	    counter++;
-            break;
-          }
+      const struct count_values *values = crit->var_values[i];
+      const char *s = CHAR_CAST (const char *, case_str (c, crit->vars[i]));
+
+      if (values->n <= COUNT_MAX_LINEAR)
+        {
+          size_t j;
+
+          for (j = 0; j < values->n; j++)
+            if (!memcmp (s, values->strs[j], values->width))
+              {
+                counter++;
+                break;
+              }
+        }
+      else if (contains_str (values, s, hash_bytes (s, values->width, 0)))
+        counter++;
     }
 
   return counter;
 }
 
+/* Counts the number of values in case C matching the criteria in DV. */
+static int
+count_dst_var (const struct dst_var *dv, const struct ccase *c)
+{
+  const struct criteria *crit;
+  int counter = 0;
+
+  for (crit = dv->crit; crit; crit = crit->next)
+    if (var_is_numeric (crit->vars[0]))
+      counter += count_numeric (crit, c);
+    else
+      counter += count_string (crit, c);
+  return counter;
+}
+
 /* Performs the COUNT transformation T on case C. */
 static int
 count_trns_proc (void *trns_, struct ccase **c,
@@ -346,21 +615,26 @@ count_trns_proc (void *trns_, struct ccase **c,
 
   *c = case_unshare (*c);
   for (dv = trns->dst_vars; dv; dv = dv->next)
-    {
-      struct criteria *crit;
-      int counter;
-
-      counter = 0;
-      for (crit = dv->crit; crit; crit = crit->next)
-	if (var_is_numeric (crit->vars[0]))
-	  counter += count_numeric (crit, *c);
-	else
-	  counter += count_string (crit, *c);
-      case_data_rw (*c, dv->var)->f = counter;
-    }
+    case_data_rw (*c, dv->var)->f = count_dst_var (dv, *c);
   return TRNS_CONTINUE;
 }
 
+/* Performs the COUNT transformation T on the N cases in CASES. */
+static size_t
+count_trns_batch (void *trns_, struct ccase **cases, size_t n)
+{
+  struct count_trns *trns = trns_;
+  struct dst_var *dv;
+  size_t i;
+
+  for (i = 0; i < n; i++)
+    cases[i] = case_unshare (cases[i]);
+  for (dv = trns->dst_vars; dv; dv = dv->next)
+    for (i = 0; i < n; i++)
+      case_data_rw (cases[i], dv->var)->f = count_dst_var (dv, cases[i]);
+  return n;
+}
+
 /* Destroys all dynamic data structures associated with TRNS. */
 static bool
 count_trns_free (void *trns_)
@@ -18,6 +18,7 @@
 
 #include <ctype.h>
 #include <math.h>
+#include <stdint.h>
 #include <stdlib.h>
 
 #include "data/case.h"
@@ -34,11 +35,14 @@
 #include "libpspp/assertion.h"
 #include "libpspp/cast.h"
 #include "libpspp/compiler.h"
+#include "libpspp/hash-functions.h"
+#include "libpspp/hmap.h"
 #include "libpspp/i18n.h"
 #include "libpspp/message.h"
 #include "libpspp/pool.h"
 #include "libpspp/str.h"
 
+#include "gl/minmax.h"
 #include "gl/xalloc.h"
 
 #include "gettext.h"
@@ -101,8 +105,56 @@ struct recode_trns
     size_t map_cnt;             /* Number of mappings. */
     int max_src_width;          /* Maximum width of src_vars[*]. */
     int max_dst_width;          /* Maximum width of any map_out in mappings. */
+
+    /* Compiled mappings. */
+    struct recode_lookup **lookups; /* Lookup for each src_vars[*]. */
+    size_t *others;             /* Indexes of mappings not in lookups. */
+    size_t n_others;            /* Number of indexes in others. */
+  };
+
+/* Compiled form of the mappings in a RECODE transformation, for source
+   variables of a particular width.
+
+   Mappings of a specific source value are found through a hash table or,
+   if they are all integers in a small domain, through a dense array
+   indexed by value.  Numeric ranges are resolved when the transformation
+   is compiled into a sorted array of disjoint intervals, which is
+   searched by bisection.  Each of these yields the index of the first
+   mapping that matches a given value, so that the earliest mapping still
+   takes precedence, as RECODE requires.
+
+   Any other mappings (MISSING, SYSMIS, ELSE, and CONVERT) are few in
+   practice.  They are listed in struct recode_trns's "others" and checked
+   one by one, but only those that precede the mapping already found. */
+struct recode_lookup
+  {
+    int width;                  /* Width of source values. */
+
+    /* MAP_SINGLE mappings. */
+    struct hmap singles;        /* Contains "struct recode_single"s. */
+    size_t *dense;              /* Mapping index for each integer... */
+    size_t n_dense;             /* ...from dense_min to dense_min+n_dense-1, */
+    double dense_min;           /* ...if nonnull, used instead of singles. */
+
+    /* MAP_RANGE mappings.  Interval 2*i is the single value bounds[i],
+       interval 2*i+1 is the values between bounds[i] and bounds[i+1]. */
+    double *bounds;             /* Distinct range endpoints, in order. */
+    size_t n_bounds;            /* Number of range endpoints. */
+    size_t *intervals;          /* Mapping index for each interval. */
   };
 
+/* A source value in struct recode_lookup's "singles". */
+struct recode_single
+  {
+    struct hmap_node hmap_node; /* Hashed on the source value. */
+    double f;                   /* Numeric source value. */
+    const uint8_t *s;           /* String source value, "width" bytes. */
+    size_t idx;                 /* Index of first mapping for value. */
+  };
+
+/* Mapping index that stands for no mapping at all. */
+#define NO_MAPPING SIZE_MAX
+
 static bool parse_src_vars (struct lexer *, struct recode_trns *, const struct dictionary *dict);
 static bool parse_mappings (struct lexer *, struct recode_trns *,
                             const char *dict_encoding);
@@ -127,6 +179,7 @@ static void set_map_out_str (struct map_out *, struct pool *,
 
 static bool enlarge_dst_widths (struct recode_trns *);
 static void create_dst_vars (struct recode_trns *, struct dictionary *);
+static void compile_mappings (struct recode_trns *);
 
 static trns_proc_func recode_trns_proc;
 static trns_free_func recode_trns_free;
@@ -172,6 +225,8 @@ cmd_recode (struct lexer *lexer, struct dataset *ds)
       if (trns->src_vars != trns->dst_vars)
 	create_dst_vars (trns, dict);
 
+      compile_mappings (trns);
+
       /* Done. */
       add_transformation (ds,
 			  recode_trns_proc, recode_trns_free, trns);
@@ -594,32 +649,373 @@ create_dst_vars (struct recode_trns *trns, struct dictionary *dict)
     }
 }
 
+/* Compiling mappings. */
+
+/* A hash table is replaced by a dense array when the array would have no
+   more than DENSE_MIN_SIZE elements or, at most, DENSE_MAX_SPARSITY
+   elements per discrete source value. */
+#define DENSE_MIN_SIZE 256
+#define DENSE_MAX_SPARSITY 4
+
+/* Returns a hash value for numeric source value X.  Because 0 == -0,
+   these must hash to the same value. */
+static unsigned int
+hash_num_single (double x)
+{
+  return hash_double (x == 0.0 ? 0.0 : x, 0);
+}
+
+/* Returns the index of the first mapping in LOOKUP, which must be
+   numeric, whose source value is X and whose hash is HASH, or NO_MAPPING
+   if there is none. */
+static size_t
+find_num_single (const struct recode_lookup *lookup, double x,
+                 unsigned int hash)
+{
+  const struct recode_single *single;
+
+  HMAP_FOR_EACH_WITH_HASH (single, struct recode_single, hmap_node,
+                           hash, &lookup->singles)
+    if (single->f == x)
+      return single->idx;
+  return NO_MAPPING;
+}
+
+/* Returns the index of the first mapping in LOOKUP, which must be for
+   strings, whose source value is the LOOKUP->width bytes in S and whose
+   hash is HASH, or NO_MAPPING if there is none. */
+static size_t
+find_str_single (const struct recode_lookup *lookup, const uint8_t *s,
+                 unsigned int hash)
+{
+  const struct recode_single *single;
+
+  HMAP_FOR_EACH_WITH_HASH (single, struct recode_single, hmap_node,
+                           hash, &lookup->singles)
+    if (!memcmp (single->s, s, lookup->width))
+      return single->idx;
+  return NO_MAPPING;
+}
+
+/* Adds mapping IDX in TRNS, which must be a MAP_SINGLE mapping, to
+   LOOKUP, unless an earlier mapping already has the same source
+   value. */
+static void
+add_single (struct recode_trns *trns, struct recode_lookup *lookup,
+            size_t idx)
+{
+  const struct map_in *in = &trns->mappings[idx].in;
+  struct recode_single *single;
+  unsigned int hash;
+
+  single = pool_alloc (trns->pool, sizeof *single);
+  single->idx = idx;
+  if (lookup->width == 0)
+    {
+      single->f = in->x.f;
+      single->s = NULL;
+      hash = hash_num_single (single->f);
+      if (find_num_single (lookup, single->f, hash) != NO_MAPPING)
+        return;
+    }
+  else
+    {
+      single->f = 0.0;
+      single->s = value_str (&in->x, trns->max_src_width);
+      hash = hash_bytes (single->s, lookup->width, 0);
+      if (find_str_single (lookup, single->s, hash) != NO_MAPPING)
+        return;
+    }
+  hmap_insert (&lookup->singles, &single->hmap_node, hash);
+}
+
+/* If the numeric discrete source values in LOOKUP are all integers
+   within a small enough range, sets up LOOKUP's dense array to map
+   them. */
+static void
+make_dense (struct recode_trns *trns, struct recode_lookup *lookup)
+{
+  const struct recode_single *single;
+  size_t n = hmap_count (&lookup->singles);
+  double min, max;
+  size_t i;
+
+  if (n == 0)
+    return;
+
+  min = HUGE_VAL;
+  max = -HUGE_VAL;
+  HMAP_FOR_EACH (single, struct recode_single, hmap_node, &lookup->singles)
+    {
+      if (single->f != floor (single->f))
+        return;
+      min = MIN (min, single->f);
+      max = MAX (max, single->f);
+    }
+  if (max - min >= MAX (DENSE_MIN_SIZE, (double) n * DENSE_MAX_SPARSITY))
+    return;
+
+  lookup->dense_min = min;
+  lookup->n_dense = max - min + 1;
+  lookup->dense = pool_nmalloc (trns->pool, lookup->n_dense,
+                                sizeof *lookup->dense);
+  for (i = 0; i < lookup->n_dense; i++)
+    lookup->dense[i] = NO_MAPPING;
+  HMAP_FOR_EACH (single, struct recode_single, hmap_node, &lookup->singles)
+    lookup->dense[(size_t) (single->f - min)] = single->idx;
+}
+
+static int
+compare_doubles (const void *a_, const void *b_)
+{
+  const double *a = a_;
+  const double *b = b_;
+
+  return *a < *b ? -1 : *a > *b;
+}
+
+/* Returns the number of the N elements of BOUNDS, which must be in
+   increasing order, that are less than or equal to X. */
+static size_t
+count_bounds (const double *bounds, size_t n, double x)
+{
+  size_t low = 0;
+  size_t high = n;
+
+  while (low < high)
+    {
+      size_t mid = low + (high - low) / 2;
+      if (bounds[mid] <= x)
+        low = mid + 1;
+      else
+        high = mid;
+    }
+  return low;
+}
+
+/* Returns the smallest interval index that is not less than I and that
+   NEXT does not mark as already assigned.  NEXT[I] is I for an
+   unassigned interval, otherwise an index from which to continue the
+   search; the path followed is compressed as a side effect. */
+static size_t
+next_unassigned (size_t *next, size_t i)
+{
+  size_t j = i;
+
+  while (next[j] != j)
+    j = next[j];
+  while (next[i] != j)
+    {
+      size_t k = next[i];
+      next[i] = j;
+      i = k;
+    }
+  return j;
+}
+
+/* Compiles the MAP_RANGE mappings in TRNS into LOOKUP's intervals, so
+   that each interval maps to the first range that contains it. */
+static void
+compile_ranges (struct recode_trns *trns, struct recode_lookup *lookup)
+{
+  size_t n_intervals;
+  size_t *next;
+  size_t i, n;
+
+  lookup->bounds = pool_nmalloc (trns->pool, 2 * trns->map_cnt,
+                                 sizeof *lookup->bounds);
+  n = 0;
+  for (i = 0; i < trns->map_cnt; i++)
+    {
+      const struct map_in *in = &trns->mappings[i].in;
+      if (in->type == MAP_RANGE)
+        {
+          lookup->bounds[n++] = in->x.f;
+          lookup->bounds[n++] = in->y.f;
+        }
+    }
+  if (n == 0)
+    return;
+
+  qsort (lookup->bounds, n, sizeof *lookup->bounds, compare_doubles);
+  lookup->n_bounds = 1;
+  for (i = 1; i < n; i++)
+    if (lookup->bounds[i] != lookup->bounds[lookup->n_bounds - 1])
+      lookup->bounds[lookup->n_bounds++] = lookup->bounds[i];
+
+  n_intervals = 2 * lookup->n_bounds - 1;
+  lookup->intervals = pool_nmalloc (trns->pool, n_intervals,
+                                    sizeof *lookup->intervals);
+  next = xnmalloc (n_intervals + 1, sizeof *next);
+  for (i = 0; i < n_intervals; i++)
+    lookup->intervals[i] = NO_MAPPING;
+  for (i = 0; i <= n_intervals; i++)
+    next[i] = i;
+
+  /* Assign each interval to the first range that covers it.  Intervals
+     already assigned are skipped, so this takes about linear time even
+     if the ranges overlap heavily. */
+  for (i = 0; i < trns->map_cnt; i++)
+    {
+      const struct map_in *in = &trns->mappings[i].in;
+      size_t first, last, j;
+
+      if (in->type != MAP_RANGE)
+        continue;
+
+      first = 2 * (count_bounds (lookup->bounds, lookup->n_bounds,
+                                 in->x.f) - 1);
+      last = 2 * (count_bounds (lookup->bounds, lookup->n_bounds,
+                                in->y.f) - 1);
+      for (j = next_unassigned (next, first); j <= last;
+           j = next_unassigned (next, j + 1))
+        {
+          lookup->intervals[j] = i;
+          next[j] = j + 1;
+        }
+    }
+  free (next);
+}
+
+/* Destroys LOOKUP's hash table.  (The rest of LOOKUP is allocated from
+   its transformation's pool.) */
+static void
+destroy_lookup (void *lookup_)
+{
+  struct recode_lookup *lookup = lookup_;
+  hmap_destroy (&lookup->singles);
+}
+
+/* Creates and returns a lookup for source values of the given WIDTH in
+   TRNS. */
+static struct recode_lookup *
+create_lookup (struct recode_trns *trns, int width)
+{
+  struct recode_lookup *lookup;
+  size_t i;
+
+  lookup = pool_alloc (trns->pool, sizeof *lookup);
+  lookup->width = width;
+  hmap_init (&lookup->singles);
+  pool_register (trns->pool, destroy_lookup, lookup);
+  lookup->dense = NULL;
+  lookup->n_dense = 0;
+  lookup->dense_min = 0.0;
+  lookup->bounds = NULL;
+  lookup->n_bounds = 0;
+  lookup->intervals = NULL;
+
+  for (i = 0; i < trns->map_cnt; i++)
+    if (trns->mappings[i].in.type == MAP_SINGLE)
+      add_single (trns, lookup, i);
+
+  if (width == 0)
+    {
+      make_dense (trns, lookup);
+      compile_ranges (trns, lookup);
+    }
+
+  return lookup;
+}
+
+/* Compiles the mappings in TRNS into lookups, one for each source
+   variable width, so that recoding a value does not need to examine
+   each mapping in turn. */
+static void
+compile_mappings (struct recode_trns *trns)
+{
+  size_t i, j;
+
+  trns->others = pool_nmalloc (trns->pool, trns->map_cnt,
+                               sizeof *trns->others);
+  trns->n_others = 0;
+  for (i = 0; i < trns->map_cnt; i++)
+    {
+      enum map_in_type type = trns->mappings[i].in.type;
+      if (type != MAP_SINGLE && type != MAP_RANGE)
+        trns->others[trns->n_others++] = i;
+    }
+
+  trns->lookups = pool_nmalloc (trns->pool, trns->var_cnt,
+                                sizeof *trns->lookups);
+  for (i = 0; i < trns->var_cnt; i++)
+    {
+      int width = var_get_width (trns->src_vars[i]);
+
+      trns->lookups[i] = NULL;
+      for (j = 0; j < i; j++)
+        if (trns->lookups[j]->width == width)
+          {
+            trns->lookups[i] = trns->lookups[j];
+            break;
+          }
+      if (trns->lookups[i] == NULL)
+        trns->lookups[i] = create_lookup (trns, width);
+    }
+}
+
 /* Data transformation. */
 
+/* Returns the index of the first MAP_SINGLE or MAP_RANGE mapping in
+   numeric LOOKUP for VALUE, or NO_MAPPING if there is none. */
+static size_t
+lookup_numeric (const struct recode_lookup *lookup, double value)
+{
+  size_t idx;
+
+  if (lookup->dense != NULL)
+    idx = (value >= lookup->dense_min
+           && value - lookup->dense_min < lookup->n_dense
+           && value == floor (value)
+           ? lookup->dense[(size_t) (value - lookup->dense_min)]
+           : NO_MAPPING);
+  else if (!hmap_is_empty (&lookup->singles))
+    idx = find_num_single (lookup, value, hash_num_single (value));
+  else
+    idx = NO_MAPPING;
+
+  if (lookup->n_bounds > 0)
+    {
+      size_t n = count_bounds (lookup->bounds, lookup->n_bounds, value);
+      if (n > 0)
+        {
+          size_t interval;
+
+          if (lookup->bounds[n - 1] == value)
+            interval = 2 * (n - 1);
+          else if (n < lookup->n_bounds)
+            interval = 2 * (n - 1) + 1;
+          else
+            return idx;
+
+          idx = MIN (idx, lookup->intervals[interval]);
+        }
+    }
+
+  return idx;
+}
+
 /* Returns the output mapping in TRNS for an input of VALUE on
-   variable V, or a null pointer if there is no mapping. */
+   variable V, whose lookup is LOOKUP, or a null pointer if there is no
+   mapping. */
 static const struct map_out *
-find_src_numeric (struct recode_trns *trns, double value, const struct variable *v)
+find_src_numeric (struct recode_trns *trns,
+                  const struct recode_lookup *lookup,
+                  double value, const struct variable *v)
 {
-  struct mapping *m;
+  size_t idx = lookup_numeric (lookup, value);
+  const size_t *p;
 
-  for (m = trns->mappings; m < trns->mappings + trns->map_cnt; m++)
+  for (p = trns->others; p < trns->others + trns->n_others && *p < idx; p++)
     {
-      const struct map_in *in = &m->in;
-      const struct map_out *out = &m->out;
+      const struct mapping *m = &trns->mappings[*p];
       bool match;
 
-      switch (in->type)
+      switch (m->in.type)
         {
-        case MAP_SINGLE:
-          match = value == in->x.f;
-          break;
         case MAP_MISSING:
           match = var_is_num_missing (v, value, MV_ANY);
           break;
-        case MAP_RANGE:
-          match = value >= in->x.f && value <= in->y.f;
-          break;
         case MAP_SYSMIS:
           match = value == SYSMIS;
           break;
@@ -631,34 +1027,34 @@ find_src_numeric (struct recode_trns *trns, double value, const struct variable
         }
 
       if (match)
-        return out;
+        return &m->out;
     }
 
-  return NULL;
+  return idx != NO_MAPPING ? &trns->mappings[idx].out : NULL;
 }
 
-/* Returns the output mapping in TRNS for an input of VALUE with
-   the given WIDTH, or a null pointer if there is no mapping. */
+/* Returns the output mapping in TRNS for an input of VALUE on
+   variable SRC_VAR, whose lookup is LOOKUP, or a null pointer if there
+   is no mapping. */
 static const struct map_out *
-find_src_string (struct recode_trns *trns, const uint8_t *value,
-                 const struct variable *src_var)
+find_src_string (struct recode_trns *trns,
+                 const struct recode_lookup *lookup,
+                 const uint8_t *value, const struct variable *src_var)
 {
   const char *encoding = dict_get_encoding (trns->dst_dict);
-  int width = var_get_width (src_var);
-  struct mapping *m;
+  int width = lookup->width;
+  size_t idx;
+  const size_t *p;
 
-  for (m = trns->mappings; m < trns->mappings + trns->map_cnt; m++)
+  idx = (hmap_is_empty (&lookup->singles) ? NO_MAPPING
+         : find_str_single (lookup, value, hash_bytes (value, width, 0)));
+  for (p = trns->others; p < trns->others + trns->n_others && *p < idx; p++)
     {
-      const struct map_in *in = &m->in;
-      struct map_out *out = &m->out;
+      struct mapping *m = &trns->mappings[*p];
       bool match;
 
-      switch (in->type)
+      switch (m->in.type)
         {
-        case MAP_SINGLE:
-          match = !memcmp (value, value_str (&in->x, trns->max_src_width),
-                           width);
-          break;
         case MAP_ELSE:
           match = true;
           break;
@@ -672,7 +1068,7 @@ find_src_string (struct recode_trns *trns, const uint8_t *value,
             match = error == NULL;
             free (error);
 
-            out->value.f = uv.f;
+            m->out.value.f = uv.f;
             break;
           }
 	case MAP_MISSING:
@@ -683,10 +1079,10 @@ find_src_string (struct recode_trns *trns, const uint8_t *value,
         }
 
       if (match)
-        return out;
+        return &m->out;
     }
 
-  return NULL;
+  return idx != NO_MAPPING ? &trns->mappings[idx].out : NULL;
 }
 
 /* Performs RECODE transformation. */
@@ -704,9 +1100,11 @@ recode_trns_proc (void *trns_, struct ccase **c, casenumber case_idx UNUSED)
       const struct map_out *out;
 
       if (trns->src_type == VAL_NUMERIC)
-        out = find_src_numeric (trns, case_num (*c, src_var), src_var);
+        out = find_src_numeric (trns, trns->lookups[i],
+                                case_num (*c, src_var), src_var);
       else
-        out = find_src_string (trns, case_str (*c, src_var), src_var);
+        out = find_src_string (trns, trns->lookups[i],
+                               case_str (*c, src_var), src_var);
 
       if (trns->dst_type == VAL_NUMERIC)
         {
@@ -18,6 +18,7 @@
 
 #include <stdlib.h>
 
+#include "data/case.h"
 #include "data/dataset.h"
 #include "data/dictionary.h"
 #include "data/transformations.h"
@@ -41,6 +42,7 @@ struct select_if_trns
   };
 
 static trns_proc_func select_if_proc;
+static trns_batch_func select_if_batch;
 static trns_free_func select_if_free;
 
 /* Parses the SELECT IF transformation. */
@@ -63,7 +65,9 @@ cmd_select_if (struct lexer *lexer, struct dataset *ds)
 
   t = xmalloc (sizeof *t);
   t->e = e;
-  add_transformation (ds, select_if_proc, select_if_free, t);
+  add_batch_transformation (ds, select_if_proc,
+                            expr_is_batchable (e) ? select_if_batch : NULL,
+                            select_if_free, t);
 
   return CMD_SUCCESS;
 }
@@ -78,6 +82,28 @@ select_if_proc (void *t_, struct ccase **c,
           ? TRNS_CONTINUE : TRNS_DROP_CASE);
 }
 
+/* Performs the SELECT IF transformation T on the N cases in CASES. */
+static size_t
+select_if_batch (void *t_, struct ccase **cases, size_t n)
+{
+  struct select_if_trns *t = t_;
+  double *values = xnmalloc (n, sizeof *values);
+  size_t i, n_keep;
+
+  expr_evaluate_num_batch (t->e, cases, n, values);
+  n_keep = 0;
+  for (i = 0; i < n; i++)
+    {
+      if (values[i] == 1.0)
+        cases[n_keep++] = cases[i];
+      else
+        case_unref (cases[i]);
+    }
+  free (values);
+
+  return n_keep;
+}
+
 /* Frees SELECT IF transformation T. */
 static bool
 select_if_free (void *t_)
@@ -26,6 +26,8 @@ src_libpspp_liblibpspp_la_SOURCES = \
 	src/libpspp/encoding-guesser.h \
 	src/libpspp/ext-array.c \
 	src/libpspp/ext-array.h \
+	src/libpspp/flatbuffers.c \
+	src/libpspp/flatbuffers.h \
 	src/libpspp/float-format.c \
 	src/libpspp/float-format.h \
 	src/libpspp/freaderror.c \
@@ -0,0 +1,495 @@
+/* PSPP - a program for statistical analysis.
+   Copyright (C) 2017 Free Software Foundation, Inc.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+#include <config.h>
+
+#include "libpspp/flatbuffers.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "libpspp/assertion.h"
+#include "libpspp/cast.h"
+#include "libpspp/integer-format.h"
+
+#include "gl/minmax.h"
+#include "gl/xalloc.h"
+
+/* Initializes B as an empty flatbuffer builder. */
+void
+fb_builder_init (struct fb_builder *b)
+{
+  b->buf = NULL;
+  b->size = 0;
+  b->allocated = 0;
+  b->max_align = 1;
+
+  b->in_table = false;
+  b->table_start = 0;
+  b->fields = NULL;
+  b->n_fields = 0;
+  b->allocated_fields = 0;
+}
+
+/* Frees the memory owned by B. */
+void
+fb_builder_uninit (struct fb_builder *b)
+{
+  free (b->buf);
+  free (b->fields);
+}
+
+/* Discards the data in B, so that it may be used to build another
+   flatbuffer. */
+void
+fb_builder_clear (struct fb_builder *b)
+{
+  assert (!b->in_table);
+  b->size = 0;
+  b->max_align = 1;
+}
+
+/* Returns the address of the byte at OFFSET (as returned by one of the
+   fb_create_*() or fb_end_table() functions) within B's data. */
+static uint8_t *
+fb_at (struct fb_builder *b, size_t offset)
+{
+  return &b->buf[b->allocated - offset];
+}
+
+/* Prepends N bytes to the data in B, preceded by enough zero padding that
+   the N bytes start at a multiple of ALIGN bytes from the end of the buffer.
+   Returns the address of the first of the N bytes, which the caller must
+   initialize. */
+static uint8_t *
+fb_prepend (struct fb_builder *b, size_t n, size_t align)
+{
+  size_t pad = (align - (b->size + n) % align) % align;
+  size_t need = b->size + pad + n;
+
+  if (align > b->max_align)
+    b->max_align = align;
+
+  if (need > b->allocated)
+    {
+      size_t new_allocated = MAX (need, MAX (b->allocated * 2, 256));
+      uint8_t *new_buf = xmalloc (new_allocated);
+      memcpy (new_buf + new_allocated - b->size, fb_at (b, b->size), b->size);
+      free (b->buf);
+      b->buf = new_buf;
+      b->allocated = new_allocated;
+    }
+
+  b->size += pad;
+  memset (fb_at (b, b->size), 0, pad);
+  b->size += n;
+  return fb_at (b, b->size);
+}
+
+/* Prepends the N-byte little-endian integer X to B, aligned on an N-byte
+   boundary, and returns its offset. */
+static uint32_t
+fb_prepend_int (struct fb_builder *b, uint64_t x, size_t n)
+{
+  integer_put (x, INTEGER_LSB_FIRST, fb_prepend (b, n, n), n);
+  return b->size;
+}
+
+/* Prepends a reference to the object at OFFSET to B, and returns the offset
+   of the reference itself. */
+static uint32_t
+fb_prepend_offset (struct fb_builder *b, uint32_t offset)
+{
+  uint8_t *p = fb_prepend (b, 4, 4);
+  assert (offset > 0 && offset < b->size);
+  integer_put (b->size - offset, INTEGER_LSB_FIRST, p, 4);
+  return b->size;
+}
+
+/* Adds null-terminated string S to B and returns its offset. */
+uint32_t
+fb_create_string (struct fb_builder *b, const char *s)
+{
+  size_t len = strlen (s);
+
+  /* The string is followed by a null terminator, which is not included in
+     its length. */
+  memcpy (fb_prepend (b, len + 1, 4), s, len + 1);
+  return fb_prepend_int (b, len, 4);
+}
+
+/* Adds a vector of N elements, each ELEM_SIZE bytes long, to B, and returns
+   its offset.  The elements must already be in little-endian byte order
+   (e.g. structs encoded by the caller).  ALIGN is the required alignment of
+   the elements. */
+uint32_t
+fb_create_vector (struct fb_builder *b, const void *elems,
+                  size_t elem_size, size_t n, size_t align)
+{
+  if (n > 0)
+    memcpy (fb_prepend (b, elem_size * n, MAX (align, 4)), elems,
+            elem_size * n);
+  else
+    fb_prepend (b, 0, MAX (align, 4));
+  return fb_prepend_int (b, n, 4);
+}
+
+/* Adds to B a vector of N references to the objects in OFFSETS, and returns
+   its offset. */
+uint32_t
+fb_create_offset_vector (struct fb_builder *b,
+                         const uint32_t *offsets, size_t n)
+{
+  size_t i;
+
+  for (i = n; i-- > 0; )
+    fb_prepend_offset (b, offsets[i]);
+  return fb_prepend_int (b, n, 4);
+}
+
+/* Starts building a table with N_FIELDS fields in B.  Only one table may be
+   under construction at a time, so any objects to which the table refers
+   must be created before calling this function. */
+void
+fb_start_table (struct fb_builder *b, size_t n_fields)
+{
+  assert (!b->in_table);
+  b->in_table = true;
+  b->table_start = b->size;
+
+  if (n_fields > b->allocated_fields)
+    {
+      b->allocated_fields = n_fields;
+      b->fields = xnrealloc (b->fields, n_fields, sizeof *b->fields);
+    }
+  memset (b->fields, 0, n_fields * sizeof *b->fields);
+  b->n_fields = n_fields;
+}
+
+static void
+fb_add_int (struct fb_builder *b, int field, uint64_t x, size_t n)
+{
+  assert (b->in_table);
+  assert (field >= 0 && field < b->n_fields);
+  b->fields[field] = fb_prepend_int (b, x, n);
+}
+
+/* Sets FIELD in the table under construction in B to boolean value X. */
+void
+fb_add_bool (struct fb_builder *b, int field, bool x)
+{
+  fb_add_int (b, field, x, 1);
+}
+
+/* Sets FIELD in the table under construction in B to byte X.  This is also
+   the right function for enums with "ubyte" as their underlying type,
+   including union type fields. */
+void
+fb_add_u8 (struct fb_builder *b, int field, uint8_t x)
+{
+  fb_add_int (b, field, x, 1);
+}
+
+/* Sets FIELD in the table under construction in B to 16-bit integer X. */
+void
+fb_add_i16 (struct fb_builder *b, int field, int16_t x)
+{
+  fb_add_int (b, field, (uint16_t) x, 2);
+}
+
+/* Sets FIELD in the table under construction in B to 32-bit integer X. */
+void
+fb_add_i32 (struct fb_builder *b, int field, int32_t x)
+{
+  fb_add_int (b, field, (uint32_t) x, 4);
+}
+
+/* Sets FIELD in the table under construction in B to 64-bit integer X. */
+void
+fb_add_i64 (struct fb_builder *b, int field, int64_t x)
+{
+  fb_add_int (b, field, (uint64_t) x, 8);
+}
+
+/* Sets FIELD in the table under construction in B to refer to the object at
+   OFFSET.  If OFFSET is 0, the field is left absent. */
+void
+fb_add_offset (struct fb_builder *b, int field, uint32_t offset)
+{
+  assert (b->in_table);
+  assert (field >= 0 && field < b->n_fields);
+  if (offset != 0)
+    b->fields[field] = fb_prepend_offset (b, offset);
+}
+
+/* Finishes the table under construction in B, and returns its offset. */
+uint32_t
+fb_end_table (struct fb_builder *b)
+{
+  uint32_t table, vtable;
+  size_t n_fields;
+  uint8_t *p;
+  size_t i;
+
+  assert (b->in_table);
+  b->in_table = false;
+
+  /* Placeholder for the offset to the vtable. */
+  fb_prepend (b, 4, 4);
+  table = b->size;
+
+  /* Trailing absent fields need not appear in the vtable. */
+  n_fields = b->n_fields;
+  while (n_fields > 0 && b->fields[n_fields - 1] == 0)
+    n_fields--;
+
+  /* The vtable consists of its own size in bytes, the size of the table in
+     bytes, and the offset of each field from the start of the table. */
+  p = fb_prepend (b, 4 + 2 * n_fields, 2);
+  integer_put (4 + 2 * n_fields, INTEGER_LSB_FIRST, p, 2);
+  integer_put (table - b->table_start, INTEGER_LSB_FIRST, p + 2, 2);
+  for (i = 0; i < n_fields; i++)
+    integer_put (b->fields[i] ? table - b->fields[i] : 0,
+                 INTEGER_LSB_FIRST, p + 4 + 2 * i, 2);
+  vtable = b->size;
+
+  /* The vtable precedes the table, so the signed offset from the table back
+   to its vtable is positive. */
+  integer_put (vtable - table, INTEGER_LSB_FIRST, fb_at (b, table), 4);
+
+  return table;
+}
+
+/* Finishes the flatbuffer in B, with ROOT as its root table.  Stores the
+   flatbuffer's size in *SIZEP and returns a pointer to its data, which
+   remains owned by B and is valid until B is next modified. */
+const void *
+fb_finish (struct fb_builder *b, uint32_t root, size_t *sizep)
+{
+  /* Pad so that the data as a whole is suitably aligned. */
+  if ((b->size + 4) % b->max_align)
+    fb_prepend (b, b->max_align - (b->size + 4) % b->max_align, 1);
+  fb_prepend_offset (b, root);
+
+  *sizep = b->size;
+  return fb_at (b, b->size);
+}
+
+/* Returns the N-byte little-endian unsigned integer at offset OFS in the
+   SIZE-byte flatbuffer DATA, or DEF if it would extend past the end of the
+   flatbuffer. */
+static uint64_t
+fb_get_uint (const uint8_t *data, size_t size, size_t ofs, size_t n,
+             uint64_t def)
+{
+  return (ofs <= size && n <= size - ofs
+          ? integer_get (INTEGER_LSB_FIRST, data + ofs, n)
+          : def);
+}
+
+/* Initializes TABLE as the table at offset OFS in the SIZE-byte flatbuffer
+   DATA.  Returns true if successful, false if the table or its vtable is
+   outside the flatbuffer's bounds. */
+static bool
+fb_table_init (struct fb_table *table, const uint8_t *data, size_t size,
+               size_t ofs)
+{
+  int32_t vtable_ofs;
+  int64_t vtable;
+  size_t vtable_size;
+
+  if (ofs > size || size - ofs < 4)
+    return false;
+  vtable_ofs = integer_get (INTEGER_LSB_FIRST, data + ofs, 4);
+  vtable = (int64_t) ofs - vtable_ofs;
+  if (vtable < 0 || vtable > size || size - vtable < 4)
+    return false;
+  vtable_size = integer_get (INTEGER_LSB_FIRST, data + vtable, 2);
+  if (vtable_size < 4 || vtable_size > size - vtable)
+    return false;
+
+  table->data = data;
+  table->size = size;
+  table->ofs = ofs;
+  table->vtable = vtable;
+  table->n_fields = (vtable_size - 4) / 2;
+  return true;
+}
+
+/* Initializes ROOT as the root table of the SIZE-byte flatbuffer in DATA.
+   Returns true if successful, false if DATA is not a valid flatbuffer. */
+bool
+fb_get_root (const void *data_, size_t size, struct fb_table *root)
+{
+  const uint8_t *data = data_;
+
+  return (size >= 4
+          && fb_table_init (root, data, size,
+                            integer_get (INTEGER_LSB_FIRST, data, 4)));
+}
+
+/* Returns the offset of FIELD within the flatbuffer that contains TABLE, or
+   0 if FIELD is absent. */
+static size_t
+fb_field_ofs (const struct fb_table *table, int field)
+{
+  size_t ofs;
+
+  if (field < 0 || field >= table->n_fields)
+    return 0;
+  ofs = integer_get (INTEGER_LSB_FIRST,
+                     table->data + table->vtable + 4 + 2 * field, 2);
+  return ofs ? table->ofs + ofs : 0;
+}
+
+/* Returns true if FIELD is present in TABLE, false otherwise. */
+bool
+fb_has_field (const struct fb_table *table, int field)
+{
+  return fb_field_ofs (table, field) != 0;
+}
+
+static uint64_t
+fb_get_int (const struct fb_table *table, int field, size_t n, uint64_t def)
+{
+  size_t ofs = fb_field_ofs (table, field);
+  return ofs ? fb_get_uint (table->data, table->size, ofs, n, def) : def;
+}
+
+/* Returns the value of boolean FIELD in TABLE, or DEF if it is absent. */
+bool
+fb_get_bool (const struct fb_table *table, int field, bool def)
+{
+  return fb_get_int (table, field, 1, def) != 0;
+}
+
+/* Returns the value of byte FIELD in TABLE, or DEF if it is absent.  This
+   is also the right function for enums with "ubyte" as their underlying
+   type, including union type fields. */
+uint8_t
+fb_get_u8 (const struct fb_table *table, int field, uint8_t def)
+{
+  return fb_get_int (table, field, 1, def);
+}
+
+/* Returns the value of 16-bit integer FIELD in TABLE, or DEF if it is
+   absent. */
+int16_t
+fb_get_i16 (const struct fb_table *table, int field, int16_t def)
+{
+  return fb_get_int (table, field, 2, (uint16_t) def);
+}
+
+/* Returns the value of 32-bit integer FIELD in TABLE, or DEF if it is
+   absent. */
+int32_t
+fb_get_i32 (const struct fb_table *table, int field, int32_t def)
+{
+  return fb_get_int (table, field, 4, (uint32_t) def);
+}
+
+/* Returns the value of 64-bit integer FIELD in TABLE, or DEF if it is
+   absent. */
+int64_t
+fb_get_i64 (const struct fb_table *table, int field, int64_t def)
+{
+  return fb_get_int (table, field, 8, (uint64_t) def);
+}
+
+/* Returns the offset of the object to which the reference at offset OFS in
+   the SIZE-byte flatbuffer DATA refers, or 0 if the reference is invalid. */
+static size_t
+fb_deref (const uint8_t *data, size_t size, size_t ofs)
+{
+  uint64_t target = ofs + fb_get_uint (data, size, ofs, 4, size);
+  return target < size ? target : 0;
+}
+
+/* Initializes SUBTABLE as the table referred to by FIELD in TABLE.  Returns
+   true if successful, false if FIELD is absent or invalid. */
+bool
+fb_get_table (const struct fb_table *table, int field,
+              struct fb_table *subtable)
+{
+  size_t ofs = fb_field_ofs (table, field);
+  size_t target = ofs ? fb_deref (table->data, table->size, ofs) : 0;
+  return target && fb_table_init (subtable, table->data, table->size, target);
+}
+
+/* Initializes VECTOR as the vector of ELEM_SIZE-byte elements referred to by
+   FIELD in TABLE.  Returns true if successful, false if FIELD is absent or
+   invalid. */
+bool
+fb_get_vector (const struct fb_table *table, int field, size_t elem_size,
+               struct fb_vector *vector)
+{
+  size_t ofs = fb_field_ofs (table, field);
+  size_t target = ofs ? fb_deref (table->data, table->size, ofs) : 0;
+  uint64_t n;
+
+  if (!target || table->size - target < 4)
+    return false;
+  n = integer_get (INTEGER_LSB_FIRST, table->data + target, 4);
+  if (n * elem_size > table->size - target - 4)
+    return false;
+
+  vector->data = table->data;
+  vector->size = table->size;
+  vector->ofs = target + 4;
+  vector->elem_size = elem_size;
+  vector->n = n;
+  return true;
+}
+
+/* Stores the address and length of the string referred to by FIELD in TABLE
+   into *S and *LENGTH.  The string is not necessarily null-terminated.
+   Returns true if successful, false if FIELD is absent or invalid. */
+bool
+fb_get_string (const struct fb_table *table, int field,
+               const char **s, size_t *length)
+{
+  struct fb_vector vector;
+
+  if (!fb_get_vector (table, field, 1, &vector))
+    return false;
+  *s = CHAR_CAST (const char *, vector.data + vector.ofs);
+  *length = vector.n;
+  return true;
+}
+
+/* Returns the address of element IDX in VECTOR, which must be less than the
+   number of elements in VECTOR. */
+const uint8_t *
+fb_vector_at (const struct fb_vector *vector, size_t idx)
+{
+  assert (idx < vector->n);
+  return vector->data + vector->ofs + idx * vector->elem_size;
+}
+
+/* Initializes TABLE as the table referred to by element IDX in VECTOR, which
+   must be a vector of tables.  Returns true if successful, false if the
+   element is invalid. */
+bool
+fb_vector_get_table (const struct fb_vector *vector, size_t idx,
+                     struct fb_table *table)
+{
+  size_t target;
+
+  assert (vector->elem_size == 4);
+  target = fb_deref (vector->data, vector->size,
+                     vector->ofs + idx * vector->elem_size);
+  return target && fb_table_init (table, vector->data, vector->size, target);
+}
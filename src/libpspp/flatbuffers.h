@@ -0,0 +1,122 @@
+/* PSPP - a program for statistical analysis.
+   Copyright (C) 2017 Free Software Foundation, Inc.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+#ifndef LIBPSPP_FLATBUFFERS_H
+#define LIBPSPP_FLATBUFFERS_H 1
+
+/* Minimal support for the FlatBuffers binary serialization format.
+
+   FlatBuffers is the metadata encoding used by Apache Arrow.  This module
+   implements only what PSPP needs to read and write such metadata, without
+   any dependency on a schema compiler: the caller builds or examines tables
+   field by field, using the field numbers from the schema.
+
+   A flatbuffer is built "back to front": every object (table, vector,
+   string) must be fully built before any object that refers to it.  Each
+   finished object is identified by an "offset", a nonzero value that may be
+   stored into later objects.  All multibyte values are written in
+   little-endian byte order, as the format requires.
+
+   Reading a flatbuffer, on the other hand, does not require copying it or
+   building any data structure: struct fb_table and struct fb_vector simply
+   point into the flatbuffer's data.  Every access is checked against the
+   flatbuffer's bounds, so that it is safe to read untrusted data. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Building flatbuffers. */
+
+struct fb_builder
+  {
+    uint8_t *buf;               /* Data is at the end of this buffer. */
+    size_t size;                /* Number of bytes of data. */
+    size_t allocated;           /* Number of bytes allocated for 'buf'. */
+    size_t max_align;           /* Maximum alignment required so far. */
+
+    /* Table under construction. */
+    bool in_table;              /* Between fb_start_table(), fb_end_table()? */
+    size_t table_start;         /* 'size' when table was started. */
+    uint32_t *fields;           /* Location of each field, 0 if absent. */
+    size_t n_fields, allocated_fields;
+  };
+
+void fb_builder_init (struct fb_builder *);
+void fb_builder_uninit (struct fb_builder *);
+void fb_builder_clear (struct fb_builder *);
+
+/* Strings and vectors. */
+uint32_t fb_create_string (struct fb_builder *, const char *);
+uint32_t fb_create_vector (struct fb_builder *, const void *elems,
+                           size_t elem_size, size_t n, size_t align);
+uint32_t fb_create_offset_vector (struct fb_builder *,
+                                  const uint32_t *offsets, size_t n);
+
+/* Tables. */
+void fb_start_table (struct fb_builder *, size_t n_fields);
+void fb_add_bool (struct fb_builder *, int field, bool);
+void fb_add_u8 (struct fb_builder *, int field, uint8_t);
+void fb_add_i16 (struct fb_builder *, int field, int16_t);
+void fb_add_i32 (struct fb_builder *, int field, int32_t);
+void fb_add_i64 (struct fb_builder *, int field, int64_t);
+void fb_add_offset (struct fb_builder *, int field, uint32_t offset);
+uint32_t fb_end_table (struct fb_builder *);
+
+/* Finishing. */
+const void *fb_finish (struct fb_builder *, uint32_t root, size_t *sizep);
+
+/* Reading flatbuffers. */
+
+/* A table within a flatbuffer. */
+struct fb_table
+  {
+    const uint8_t *data;        /* Entire flatbuffer. */
+    size_t size;                /* Number of bytes in 'data'. */
+    size_t ofs;                 /* Offset of table within 'data'. */
+    size_t vtable;              /* Offset of table's vtable within 'data'. */
+    size_t n_fields;            /* Number of fields in vtable. */
+  };
+
+/* A vector within a flatbuffer. */
+struct fb_vector
+  {
+    const uint8_t *data;        /* Entire flatbuffer. */
+    size_t size;                /* Number of bytes in 'data'. */
+    size_t ofs;                 /* Offset of first element within 'data'. */
+    size_t elem_size;           /* Number of bytes in each element. */
+    size_t n;                   /* Number of elements. */
+  };
+
+bool fb_get_root (const void *data, size_t size, struct fb_table *);
+
+bool fb_has_field (const struct fb_table *, int field);
+bool fb_get_bool (const struct fb_table *, int field, bool def);
+uint8_t fb_get_u8 (const struct fb_table *, int field, uint8_t def);
+int16_t fb_get_i16 (const struct fb_table *, int field, int16_t def);
+int32_t fb_get_i32 (const struct fb_table *, int field, int32_t def);
+int64_t fb_get_i64 (const struct fb_table *, int field, int64_t def);
+bool fb_get_table (const struct fb_table *, int field, struct fb_table *);
+bool fb_get_string (const struct fb_table *, int field,
+                    const char **s, size_t *length);
+bool fb_get_vector (const struct fb_table *, int field, size_t elem_size,
+                    struct fb_vector *);
+
+const uint8_t *fb_vector_at (const struct fb_vector *, size_t idx);
+bool fb_vector_get_table (const struct fb_vector *, size_t idx,
+                          struct fb_table *);
+
+#endif /* libpspp/flatbuffers.h */
@@ -54,11 +54,20 @@ struct converter
   char *fromcode;
   iconv_t conv;
   int null_char_width;
+
+  /* True if CONV converts every ASCII character other than the null
+     character to itself, so that text consisting only of such characters
+     may be copied without calling iconv(). */
+  bool ascii_identity;
 };
 
 static char *default_encoding;
 static struct hmapx map;
 
+static ssize_t try_recode (struct converter *, char fallbackchar,
+                           const char *in, size_t inbytes,
+                           char *out, size_t outbytes);
+
 /* A wrapper around iconv_open */
 static struct converter *
 create_iconv (const char* tocode, const char* fromcode)
@@ -79,7 +88,7 @@ create_iconv (const char* tocode, const char* fromcode)
 	return converter;
     }
 
-  converter = xmalloc (sizeof *converter);
+  converter = xzalloc (sizeof *converter);
   converter->tocode = xstrdup (tocode);
   converter->fromcode = xstrdup (fromcode);
   converter->conv = iconv_open (tocode, fromcode);
@@ -121,6 +130,20 @@ create_iconv (const char* tocode, const char* fromcode)
       iconv_close (bconv);
     }
 
+  /* Find out whether ASCII text passes through unchanged. */
+  if (converter->conv != (iconv_t) -1 && converter->null_char_width == 1)
+    {
+      char ascii[127], out[128];
+      ssize_t n;
+      size_t i;
+
+      for (i = 0; i < sizeof ascii; i++)
+        ascii[i] = i + 1;
+      n = try_recode (converter, 0, ascii, sizeof ascii, out, sizeof out);
+      converter->ascii_identity = (n == (ssize_t) sizeof ascii
+                                   && !memcmp (ascii, out, sizeof ascii));
+    }
+
   hmapx_insert (&map, converter, hash);
 
   return converter;
@@ -164,6 +187,23 @@ recode_string_len (const char *to, const char *from,
   return len;
 }
 
+/* Returns true if TEXT consists only of ASCII characters other than the null
+   character and escape.  (ISO-2022-JP converts each ASCII character to itself
+   but uses escape sequences to switch to other character sets.) */
+static bool
+is_plain_ascii (struct substring text)
+{
+  size_t i;
+
+  for (i = 0; i < text.length; i++)
+    {
+      unsigned char c = text.string[i];
+      if (c == 0 || c >= 128 || c == 0x1b)
+        return false;
+    }
+  return true;
+}
+
 /* Uses CONV to convert the INBYTES starting at IP into the OUTBYTES starting
    at OP, and appends a null terminator to the output.
 
@@ -577,6 +617,16 @@ recode_substring_pool__ (const char *to, const char *from,
         return EPROTO;
     }
 
+  if (conv->ascii_identity && is_plain_ascii (text))
+    {
+      /* Fast path: nothing to convert. */
+      out->string = pool_malloc (pool, text.length + 1);
+      out->length = text.length;
+      memcpy (out->string, text.string, text.length);
+      out->string[out->length] = '\0';
+      return 0;
+    }
+
   for (bufsize = text.length + 1; bufsize > text.length; bufsize *= 2)
     {
       char *output = pool_malloc (pool, bufsize);
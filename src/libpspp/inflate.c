@@ -27,67 +27,101 @@
 
 #include "str.h"
 
+#include "gl/glthread/lock.h"
+
 #include "gettext.h"
 #define _(msgid) gettext (msgid)
 #define N_(msgid) (msgid)
 
-#define UCOMPSIZE 4096
+/* Size of the buffer for compressed input.  Reading the compressed data in
+   large blocks, and inflating as much of it per call as the caller has room
+   for, keeps the number of calls into stdio and zlib small. */
+#define UCOMPSIZE 65536
 
 struct inflator
 {
   z_stream zss;
-  int state;
   unsigned char ucomp[UCOMPSIZE];
-  size_t bytes_uncomp;
   size_t ucomp_bytes_read;
-
-  /* Two bitfields as defined by RFC1950 */
-  uint16_t cmf_flg ;
+  bool eof;                     /* Reached end of compressed stream? */
 };
 
+/* Idle inflators.
+
+   Initializing a zlib stream allocates its state and its 32 kB window, and
+   an inflator also has a large input buffer, so instead of freeing inflators
+   we keep a few of them here, ready to be reset and reused by the next
+   member to be opened.  This matters for readers, such as the ODS reader,
+   that open several members of an archive, or the same member several
+   times. */
+#define MAX_IDLE_INFLATORS 4
+static struct inflator *idle_inflators[MAX_IDLE_INFLATORS];
+static int n_idle_inflators;
+gl_lock_define_initialized (static, idle_inflators_lock)
+
 void
 inflate_finish (struct zip_member *zm)
 {
   struct inflator *inf = zm->aux;
 
-  inflateEnd (&inf->zss);
+  if (inf == NULL)
+    return;
+  zm->aux = NULL;
 
-  free (inf);
+  gl_lock_lock (idle_inflators_lock);
+  if (n_idle_inflators < MAX_IDLE_INFLATORS)
+    {
+      idle_inflators[n_idle_inflators++] = inf;
+      inf = NULL;
+    }
+  gl_lock_unlock (idle_inflators_lock);
+
+  if (inf != NULL)
+    {
+      inflateEnd (&inf->zss);
+      free (inf);
+    }
 }
 
 bool
 inflate_init (struct zip_member *zm)
 {
+  struct inflator *inf = NULL;
   int r;
-  struct inflator *inf = xzalloc (sizeof *inf);
-
-  uint16_t flg = 0 ;
-  uint16_t cmf = 0x8; /* Always 8 for inflate */
-
-  const uint16_t cinfo = 7;  /* log_2(Window size) - 8 */
-
-  cmf |= cinfo << 4;     /* Put cinfo into the high nibble */
 
-  /* make these into a 16 bit word */
-  inf->cmf_flg = (cmf << 8 ) | flg;
+  gl_lock_lock (idle_inflators_lock);
+  if (n_idle_inflators > 0)
+    inf = idle_inflators[--n_idle_inflators];
+  gl_lock_unlock (idle_inflators_lock);
 
-  /* Set the check bits */
-  inf->cmf_flg += 31 - (inf->cmf_flg % 31);
-  assert (inf->cmf_flg % 31 == 0);
-
-  inf->zss.next_in = Z_NULL;
-  inf->zss.avail_in = 0;
-  inf->zss.zalloc = Z_NULL;
-  inf->zss.zfree  = Z_NULL;
-  inf->zss.opaque = Z_NULL;
-  r = inflateInit (&inf->zss);
+  if (inf != NULL)
+    r = inflateReset (&inf->zss);
+  else
+    {
+      inf = xmalloc (sizeof *inf);
+      inf->zss.zalloc = Z_NULL;
+      inf->zss.zfree  = Z_NULL;
+      inf->zss.opaque = Z_NULL;
+      inf->zss.next_in = Z_NULL;
+      inf->zss.avail_in = 0;
+
+      /* Zip members are raw deflate streams, without the zlib header and
+         trailer, which a negative window size tells zlib to expect. */
+      r = inflateInit2 (&inf->zss, -MAX_WBITS);
+    }
 
   if ( Z_OK != r)
     {
       ds_put_format (zm->errs, _("Cannot initialize inflator: %s"), zError (r));
+      free (inf);
       return false;
     }
 
+  inf->zss.next_in = inf->ucomp;
+  inf->zss.avail_in = 0;
+  inf->ucomp_bytes_read = 0;
+  inf->eof = false;
+
   zm->aux = inf;
 
   return true;
@@ -97,49 +131,42 @@ inflate_init (struct zip_member *zm)
 int
 inflate_read (struct zip_member *zm, void *buf, size_t n)
 {
-  int r;
   struct inflator *inf = zm->aux;
 
-  if (inf->zss.avail_in == 0)
-    {
-      int bytes_read;
-      int bytes_to_read;
-      int pad = 0;
-
-      if ( inf->state == 0)
-	{
-	  inf->ucomp[1] = inf->cmf_flg ;
-      	  inf->ucomp[0] = inf->cmf_flg >> 8 ;
-
-	  pad = 2;
-	  inf->state++;
-	}
-
-      bytes_to_read = zm->comp_size - inf->ucomp_bytes_read;
-
-      if (bytes_to_read == 0)
-	return 0;
-
-      if (bytes_to_read > UCOMPSIZE)
-	bytes_to_read = UCOMPSIZE;
-
-      bytes_read = fread (inf->ucomp + pad, 1, bytes_to_read - pad, zm->fp);
-
-      inf->ucomp_bytes_read += bytes_read;
-
-      inf->zss.avail_in = bytes_read + pad;
-      inf->zss.next_in = inf->ucomp;
-    }
   inf->zss.avail_out = n;
   inf->zss.next_out = buf;
-
-  r = inflate (&inf->zss, Z_NO_FLUSH);
-  if ( Z_OK == r)
+  while (inf->zss.avail_out > 0 && !inf->eof)
     {
-      return n - inf->zss.avail_out;
+      int r;
+
+      if (inf->zss.avail_in == 0 && inf->ucomp_bytes_read < zm->comp_size)
+        {
+          size_t bytes_to_read = zm->comp_size - inf->ucomp_bytes_read;
+          size_t bytes_read;
+
+          if (bytes_to_read > UCOMPSIZE)
+            bytes_to_read = UCOMPSIZE;
+
+          bytes_read = fread (inf->ucomp, 1, bytes_to_read, zm->fp);
+          inf->ucomp_bytes_read += bytes_read;
+
+          inf->zss.avail_in = bytes_read;
+          inf->zss.next_in = inf->ucomp;
+        }
+
+      /* Even without new input, zlib may have output left over from the
+         previous call, so always give it a chance to produce it. */
+      r = inflate (&inf->zss, Z_NO_FLUSH);
+      if (r == Z_STREAM_END)
+        inf->eof = true;
+      else if (r == Z_BUF_ERROR && inf->zss.avail_in == 0)
+        break;                  /* Compressed data is truncated. */
+      else if (r != Z_OK)
+        {
+          ds_put_format (zm->errs, _("Error inflating: %s"), zError (r));
+          return -1;
+        }
     }
 
-  ds_put_format (zm->errs, _("Error inflating: %s"), zError (r));
-
-  return -1;
+  return n - inf->zss.avail_out;
 }
@@ -4,6 +4,8 @@ check_PROGRAMS += \
 	tests/data/datasheet-test \
 	tests/data/sack \
 	tests/data/inexactify \
+	tests/data/num-in-bench \
+	tests/data/por-bench \
 	tests/language/lexer/command-name-test \
 	tests/language/lexer/scan-test \
 	tests/language/lexer/segment-test \
@@ -49,6 +51,16 @@ tests_data_sack_SOURCES = \
 tests_data_sack_LDADD = src/libpspp-core.la 
 tests_data_sack_CFLAGS = $(AM_CFLAGS)
 
+tests_data_num_in_bench_SOURCES = \
+	tests/data/num-in-bench.c
+tests_data_num_in_bench_LDADD = src/libpspp-core.la
+tests_data_num_in_bench_CFLAGS = $(AM_CFLAGS)
+
+tests_data_por_bench_SOURCES = \
+	tests/data/por-bench.c
+tests_data_por_bench_LDADD = src/libpspp-core.la
+tests_data_por_bench_CFLAGS = $(AM_CFLAGS)
+
 tests_libpspp_line_reader_test_SOURCES = tests/libpspp/line-reader-test.c
 tests_libpspp_line_reader_test_LDADD = src/libpspp/liblibpspp.la gl/libgl.la
 
@@ -260,7 +272,8 @@ EXTRA_DIST += \
 	tests/language/data-io/Book1.gnm.unzipped \
 	tests/language/data-io/test.ods \
 	tests/language/data-io/newone.ods \
-	tests/language/stats/llz.zsav
+	tests/language/stats/llz.zsav \
+	tests/language/xforms/recode-bench.pl
 
 CLEANFILES += *.save pspp.* foo*
 
@@ -297,6 +310,7 @@ TESTSUITE_AT = \
 	tests/language/data-io/data-reader.at \
 	tests/language/data-io/dataset.at \
 	tests/language/data-io/file-handle.at \
+	tests/language/data-io/get-data-arrow.at \
 	tests/language/data-io/get-data-spreadsheet.at \
 	tests/language/data-io/get-data-psql.at \
 	tests/language/data-io/get-data-txt.at \
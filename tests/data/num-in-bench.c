@@ -0,0 +1,163 @@
+/* PSPP - a program for statistical analysis.
+   Copyright (C) 2017 Free Software Foundation, Inc.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+/* Microbenchmark for numeric input.
+
+   Reads lines of numeric input from stdin, such as the num-in.data corpus
+   generated by tests/data/data-in.at, and parses each of them with
+   data_in() as F, COMMA, and DOT formats, ITERATIONS times over (100 by
+   default), reporting the time per field.
+
+   Each format is timed twice.  The first time, the input encoding is
+   UTF-8, which allows data_in() to parse plain decimal numbers without
+   recoding them, through its fast path.  The second time, the input
+   encoding is ANSI_X3.4-1968, a name for ASCII that data_in() does not
+   recognize, so that every field goes through iconv and the general
+   parser, as before the fast path was added.  The results must be
+   identical; if they are not, the program reports the difference and
+   exits with a failure status. */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "data/data-in.h"
+#include "data/format.h"
+#include "data/settings.h"
+#include "data/value.h"
+#include "libpspp/i18n.h"
+#include "libpspp/str.h"
+
+#include "gl/progname.h"
+#include "gl/xalloc.h"
+
+/* The result of parsing one input. */
+struct result
+  {
+    double f;                   /* Parsed value. */
+    bool error;                 /* Did data_in() report an error? */
+  };
+
+/* Parses the N_INPUTS INPUTS as FORMAT in the given ENCODING, N_ITERATIONS
+   times over, storing the results of the final iteration into RESULTS.
+   Returns the elapsed CPU time in seconds. */
+static double
+time_data_in (const struct substring *inputs, size_t n_inputs,
+              enum fmt_type format, const char *encoding,
+              int n_iterations, struct result *results)
+{
+  clock_t start = clock ();
+  int iteration;
+  size_t i;
+
+  for (iteration = 0; iteration < n_iterations; iteration++)
+    for (i = 0; i < n_inputs; i++)
+      {
+        union value value;
+        char *error;
+
+        error = data_in (inputs[i], encoding, format, &value, 0, NULL);
+        results[i].f = value.f;
+        results[i].error = error != NULL;
+        free (error);
+      }
+
+  return (double) (clock () - start) / CLOCKS_PER_SEC;
+}
+
+int
+main (int argc, char *argv[])
+{
+  static const enum fmt_type formats[] = { FMT_F, FMT_COMMA, FMT_DOT };
+  struct string line = DS_EMPTY_INITIALIZER;
+  struct substring *inputs = NULL;
+  size_t n_inputs = 0, allocated_inputs = 0;
+  struct result *fast, *general;
+  int n_iterations;
+  int status = EXIT_SUCCESS;
+  size_t i, j;
+
+  set_program_name (argv[0]);
+  i18n_init ();
+  settings_init ();
+
+  n_iterations = argc > 1 ? atoi (argv[1]) : 100;
+  if (n_iterations < 1)
+    {
+      fprintf (stderr, "usage: %s [ITERATIONS] < INPUT\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+
+  while (ds_read_line (&line, stdin, SIZE_MAX))
+    {
+      ds_chomp_byte (&line, '\n');
+      if (n_inputs >= allocated_inputs)
+        inputs = x2nrealloc (inputs, &allocated_inputs, sizeof *inputs);
+      ss_alloc_substring (&inputs[n_inputs++], ds_ss (&line));
+      ds_clear (&line);
+    }
+  ds_destroy (&line);
+  if (n_inputs == 0)
+    {
+      fprintf (stderr, "%s: no input\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+
+  fast = xnmalloc (n_inputs, sizeof *fast);
+  general = xnmalloc (n_inputs, sizeof *general);
+  for (i = 0; i < sizeof formats / sizeof *formats; i++)
+    {
+      enum fmt_type format = formats[i];
+      double fast_time, general_time;
+      double n_fields = (double) n_inputs * n_iterations;
+
+      fast_time = time_data_in (inputs, n_inputs, format, "UTF-8",
+                                n_iterations, fast);
+      general_time = time_data_in (inputs, n_inputs, format,
+                                   "ANSI_X3.4-1968", n_iterations, general);
+      printf ("%-5s  %8.1f ns/field (fast)  %8.1f ns/field (general)"
+              "  %5.2fx\n",
+              fmt_name (format),
+              fast_time * 1e9 / n_fields, general_time * 1e9 / n_fields,
+              fast_time > 0 ? general_time / fast_time : 0.0);
+
+      for (j = 0; j < n_inputs; j++)
+        if (fast[j].error != general[j].error
+            || memcmp (&fast[j].f, &general[j].f, sizeof fast[j].f))
+          {
+            fprintf (stderr, "%s: \"%.*s\" as %s: fast path yields %.17g%s "
+                     "but general path yields %.17g%s\n",
+                     argv[0], (int) inputs[j].length, inputs[j].string,
+                     fmt_name (format),
+                     fast[j].f, fast[j].error ? " (with error)" : "",
+                     general[j].f, general[j].error ? " (with error)" : "");
+            status = EXIT_FAILURE;
+          }
+    }
+
+  for (i = 0; i < n_inputs; i++)
+    ss_dealloc (&inputs[i]);
+  free (inputs);
+  free (fast);
+  free (general);
+  settings_done ();
+  i18n_done ();
+
+  return status;
+}
@@ -0,0 +1,197 @@
+/* PSPP - a program for statistical analysis.
+   Copyright (C) 2017 Free Software Foundation, Inc.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+/* Benchmark for the portable file reader.
+
+   Writes a synthetic portable file named FILE with N_CASES cases of N_VARS
+   numeric variables and one string variable, then reads it back, reporting
+   the time taken for each step and the rate at which the file was read.
+   Passing a large N_CASES, e.g. "por-bench big.por 5000000 100", yields a
+   multi-gigabyte file.
+
+   The numeric values are integers, with an occasional system-missing value,
+   so that they survive the trip through the file exactly.  If any value
+   read back differs from the value written, the program reports the
+   difference and exits with a failure status. */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include "data/any-reader.h"
+#include "data/case.h"
+#include "data/casereader.h"
+#include "data/casewriter.h"
+#include "data/dictionary.h"
+#include "data/file-handle-def.h"
+#include "data/format.h"
+#include "data/por-file-writer.h"
+#include "data/settings.h"
+#include "data/value.h"
+#include "data/variable.h"
+#include "libpspp/i18n.h"
+
+#include "gl/progname.h"
+
+/* Width of the string variable. */
+#define STRING_WIDTH 12
+
+/* Returns the value of numeric variable VAR in case CASE. */
+static double
+numeric_value (long long int case_idx, int var)
+{
+  unsigned long long int x = case_idx * 7919 + var * 104729;
+  return x % 17 == 0 ? SYSMIS : (double) (x % 2000001) - 1000000;
+}
+
+/* Stores the value of the string variable in case CASE into S. */
+static void
+string_value (long long int case_idx, uint8_t s[STRING_WIDTH])
+{
+  char buf[STRING_WIDTH + 1];
+
+  snprintf (buf, sizeof buf, "case %-7lld", case_idx % 10000000);
+  memcpy (s, buf, STRING_WIDTH);
+}
+
+static double
+elapsed (clock_t start)
+{
+  return (double) (clock () - start) / CLOCKS_PER_SEC;
+}
+
+int
+main (int argc, char *argv[])
+{
+  struct dictionary *dict, *read_dict;
+  struct file_handle *fh;
+  struct casewriter *writer;
+  struct casereader *reader;
+  struct ccase *c;
+  long long int n_cases, i;
+  double write_time, read_time, mb;
+  clock_t start;
+  struct stat s;
+  int n_vars, j;
+  int status = EXIT_SUCCESS;
+
+  set_program_name (argv[0]);
+  i18n_init ();
+  fh_init ();
+  settings_init ();
+
+  if (argc != 4
+      || (n_cases = atoll (argv[2])) < 0
+      || (n_vars = atoi (argv[3])) < 1)
+    {
+      fprintf (stderr, "usage: %s FILE N_CASES N_VARS\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+
+  dict = dict_create ("UTF-8");
+  for (j = 0; j < n_vars; j++)
+    {
+      char name[32];
+      struct fmt_spec f = fmt_for_output (FMT_F, 8, 0);
+      struct variable *v;
+
+      sprintf (name, "v%d", j);
+      v = dict_create_var_assert (dict, name, 0);
+      var_set_both_formats (v, &f);
+    }
+  dict_create_var_assert (dict, "s", STRING_WIDTH);
+
+  fh = fh_create_file (NULL, argv[1], NULL, fh_default_properties ());
+
+  /* Write the file. */
+  start = clock ();
+  writer = pfm_open_writer (fh, dict, pfm_writer_default_options ());
+  if (writer == NULL)
+    return EXIT_FAILURE;
+  for (i = 0; i < n_cases; i++)
+    {
+      c = case_create (dict_get_proto (dict));
+      for (j = 0; j < n_vars; j++)
+        case_data_rw_idx (c, j)->f = numeric_value (i, j);
+      string_value (i, case_str_rw_idx (c, n_vars));
+      casewriter_write (writer, c);
+    }
+  if (!casewriter_destroy (writer))
+    return EXIT_FAILURE;
+  write_time = elapsed (start);
+  mb = stat (argv[1], &s) == 0 ? s.st_size / 1e6 : 0.0;
+
+  /* Read it back. */
+  start = clock ();
+  reader = any_reader_open_and_decode (fh, NULL, &read_dict, NULL);
+  if (reader == NULL)
+    return EXIT_FAILURE;
+  for (i = 0; (c = casereader_read (reader)) != NULL; i++)
+    {
+      uint8_t expected[STRING_WIDTH];
+
+      for (j = 0; j < n_vars; j++)
+        {
+          double f = case_num_idx (c, j);
+          if (f != numeric_value (i, j) && status == EXIT_SUCCESS)
+            {
+              fprintf (stderr, "%s: case %lld, variable %d: read %.17g "
+                       "but wrote %.17g\n",
+                       argv[0], i, j, f, numeric_value (i, j));
+              status = EXIT_FAILURE;
+            }
+        }
+
+      string_value (i, expected);
+      if (memcmp (case_str_idx (c, n_vars), expected, STRING_WIDTH)
+          && status == EXIT_SUCCESS)
+        {
+          fprintf (stderr, "%s: case %lld: read \"%.*s\" but wrote \"%.*s\"\n",
+                   argv[0], i,
+                   STRING_WIDTH, (const char *) case_str_idx (c, n_vars),
+                   STRING_WIDTH, (const char *) expected);
+          status = EXIT_FAILURE;
+        }
+      case_unref (c);
+    }
+  if (!casereader_destroy (reader))
+    status = EXIT_FAILURE;
+  read_time = elapsed (start);
+  if (i != n_cases)
+    {
+      fprintf (stderr, "%s: read %lld cases but wrote %lld\n",
+               argv[0], i, n_cases);
+      status = EXIT_FAILURE;
+    }
+
+  printf ("%.1f MB, %lld cases, %d variables\n", mb, n_cases, n_vars + 1);
+  printf ("write: %8.2f s\n", write_time);
+  printf ("read:  %8.2f s  %8.1f MB/s\n",
+          read_time, read_time > 0 ? mb / read_time : 0.0);
+
+  dict_destroy (dict);
+  dict_destroy (read_dict);
+  fh_unref (fh);
+  fh_done ();
+  settings_done ();
+  i18n_done ();
+
+  return status;
+}
@@ -40,17 +40,21 @@ static void usage (void) NO_RETURN;
 int
 main (int argc, char *argv[])
 {
+  struct command_index ci;
   size_t i;
 
   set_program_name (argv[0]);
   parse_options (argc, argv);
 
+  command_index_init (&ci, (const char *const *) commands, n_commands);
   for (i = 0; i < n_strings; i++)
     {
       const char *string = strings[i];
       struct command_matcher cm;
+      const size_t *candidates;
+      size_t n_candidates;
       const char *best;
-      size_t j;
+      size_t j, k;
 
       if (i > 0)
         putchar ('\n');
@@ -69,6 +73,19 @@ main (int argc, char *argv[])
             printf (" exact=%s missing_words=%d",
                     exact ? "yes" : "no", missing_words);
           putchar ('\n');
+
+          /* The index must yield every command that matches. */
+          if (match)
+            {
+              n_candidates = command_index_lookup (&ci, ss_cstr (string),
+                                                   &candidates);
+              for (k = 0; k < n_candidates; k++)
+                if (candidates[k] == j)
+                  break;
+              if (k >= n_candidates)
+                error (1, 0, "index does not yield \"%s\" for \"%s\"",
+                       command, string);
+            }
         }
 
       command_matcher_init (&cm, ss_cstr (string));
@@ -79,6 +96,7 @@ main (int argc, char *argv[])
               best ? best : "none", command_matcher_get_missing_words (&cm));
       command_matcher_destroy (&cm);
     }
+  command_index_destroy (&ci);
 
   return 0;
 }
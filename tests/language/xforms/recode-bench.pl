@@ -0,0 +1,93 @@
+# PSPP - a program for statistical analysis.
+# Copyright (C) 2017 Free Software Foundation, Inc.
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+# Benchmark for RECODE.
+#
+# Usage: perl recode-bench.pl [PSPP [N_CASES]]
+#
+# Runs PSPP (by default, "pspp" in the PATH) on N_CASES cases (1000000 by
+# default) with RECODE transformations of 10 to 10000 mappings of each
+# kind: integers in a small domain (which RECODE looks up in a dense
+# array), sparse integers and strings (in a hash table), and ranges
+# (found by bisection).  For each, it reports the time per case and per
+# variable taken by RECODE, less the time of a run without RECODE.  The
+# time should barely grow with the number of mappings.
+
+use strict;
+use warnings 'all';
+use Time::HiRes qw(time);
+
+my ($pspp) = $ARGV[0] || 'pspp';
+my ($n_cases) = $ARGV[1] || 1000000;
+my ($n_vars) = 4;
+
+# Returns the syntax for reading the cases, with numeric variables
+# x1...xN with values in [0,DOMAIN) and, if STRINGS is true, string
+# variables s1...sN with the same values in string form.
+sub input_program {
+    my ($domain, $strings) = @_;
+    my ($s) = "INPUT PROGRAM.\n";
+    $s .= "STRING s1 TO s$n_vars (A8).\n" if $strings;
+    $s .= "LOOP #i = 1 TO $n_cases.\n";
+    for my $j (1...$n_vars) {
+	$s .= "COMPUTE x$j = MOD(#i * 7919 + $j * 104729, $domain).\n";
+	$s .= "COMPUTE s$j = STRING(x$j, F8).\n" if $strings;
+    }
+    $s .= "END CASE.\nEND LOOP.\nEND FILE.\nEND INPUT PROGRAM.\n";
+    return $s;
+}
+
+# Returns the time taken by PSPP to run SYNTAX.
+sub run {
+    my ($syntax) = @_;
+    open (my $fh, '>', 'recode-bench.sps') or die "recode-bench.sps: $!\n";
+    print $fh $syntax, "EXECUTE.\n";
+    close ($fh);
+
+    my ($start) = time ();
+    system ($pspp, '-o', 'recode-bench.csv', 'recode-bench.sps') == 0
+      or die "$pspp failed\n";
+    return time () - $start;
+}
+
+printf "%-8s %8s %12s\n", 'kind', 'mappings', 'ns/value';
+for my $kind ('dense', 'hash', 'range', 'string') {
+    for my $n (10, 100, 1000, 10000) {
+	my ($domain) = $kind eq 'hash' ? $n * 1000 : $n * 2;
+	my ($strings) = $kind eq 'string';
+	my ($recode) = $strings ? "RECODE s1 TO s$n_vars" : "RECODE x1 TO x$n_vars";
+	for my $i (0...$n - 1) {
+	    if ($kind eq 'dense') {
+		$recode .= " ($i=" . ($i % 7) . ")";
+	    } elsif ($kind eq 'hash') {
+		$recode .= " (" . ($i * 1000) . "=" . ($i % 7) . ")";
+	    } elsif ($kind eq 'range') {
+		$recode .= " (" . ($i * 2) . " THRU " . ($i * 2 + 1.5)
+		  . "=" . ($i % 7) . ")";
+	    } else {
+		$recode .= sprintf (" ('%8d'='%d')", $i, $i % 7);
+	    }
+	}
+	$recode .= " INTO y1 TO y$n_vars.\n";
+	$recode = "STRING y1 TO y$n_vars (A1).\n$recode" if $strings;
+
+	my ($base) = run (input_program ($domain, $strings));
+	my ($t) = run (input_program ($domain, $strings) . $recode);
+	printf "%-8s %8d %12.1f\n", $kind, $n,
+	  ($t - $base) * 1e9 / ($n_cases * $n_vars);
+    }
+}
+unlink ('recode-bench.sps', 'recode-bench.csv');
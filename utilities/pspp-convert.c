@@ -20,9 +20,16 @@
 #include <getopt.h>
 #include <limits.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/time.h>
 #include <unistd.h>
+#if HAVE_FORK
+#include <sys/wait.h>
+#endif
 
 #include "data/any-reader.h"
+#include "data/arrow-file-writer.h"
 #include "data/casereader.h"
 #include "data/casewriter.h"
 #include "data/csv-file-writer.h"
@@ -41,48 +48,70 @@
 #include "gl/getpass.h"
 #include "gl/progname.h"
 #include "gl/version-etc.h"
+#include "gl/xalloc.h"
 
 #include "gettext.h"
 #define _(msgid) gettext (msgid)
 
+/* Options that apply to every conversion. */
+struct convert_options
+  {
+    long long int max_cases;    /* Maximum number of cases to copy. */
+    const char *encoding;       /* Input encoding, NULL to detect. */
+    const char *output_format;  /* Output format, NULL to use extension. */
+    const char *password;       /* Password for encrypted input, or NULL. */
+    bool report;                /* Report timing for each conversion? */
+  };
+
+/* One input file to convert and the output file to write. */
+struct conversion
+  {
+    char *input_filename;
+    char *output_filename;
+  };
+
 static void usage (void);
 
 static bool decrypt_file (struct encrypted_file *enc,
                           const struct file_handle *input_filename,
                           const struct file_handle *output_filename,
                           const char *password);
+static void read_manifest (const char *manifest_name,
+                           struct conversion **, size_t *n, size_t *allocated);
+static bool run_conversions (const struct conversion *, size_t n, int n_jobs,
+                             const struct convert_options *);
 
 int
 main (int argc, char *argv[])
 {
-  const char *input_filename;
-  const char *output_filename;
-
-  long long int max_cases = LLONG_MAX;
-  struct dictionary *dict = NULL;
-  struct casereader *reader;
-  struct file_handle *input_fh = NULL;
-  const char *encoding = NULL;
-  struct encrypted_file *enc;
-
-  const char *output_format = NULL;
-  struct file_handle *output_fh = NULL;
-  struct casewriter *writer;
-  const char *password = NULL;
-
-  long long int i;
+  struct convert_options options;
+  struct conversion *conversions = NULL;
+  size_t n_conversions = 0, allocated_conversions = 0;
+  const char *manifest_name = NULL;
+  int n_jobs = 1;
+  bool ok;
+  size_t i;
+  int j;
 
   set_program_name (argv[0]);
   i18n_init ();
   fh_init ();
   settings_init ();
 
+  options.max_cases = LLONG_MAX;
+  options.encoding = NULL;
+  options.output_format = NULL;
+  options.password = NULL;
+  options.report = false;
+
   for (;;)
     {
       static const struct option long_options[] =
         {
           { "cases",    required_argument, NULL, 'c' },
           { "encoding", required_argument, NULL, 'e' },
+          { "jobs",     required_argument, NULL, 'j' },
+          { "manifest", required_argument, NULL, 'm' },
           { "password", required_argument, NULL, 'p' },
 
           { "output-format", required_argument, NULL, 'O' },
@@ -94,26 +123,37 @@ main (int argc, char *argv[])
 
       int c;
 
-      c = getopt_long (argc, argv, "c:e:p:O:hv", long_options, NULL);
+      c = getopt_long (argc, argv, "c:e:j:m:p:O:hv", long_options, NULL);
       if (c == -1)
         break;
 
       switch (c)
         {
         case 'c':
-          max_cases = strtoull (optarg, NULL, 0);
+          options.max_cases = strtoull (optarg, NULL, 0);
           break;
 
         case 'e':
-          encoding = optarg;
+          options.encoding = optarg;
+          break;
+
+        case 'j':
+          n_jobs = atoi (optarg);
+          if (n_jobs < 1)
+            error (1, 0, _("%s: number of jobs must be a positive integer"),
+                   optarg);
+          break;
+
+        case 'm':
+          manifest_name = optarg;
           break;
 
         case 'p':
-          password = optarg;
+          options.password = optarg;
           break;
 
         case 'O':
-          output_format = optarg;
+          options.output_format = optarg;
           break;
 
         case 'v':
@@ -126,85 +166,228 @@ main (int argc, char *argv[])
           exit (EXIT_SUCCESS);
 
         default:
-          goto error;
+          exit (EXIT_FAILURE);
         }
     }
 
-  if (optind + 2 != argc)
-    error (1, 0, _("exactly two non-option arguments are required; "
-                   "use --help for help"));
+  if ((argc - optind) % 2 != 0
+      || (manifest_name == NULL && optind == argc))
+    error (1, 0, _("non-option arguments must be pairs of input and output "
+                   "files; use --help for help"));
+
+  for (j = optind; j < argc; j += 2)
+    {
+      struct conversion *conv;
+
+      if (n_conversions >= allocated_conversions)
+        conversions = x2nrealloc (conversions, &allocated_conversions,
+                                  sizeof *conversions);
+      conv = &conversions[n_conversions++];
+      conv->input_filename = xstrdup (argv[j]);
+      conv->output_filename = xstrdup (argv[j + 1]);
+    }
+  if (manifest_name != NULL)
+    read_manifest (manifest_name, &conversions, &n_conversions,
+                   &allocated_conversions);
+
+  options.report = n_conversions > 1 || manifest_name != NULL;
+  ok = run_conversions (conversions, n_conversions, n_jobs, &options);
+
+  for (i = 0; i < n_conversions; i++)
+    {
+      free (conversions[i].input_filename);
+      free (conversions[i].output_filename);
+    }
+  free (conversions);
+  fh_done ();
+  i18n_done ();
+
+  return ok ? 0 : 1;
+}
+
+/* Reads pairs of input and output file names, one pair per line, from
+   MANIFEST_NAME ("-" for stdin) and appends them to *CONVERSIONS.  If a line
+   contains a tab, the tab separates the input and output file names, which
+   may then contain spaces; otherwise, they are separated by white space.
+   Blank lines and lines that begin with "#" are ignored. */
+static void
+read_manifest (const char *manifest_name, struct conversion **conversions,
+               size_t *n, size_t *allocated)
+{
+  char *line = NULL;
+  size_t line_size = 0;
+  int line_number = 0;
+  FILE *file;
+
+  file = (!strcmp (manifest_name, "-")
+          ? stdin
+          : fopen (manifest_name, "r"));
+  if (file == NULL)
+    error (1, errno, _("%s: error opening manifest"), manifest_name);
+
+  while (getline (&line, &line_size, file) > 0)
+    {
+      const char *delimiters = strchr (line, '\t') ? "\t\r\n" : " \t\r\n";
+      char *save_ptr = NULL;
+      char *input, *output;
+      struct conversion *conv;
+
+      line_number++;
+      input = strtok_r (line, delimiters, &save_ptr);
+      if (input == NULL || input[0] == '#')
+        continue;
+      output = strtok_r (NULL, delimiters, &save_ptr);
+      if (output == NULL || strtok_r (NULL, delimiters, &save_ptr) != NULL)
+        error (1, 0, _("%s:%d: each line must contain an input file name "
+                       "and an output file name"),
+               manifest_name, line_number);
+
+      if (*n >= *allocated)
+        *conversions = x2nrealloc (*conversions, allocated,
+                                   sizeof **conversions);
+      conv = &(*conversions)[(*n)++];
+      conv->input_filename = xstrdup (input);
+      conv->output_filename = xstrdup (output);
+    }
+  if (ferror (file))
+    error (1, errno, _("%s: error reading manifest"), manifest_name);
+  if (file != stdin)
+    fclose (file);
+  free (line);
+}
+
+/* Returns the number of seconds from START to now. */
+static double
+seconds_since (const struct timeval *start)
+{
+  struct timeval now;
+
+  gettimeofday (&now, NULL);
+  return ((now.tv_sec - start->tv_sec)
+          + (now.tv_usec - start->tv_usec) / 1000000.0);
+}
+
+/* Returns the size of FILE_NAME in megabytes, or 0 if it cannot be
+   determined. */
+static double
+file_megabytes (const char *file_name)
+{
+  struct stat s;
+
+  return stat (file_name, &s) == 0 ? s.st_size / 1e6 : 0.0;
+}
 
-  input_filename = argv[optind];
-  output_filename = argv[optind + 1];
-  input_fh = fh_create_file (NULL, input_filename, NULL, fh_default_properties ());
+/* Converts INPUT_FILENAME to OUTPUT_FILENAME according to OPTIONS, storing
+   the number of cases copied into *N_CASES.  Returns true if successful,
+   otherwise reports an error and returns false. */
+static bool
+convert_file (const char *input_filename, const char *output_filename,
+              const struct convert_options *options, long long int *n_cases)
+{
+  const char *output_format = options->output_format;
+  struct dictionary *dict = NULL;
+  struct casereader *reader;
+  struct file_handle *input_fh;
+  struct file_handle *output_fh;
+  struct encrypted_file *enc;
+  struct casewriter *writer;
+  bool ok = false;
+  long long int i;
 
+  *n_cases = 0;
   if (output_format == NULL)
     {
       const char *dot = strrchr (output_filename, '.');
       if (dot == NULL)
-        error (1, 0, _("%s: cannot guess output format (use -O option)"),
-               output_filename);
+        {
+          error (0, 0, _("%s: cannot guess output format (use -O option)"),
+                 output_filename);
+          return false;
+        }
 
       output_format = dot + 1;
     }
 
-  output_fh = fh_create_file (NULL, output_filename, NULL, fh_default_properties ());
+  input_fh = fh_create_file (NULL, input_filename, NULL,
+                             fh_default_properties ());
+  output_fh = fh_create_file (NULL, output_filename, NULL,
+                              fh_default_properties ());
   if (encrypted_file_open (&enc, input_fh) > 0)
     {
       if (encrypted_file_is_sav (enc))
         {
           if (strcmp (output_format, "sav") && strcmp (output_format, "sys"))
-            error (1, 0, _("can only convert encrypted data file to sav or "
-                           "sys format"));
+            {
+              error (0, 0, _("can only convert encrypted data file to sav or "
+                             "sys format"));
+              encrypted_file_close (enc);
+              goto exit;
+            }
         }
       else
         {
           if (strcmp (output_format, "sps"))
-            error (1, 0, _("can only convert encrypted syntax file to sps "
-                           "format"));
+            {
+              error (0, 0, _("can only convert encrypted syntax file to sps "
+                             "format"));
+              encrypted_file_close (enc);
+              goto exit;
+            }
         }
 
-      if (! decrypt_file (enc, input_fh, output_fh, password))
-	goto error;
-
+      ok = decrypt_file (enc, input_fh, output_fh, options->password);
       goto exit;
     }
 
-
-  reader = any_reader_open_and_decode (input_fh, encoding, &dict, NULL);
+  reader = any_reader_open_and_decode (input_fh, options->encoding, &dict,
+                                       NULL);
   if (reader == NULL)
-    goto error;
+    goto exit;
 
   if (!strcmp (output_format, "csv") || !strcmp (output_format, "txt"))
     {
-      struct csv_writer_options options;
+      struct csv_writer_options csv_opts;
 
-      csv_writer_options_init (&options);
-      options.include_var_names = true;
-      writer = csv_writer_open (output_fh, dict, &options);
+      csv_writer_options_init (&csv_opts);
+      csv_opts.include_var_names = true;
+      writer = csv_writer_open (output_fh, dict, &csv_opts);
     }
   else if (!strcmp (output_format, "sav") || !strcmp (output_format, "sys"))
     {
-      struct sfm_write_options options;
+      struct sfm_write_options sfm_opts;
+
+      sfm_opts = sfm_writer_default_options ();
+      writer = sfm_open_writer (output_fh, dict, sfm_opts);
+    }
+  else if (!strcmp (output_format, "arrow")
+           || !strcmp (output_format, "feather"))
+    {
+      struct arrow_writer_options arrow_opts;
 
-      options = sfm_writer_default_options ();
-      writer = sfm_open_writer (output_fh, dict, options);
+      arrow_writer_options_init (&arrow_opts);
+      writer = arrow_writer_open (output_fh, dict, &arrow_opts);
     }
   else if (!strcmp (output_format, "por"))
     {
-      struct pfm_write_options options;
+      struct pfm_write_options pfm_opts;
 
-      options = pfm_writer_default_options ();
-      writer = pfm_open_writer (output_fh, dict, options);
+      pfm_opts = pfm_writer_default_options ();
+      writer = pfm_open_writer (output_fh, dict, pfm_opts);
     }
   else
     {
-      error (1, 0, _("%s: unknown output format (use -O option)"),
+      error (0, 0, _("%s: unknown output format (use -O option)"),
              output_filename);
-      NOT_REACHED ();
+      casereader_destroy (reader);
+      goto exit;
+    }
+  if (writer == NULL)
+    {
+      casereader_destroy (reader);
+      goto exit;
     }
 
-  for (i = 0; i < max_cases; i++)
+  for (i = 0; i < options->max_cases; i++)
     {
       struct ccase *c;
 
@@ -214,29 +397,161 @@ main (int argc, char *argv[])
 
       casewriter_write (writer, c);
     }
+  *n_cases = i;
 
+  ok = true;
   if (!casereader_destroy (reader))
-    error (1, 0, _("%s: error reading input file"), input_filename);
+    {
+      error (0, 0, _("%s: error reading input file"), input_filename);
+      ok = false;
+    }
   if (!casewriter_destroy (writer))
-    error (1, 0, _("%s: error writing output file"), output_filename);
+    {
+      error (0, 0, _("%s: error writing output file"), output_filename);
+      ok = false;
+    }
 
 exit:
   dict_destroy (dict);
   fh_unref (output_fh);
   fh_unref (input_fh);
-  fh_done ();
-  i18n_done ();
+  return ok;
+}
 
-  return 0;
+/* Carries out CONV according to OPTIONS and, if requested, reports how long
+   it took.  Returns true if successful, false on failure. */
+static bool
+run_conversion (const struct conversion *conv,
+                const struct convert_options *options)
+{
+  long long int n_cases;
+  struct timeval start;
+  double seconds, mb;
+  bool ok;
 
-error:
-  dict_destroy (dict);
-  fh_unref (output_fh);
-  fh_unref (input_fh);
-  fh_done ();
-  i18n_done ();
+  gettimeofday (&start, NULL);
+  ok = convert_file (conv->input_filename, conv->output_filename, options,
+                     &n_cases);
+  seconds = seconds_since (&start);
 
-  return 1;
+  if (ok && options->report)
+    {
+      mb = file_megabytes (conv->input_filename);
+      printf (_("%s -> %s: %lld cases, %.1f MB in %.2f s (%.1f MB/s)\n"),
+              conv->input_filename, conv->output_filename, n_cases, mb,
+              seconds, seconds > 0 ? mb / seconds : 0.0);
+      fflush (stdout);
+    }
+  return ok;
+}
+
+#if HAVE_FORK
+/* Carries out the N CONVERSIONS with up to N_JOBS of them running at a time,
+   each in a child process forked from this one, so that the work of
+   initializing PSPP is done only once.  Returns the number of conversions
+   that failed. */
+static size_t
+run_parallel (const struct conversion *conversions, size_t n, int n_jobs,
+              const struct convert_options *options)
+{
+  pid_t *pids = xnmalloc (n, sizeof *pids);
+  size_t n_failures = 0;
+  size_t next = 0;
+  int n_running = 0;
+
+  fflush (stdout);
+  fflush (stderr);
+  while (next < n || n_running > 0)
+    {
+      pid_t pid;
+      int status;
+      size_t i;
+
+      if (next < n && n_running < n_jobs)
+        {
+          pid = fork ();
+          if (pid == 0)
+            {
+              bool ok = run_conversion (&conversions[next], options);
+              exit (ok ? EXIT_SUCCESS : EXIT_FAILURE);
+            }
+          else if (pid > 0)
+            {
+              pids[next++] = pid;
+              n_running++;
+              continue;
+            }
+          else if (n_running == 0)
+            {
+              /* Can't start any child at all, so do the work here. */
+              if (!run_conversion (&conversions[next++], options))
+                n_failures++;
+              continue;
+            }
+
+          /* Otherwise wait for a child to finish, then try again. */
+        }
+
+      pid = wait (&status);
+      if (pid < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          error (1, errno, _("error waiting for child process"));
+        }
+      n_running--;
+
+      for (i = 0; i < next; i++)
+        if (pids[i] == pid)
+          break;
+      if (WIFSIGNALED (status))
+        error (0, 0, _("%s: conversion terminated by signal %d"),
+               i < next ? conversions[i].input_filename : "?",
+               WTERMSIG (status));
+      if (!WIFEXITED (status) || WEXITSTATUS (status) != EXIT_SUCCESS)
+        n_failures++;
+    }
+
+  free (pids);
+  return n_failures;
+}
+#endif
+
+/* Carries out the N CONVERSIONS according to OPTIONS, running up to N_JOBS
+   of them in parallel where the system supports it.  Returns true if all of
+   them succeeded, false if any failed. */
+static bool
+run_conversions (const struct conversion *conversions, size_t n, int n_jobs,
+                 const struct convert_options *options)
+{
+  size_t n_failures = 0;
+  struct timeval start;
+  size_t i;
+
+  gettimeofday (&start, NULL);
+#if HAVE_FORK
+  if (n_jobs > 1 && n > 1)
+    n_failures = run_parallel (conversions, n, n_jobs, options);
+  else
+#endif
+    for (i = 0; i < n; i++)
+      if (!run_conversion (&conversions[i], options))
+        n_failures++;
+
+  if (options->report)
+    {
+      double seconds = seconds_since (&start);
+      double mb = 0.0;
+
+      for (i = 0; i < n; i++)
+        mb += file_megabytes (conversions[i].input_filename);
+      printf (_("%zu files converted, %zu failed, %.1f MB in %.2f s "
+                "(%.1f MB/s)\n"),
+              n - n_failures, n_failures, mb, seconds,
+              seconds > 0 ? mb / seconds : 0.0);
+    }
+
+  return n_failures == 0;
 }
 
 static bool
@@ -250,19 +565,32 @@ decrypt_file (struct encrypted_file *enc,
   const char *input_filename = fh_get_file_name (ifh);
   const char *output_filename = fh_get_file_name (ofh);
 
+  bool ok = false;
+
   if (password == NULL)
     {
       password = getpass ("password: ");
       if (password == NULL)
-	return false;
+        {
+          encrypted_file_close (enc);
+          return false;
+        }
     }
 
   if (!encrypted_file_unlock (enc, password))
-    error (1, 0, _("sorry, wrong password"));
+    {
+      error (0, 0, _("sorry, wrong password"));
+      encrypted_file_close (enc);
+      return false;
+    }
 
   out = fn_open (ofh, "wb");
   if (out == NULL)
-    error (1, errno, ("%s: error opening output file"), output_filename);
+    {
+      error (0, errno, ("%s: error opening output file"), output_filename);
+      encrypted_file_close (enc);
+      return false;
+    }
 
   for (;;)
     {
@@ -274,18 +602,30 @@ decrypt_file (struct encrypted_file *enc,
         break;
 
       if (fwrite (buffer, 1, n, out) != n)
-        error (1, errno, ("%s: write error"), output_filename);
+        {
+          error (0, errno, ("%s: write error"), output_filename);
+          goto exit;
+        }
     }
 
+  ok = true;
+
+exit:
   err = encrypted_file_close (enc);
   if (err)
-    error (1, err, ("%s: read error"), input_filename);
+    {
+      error (0, err, ("%s: read error"), input_filename);
+      ok = false;
+    }
 
   if (fflush (out) == EOF)
-    error (1, errno, ("%s: write error"), output_filename);
+    {
+      error (0, errno, ("%s: write error"), output_filename);
+      ok = false;
+    }
   fn_close (ofh, out);
 
-  return true;
+  return ok;
 }
 
 static void
@@ -293,7 +633,7 @@ usage (void)
 {
   printf ("\
 %s, a utility for converting SPSS data files to other formats.\n\
-Usage: %s [OPTION]... INPUT OUTPUT\n\
+Usage: %s [OPTION]... INPUT OUTPUT [INPUT OUTPUT]...\n\
 where INPUT is an SPSS data file or encrypted syntax file\n\
   and OUTPUT is the name of the desired output file.\n\
 \n\
@@ -301,6 +641,7 @@ The desired format of OUTPUT is by default inferred from its extension:\n\
   csv txt             comma-separated value\n\
   sav sys             SPSS system file\n\
   por                 SPSS portable file\n\
+  arrow feather       Apache Arrow IPC file\n\
   sps                 SPSS syntax file (encrypted syntax input files only)\n\
 \n\
 Options:\n\
@@ -309,6 +650,9 @@ Options:\n\
   -e, --encoding=CHARSET  override encoding of input data file\n\
   -c MAXCASES         limit number of cases to copy (default is all cases)\n\
   -p PASSWORD         password for encrypted files\n\
+  -m, --manifest=FILE  also convert the INPUT OUTPUT pairs listed in FILE,\n\
+                      one pair per line (\"-\" to read stdin)\n\
+  -j, --jobs=N        convert up to N files at a time (default 1)\n\
   --help              display this help and exit\n\
   --version           output version information and exit\n",
           program_name, program_name);
@@ -24,6 +24,8 @@
 #include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
 
 #include "data/val-type.h"
 #include "libpspp/cast.h"
@@ -55,6 +57,7 @@ struct sfm_reader
     int n_variable_records, n_variables;
 
     int *var_widths;
+    char **var_names;
     size_t n_var_widths, allocated_var_widths;
 
     enum integer_format integer_format;
@@ -97,6 +100,7 @@ static void read_unknown_extension (struct sfm_reader *,
                                     size_t size, size_t count);
 static void read_simple_compressed_data (struct sfm_reader *, int max_cases);
 static void read_zlib_compressed_data (struct sfm_reader *);
+static void summarize_data (struct sfm_reader *);
 
 static struct text_record *open_text_record (
   struct sfm_reader *, size_t size);
@@ -131,6 +135,7 @@ int
 main (int argc, char *argv[])
 {
   int max_cases = 0;
+  bool summary = false;
   struct sfm_reader r;
   int i;
 
@@ -141,6 +146,7 @@ main (int argc, char *argv[])
       static const struct option long_options[] =
         {
           { "data",    optional_argument, NULL, 'd' },
+          { "summary", no_argument,       NULL, 's' },
           { "help",    no_argument,       NULL, 'h' },
           { "version", no_argument,       NULL, 'v' },
           { NULL,      0,                 NULL, 0 },
@@ -148,7 +154,7 @@ main (int argc, char *argv[])
 
       int c;
 
-      c = getopt_long (argc, argv, "d::hv", long_options, NULL);
+      c = getopt_long (argc, argv, "d::shv", long_options, NULL);
       if (c == -1)
         break;
 
@@ -158,6 +164,10 @@ main (int argc, char *argv[])
           max_cases = optarg ? atoi (optarg) : INT_MAX;
           break;
 
+        case 's':
+          summary = true;
+          break;
+
         case 'v':
           version_etc (stdout, "pspp-dump-sav", PACKAGE_NAME, PACKAGE_VERSION,
                        "Ben Pfaff", "John Darrington", NULL_SENTINEL);
@@ -179,6 +189,7 @@ main (int argc, char *argv[])
   for (i = optind; i < argc; i++)
     {
       int rec_type;
+      size_t j;
 
       r.file_name = argv[i];
       r.file = fopen (r.file_name, "rb");
@@ -188,7 +199,8 @@ main (int argc, char *argv[])
       r.n_variables = 0;
       r.n_var_widths = 0;
       r.allocated_var_widths = 0;
-      r.var_widths = 0;
+      r.var_widths = NULL;
+      r.var_names = NULL;
       r.compression = COMP_NONE;
 
       if (argc - optind > 1)
@@ -227,7 +239,9 @@ main (int argc, char *argv[])
               (long long int) ftello (r.file),
               (long long int) ftello (r.file) + 4);
 
-      if (r.compression == COMP_SIMPLE)
+      if (summary)
+        summarize_data (&r);
+      else if (r.compression == COMP_SIMPLE)
         {
           if (max_cases > 0)
             read_simple_compressed_data (&r, max_cases);
@@ -236,6 +250,11 @@ main (int argc, char *argv[])
         read_zlib_compressed_data (&r);
 
       fclose (r.file);
+
+      for (j = 0; j < r.n_var_widths; j++)
+        free (r.var_names[j]);
+      free (r.var_names);
+      free (r.var_widths);
     }
 
   return 0;
@@ -412,8 +431,13 @@ read_variable_record (struct sfm_reader *r)
     r->n_variables++;
 
   if (r->n_var_widths >= r->allocated_var_widths)
-    r->var_widths = x2nrealloc (r->var_widths, &r->allocated_var_widths,
-                                sizeof *r->var_widths);
+    {
+      r->var_widths = x2nrealloc (r->var_widths, &r->allocated_var_widths,
+                                  sizeof *r->var_widths);
+      r->var_names = xnrealloc (r->var_names, r->allocated_var_widths,
+                                sizeof *r->var_names);
+    }
+  r->var_names[r->n_var_widths] = xstrdup (name);
   r->var_widths[r->n_var_widths++] = width;
 
   printf ("\tWidth: %d (%s)\n",
@@ -1373,6 +1397,382 @@ read_zlib_compressed_data (struct sfm_reader *r)
     }
 }
 
+/* Source of case data for summarize_data(), which reads the data in large
+   blocks and, for ZLIB compressed files, inflates it on the fly. */
+struct data_stream
+  {
+    struct sfm_reader *r;
+    uint8_t *buffer;            /* Data not yet consumed. */
+    size_t pos, len;            /* Consumed and total bytes in buffer. */
+    long long int n_bytes;      /* Total bytes delivered so far. */
+
+    /* ZLIB compressed files only. */
+    bool zlib;
+    z_stream zstream;
+    uint8_t *zbuffer;           /* Compressed data read from the file. */
+    long long int zleft;        /* Compressed bytes not yet read. */
+  };
+
+#define DATA_BUFFER_SIZE (1024 * 1024)
+
+/* Refills S's buffer.  Returns true if successful, false at end of data. */
+static bool
+data_stream_fill (struct data_stream *s)
+{
+  struct sfm_reader *r = s->r;
+
+  if (!s->zlib)
+    {
+      s->len = fread (s->buffer, 1, DATA_BUFFER_SIZE, r->file);
+      if (ferror (r->file))
+        sys_error (r, "System error: %s.", strerror (errno));
+    }
+  else
+    {
+      s->zstream.next_out = s->buffer;
+      s->zstream.avail_out = DATA_BUFFER_SIZE;
+      while (s->zstream.avail_out > 0)
+        {
+          int retval;
+
+          if (s->zstream.avail_in == 0)
+            {
+              size_t n = MIN (DATA_BUFFER_SIZE, s->zleft);
+              if (n == 0)
+                break;
+              read_bytes (r, s->zbuffer, n);
+              s->zleft -= n;
+              s->zstream.next_in = s->zbuffer;
+              s->zstream.avail_in = n;
+            }
+
+          /* Each ZLIB block is a separate stream, so start a new stream
+             wherever one ends. */
+          retval = inflate (&s->zstream, Z_SYNC_FLUSH);
+          if (retval == Z_STREAM_END)
+            retval = inflateReset (&s->zstream);
+          if (retval != Z_OK)
+            sys_error (r, "Error inflating ZLIB compressed data (%s).",
+                       s->zstream.msg ? s->zstream.msg : "unknown error");
+        }
+      s->len = DATA_BUFFER_SIZE - s->zstream.avail_out;
+    }
+  s->pos = 0;
+  return s->len > 0;
+}
+
+/* Reads N bytes from S into BUF.  Returns true if successful, false if the
+   end of data comes before any bytes are read.  Aborts if the end of data
+   comes partway through. */
+static inline bool
+data_stream_read (struct data_stream *s, void *buf_, size_t n)
+{
+  uint8_t *buf = buf_;
+
+  if (s->len - s->pos >= n)
+    {
+      memcpy (buf, &s->buffer[s->pos], n);
+      s->pos += n;
+      s->n_bytes += n;
+      return true;
+    }
+
+  while (n > 0)
+    {
+      size_t chunk;
+
+      if (s->pos >= s->len && !data_stream_fill (s))
+        {
+          if (buf == buf_)
+            return false;
+          sys_error (s->r, "Unexpected end of file.");
+        }
+
+      chunk = MIN (n, s->len - s->pos);
+      memcpy (buf, &s->buffer[s->pos], chunk);
+      s->pos += chunk;
+      s->n_bytes += chunk;
+      buf += chunk;
+      n -= chunk;
+    }
+  return true;
+}
+
+/* Statistics for one variable, accumulated by summarize_data(). */
+struct var_summary
+  {
+    long long int n_valid;      /* Numeric values other than SYSMIS. */
+    long long int n_sysmis;     /* SYSMIS values. */
+    long long int n_spaces;     /* String values that are all spaces. */
+    long long int n_mismatches; /* Opcodes not suited to the type. */
+    double min, max, sum;       /* Of numeric values other than SYSMIS. */
+  };
+
+static void
+summarize_number (struct var_summary *vs, double value)
+{
+  if (value == SYSMIS)
+    vs->n_sysmis++;
+  else
+    {
+      vs->n_valid++;
+      vs->sum += value;
+      if (value < vs->min)
+        vs->min = value;
+      if (value > vs->max)
+        vs->max = value;
+    }
+}
+
+/* Prints a summary of the ZLIB trailer, which follows the compressed data,
+   at the current position in R. */
+static void
+summarize_zlib_trailer (struct sfm_reader *r)
+{
+  unsigned long long int total_uncmp = 0, total_cmp = 0;
+  unsigned int min_uncmp = UINT_MAX, max_uncmp = 0;
+  unsigned int min_cmp = UINT_MAX, max_cmp = 0;
+  unsigned int block_size, n_blocks;
+  unsigned int i;
+
+  printf ("\n%08llx: ZLIB trailer summary:\n",
+          (long long int) ftello (r->file));
+  read_int64 (r);               /* Bias. */
+  read_int64 (r);               /* Zero. */
+  block_size = read_int (r);
+  n_blocks = read_int (r);
+  for (i = 0; i < n_blocks; i++)
+    {
+      unsigned int uncompressed_size, compressed_size;
+
+      read_int64 (r);           /* Uncompressed offset. */
+      read_int64 (r);           /* Compressed offset. */
+      uncompressed_size = read_int (r);
+      compressed_size = read_int (r);
+
+      total_uncmp += uncompressed_size;
+      min_uncmp = MIN (min_uncmp, uncompressed_size);
+      max_uncmp = MAX (max_uncmp, uncompressed_size);
+      total_cmp += compressed_size;
+      min_cmp = MIN (min_cmp, compressed_size);
+      max_cmp = MAX (max_cmp, compressed_size);
+    }
+
+  printf ("\tBlocks: %u (block size 0x%x)\n", n_blocks, block_size);
+  if (n_blocks > 0)
+    {
+      printf ("\tUncompressed bytes: %llu (per block: min %u, max %u)\n",
+              total_uncmp, min_uncmp, max_uncmp);
+      printf ("\tCompressed bytes: %llu (per block: min %u, max %u)\n",
+              total_cmp, min_cmp, max_cmp);
+      if (total_cmp > 0)
+        printf ("\tCompression ratio: %.2f\n",
+                (double) total_uncmp / total_cmp);
+    }
+}
+
+/* Reads all of the case data in R in a single pass and prints statistics
+   for each variable and, for compressed files, a histogram of the
+   compression opcodes, without printing the data itself. */
+static void
+summarize_data (struct sfm_reader *r)
+{
+  size_t n = r->n_var_widths;
+  struct var_summary *vars;
+  size_t *heads;
+  bool *nonblank;
+  long long int opcode_counts[256];
+  long long int n_cases = 0;
+  long long int data_ofs;
+  struct data_stream s;
+  uint8_t opcodes[8];
+  int opcode_idx = 8;
+  size_t i;
+
+  read_int (r);                 /* Filler in end-of-dictionary record. */
+  data_ofs = ftello (r->file);
+
+  memset (&s, 0, sizeof s);
+  s.r = r;
+  s.buffer = xmalloc (DATA_BUFFER_SIZE);
+  if (r->compression == COMP_ZLIB)
+    {
+      long long int zheader_ofs = read_int64 (r);
+      long long int ztrailer_ofs = read_int64 (r);
+
+      read_int64 (r);           /* Trailer length. */
+      if (zheader_ofs != data_ofs || ztrailer_ofs < data_ofs + 24)
+        sys_error (r, "Invalid ZLIB data header.");
+
+      s.zlib = true;
+      s.zbuffer = xmalloc (DATA_BUFFER_SIZE);
+      s.zleft = ztrailer_ofs - (data_ofs + 24);
+      if (inflateInit (&s.zstream) != Z_OK)
+        sys_error (r, "Error initializing ZLIB decompression (%s).",
+                   s.zstream.msg ? s.zstream.msg : "unknown error");
+    }
+
+  vars = xcalloc (n, sizeof *vars);
+  heads = xnmalloc (n, sizeof *heads);
+  nonblank = xcalloc (n, sizeof *nonblank);
+  for (i = 0; i < n; i++)
+    {
+      vars[i].min = DBL_MAX;
+      vars[i].max = -DBL_MAX;
+      heads[i] = r->var_widths[i] >= 0 || i == 0 ? i : heads[i - 1];
+    }
+  memset (opcode_counts, 0, sizeof opcode_counts);
+
+  for (;;)
+    {
+      for (i = 0; i < n; )
+        {
+          struct var_summary *vs = &vars[heads[i]];
+          int width = r->var_widths[heads[i]];
+          uint8_t raw_value[8];
+          int opcode;
+
+          if (r->compression == COMP_NONE)
+            opcode = 253;
+          else
+            {
+              if (opcode_idx >= 8)
+                {
+                  if (!data_stream_read (&s, opcodes, 8))
+                    {
+                      if (i == 0)
+                        goto done;
+                      sys_error (r, "Unexpected end of file.");
+                    }
+                  opcode_idx = 0;
+                }
+              opcode = opcodes[opcode_idx++];
+              opcode_counts[opcode]++;
+            }
+
+          switch (opcode)
+            {
+            case 0:
+              continue;
+
+            case 252:
+              if (i != 0)
+                sys_warn (r, "End of data code in the middle of case %lld.",
+                          n_cases);
+              goto done;
+
+            case 253:
+              if (!data_stream_read (&s, raw_value, 8))
+                {
+                  if (i == 0)
+                    goto done;
+                  sys_error (r, "Unexpected end of file.");
+                }
+              if (width == 0)
+                summarize_number (vs, float_get_double (r->float_format,
+                                                        raw_value));
+              else if (memcmp (raw_value, "        ", 8))
+                nonblank[heads[i]] = true;
+              break;
+
+            case 254:
+              if (width == 0)
+                vs->n_mismatches++;
+              break;
+
+            case 255:
+              if (width == 0)
+                vs->n_sysmis++;
+              else
+                vs->n_mismatches++;
+              break;
+
+            default:
+              if (width == 0)
+                summarize_number (vs, opcode - r->bias);
+              else
+                vs->n_mismatches++;
+              break;
+            }
+          i++;
+        }
+
+      n_cases++;
+      for (i = 0; i < n; i++)
+        if (r->var_widths[i] > 0)
+          {
+            if (!nonblank[i])
+              vars[i].n_spaces++;
+            nonblank[i] = false;
+          }
+    }
+
+done:
+  printf ("\n%08llx: data summary:\n", data_ofs);
+  printf ("\tCases: %lld\n", n_cases);
+  printf ("\tData bytes: %lld\n", s.n_bytes);
+  if (r->compression != COMP_NONE)
+    {
+      int opcode;
+
+      printf ("\tCompression opcodes:\n");
+      for (opcode = 0; opcode < 256; opcode++)
+        if (opcode_counts[opcode])
+          {
+            printf ("\t\t%3d: %lld (", opcode, opcode_counts[opcode]);
+            switch (opcode)
+              {
+              case 0: printf ("ignored padding"); break;
+              case 252: printf ("end of data"); break;
+              case 253: printf ("uncompressible data"); break;
+              case 254: printf ("spaces"); break;
+              case 255: printf ("SYSMIS"); break;
+              default: printf ("%.*g", DBL_DIG + 1, opcode - r->bias); break;
+              }
+            printf (")\n");
+          }
+    }
+
+  printf ("\tVariables:\n");
+  for (i = 0; i < n; i++)
+    {
+      const struct var_summary *vs = &vars[i];
+      int width = r->var_widths[i];
+
+      if (width < 0)
+        continue;
+
+      printf ("\t\t%s: ", r->var_names[i]);
+      if (width == 0)
+        {
+          printf ("numeric, %lld valid", vs->n_valid);
+          if (vs->n_valid > 0)
+            printf (" (min %.*g, max %.*g, mean %.*g)",
+                    DBL_DIG + 1, vs->min, DBL_DIG + 1, vs->max,
+                    DBL_DIG + 1, vs->sum / vs->n_valid);
+          printf (", %lld SYSMIS", vs->n_sysmis);
+        }
+      else
+        printf ("string (width %d), %lld all spaces", width, vs->n_spaces);
+      if (vs->n_mismatches > 0)
+        printf (", %lld opcodes unsuited to type", vs->n_mismatches);
+      putchar ('\n');
+    }
+
+  if (s.zlib)
+    {
+      inflateEnd (&s.zstream);
+      skip_bytes (r, s.zleft);
+      summarize_zlib_trailer (r);
+      free (s.zbuffer);
+    }
+
+  free (s.buffer);
+  free (vars);
+  free (heads);
+  free (nonblank);
+}
+
 /* Helpers for reading records that consist of structured text
    strings. */
 
@@ -1527,6 +1927,8 @@ where each SYSFILE is the name of a system file.\n\
 \n\
 Options:\n\
   --data[=MAXCASES]   print (up to MAXCASES cases of) compressed data\n\
+  -s, --summary       summarize the data for each variable, without\n\
+                      printing it\n\
   --help              display this help and exit\n\
   --version           output version information and exit\n",
           program_name, program_name);